@@ -0,0 +1,340 @@
+#include "aabbtree.h"
+#include <cmath>
+
+AABBTree::AABBTree(double margin) : _margin{margin}
+{
+
+}
+
+void AABBTree::insert(Id id, const Box& box)
+{
+    if (id >= _leaves.size())
+    {
+        _leaves.resize(id + 1, NULL_NODE);
+    }
+    if (_leaves[id] != NULL_NODE)
+    {
+        update(id, box);
+        return;
+    }
+
+    const int leaf = allocateNode();
+    _nodes[leaf].id = id;
+    _nodes[leaf].box = Box(Point2(box.first.getX() - _margin, box.first.getY() - _margin),
+                           Point2(box.second.getX() + _margin, box.second.getY() + _margin));
+    _leaves[id] = leaf;
+    insertLeaf(leaf);
+}
+
+void AABBTree::update(Id id, const Box& box)
+{
+    if (id >= _leaves.size() || _leaves[id] == NULL_NODE)
+    {
+        insert(id, box);
+        return;
+    }
+
+    const int leaf = _leaves[id];
+    if (contains(_nodes[leaf].box, box))
+    {
+        // Still inside the fat box, nothing to refit
+        return;
+    }
+
+    removeLeaf(leaf);
+    _nodes[leaf].box = Box(Point2(box.first.getX() - _margin, box.first.getY() - _margin),
+                           Point2(box.second.getX() + _margin, box.second.getY() + _margin));
+    insertLeaf(leaf);
+}
+
+void AABBTree::remove(Id id)
+{
+    if (id >= _leaves.size() || _leaves[id] == NULL_NODE)
+    {
+        return;
+    }
+
+    const int leaf = _leaves[id];
+    removeLeaf(leaf);
+    freeNode(leaf);
+    _leaves[id] = NULL_NODE;
+}
+
+void AABBTree::query(const Box& region, IdList& result) const
+{
+    collect(result, [&region](const Box& box) { return overlaps(box, region); });
+}
+
+void AABBTree::queryPoint(const Point& point, IdList& result) const
+{
+    const Box region{point, point};
+    collect(result, [&region](const Box& box) { return overlaps(box, region); });
+}
+
+void AABBTree::querySegment(const Point& start, const Point& end, IdList& result) const
+{
+    collect(result, [&start, &end](const Box& box) { return segmentOverlaps(start, end, box); });
+}
+
+int AABBTree::height() const
+{
+    return _root == NULL_NODE ? 0 : _nodes[_root].height;
+}
+
+template <typename Accept>
+void AABBTree::collect(IdList& result, Accept accept) const
+{
+    result.clear();
+    if (_root == NULL_NODE)
+    {
+        return;
+    }
+
+    // The tree is kept balanced, so its height stays far below the stack size
+    int stack[128];
+    int size = 0;
+    stack[size++] = _root;
+
+    while (size > 0)
+    {
+        const Node& node = _nodes[stack[--size]];
+        if (!accept(node.box))
+        {
+            continue;
+        }
+
+        if (node.isLeaf())
+        {
+            result.push_back(node.id);
+        }
+        else
+        {
+            stack[size++] = node.left;
+            stack[size++] = node.right;
+        }
+    }
+}
+
+int AABBTree::allocateNode()
+{
+    if (_freeList == NULL_NODE)
+    {
+        _nodes.emplace_back();
+        return static_cast<int>(_nodes.size()) - 1;
+    }
+
+    const int node = _freeList;
+    _freeList = _nodes[node].parent;
+    _nodes[node] = Node();
+    return node;
+}
+
+void AABBTree::freeNode(int node)
+{
+    _nodes[node].parent = _freeList;
+    _nodes[node].height = -1;
+    _freeList = node;
+}
+
+void AABBTree::insertLeaf(int leaf)
+{
+    if (_root == NULL_NODE)
+    {
+        _root = leaf;
+        _nodes[leaf].parent = NULL_NODE;
+        return;
+    }
+
+    // Descend towards the sibling that costs the least additional perimeter
+    const Box leafBox = _nodes[leaf].box;
+    int index = _root;
+    while (!_nodes[index].isLeaf())
+    {
+        const int left = _nodes[index].left;
+        const int right = _nodes[index].right;
+
+        const double area = perimeter(_nodes[index].box);
+        const double combinedArea = perimeter(combine(_nodes[index].box, leafBox));
+
+        // Cost of creating a new parent for this node and the new leaf
+        const double cost = 2.0 * combinedArea;
+        // Minimum cost of pushing the leaf further down the tree
+        const double inheritanceCost = 2.0 * (combinedArea - area);
+
+        auto descendCost = [&](int child)
+        {
+            const double enlarged = perimeter(combine(leafBox, _nodes[child].box));
+            if (_nodes[child].isLeaf())
+                return enlarged + inheritanceCost;
+            return enlarged - perimeter(_nodes[child].box) + inheritanceCost;
+        };
+
+        const double costLeft = descendCost(left);
+        const double costRight = descendCost(right);
+
+        if (cost < costLeft && cost < costRight)
+            break;
+
+        index = costLeft < costRight ? left : right;
+    }
+
+    const int sibling = index;
+    const int oldParent = _nodes[sibling].parent;
+    const int newParent = allocateNode();
+    _nodes[newParent].parent = oldParent;
+    _nodes[newParent].box = combine(leafBox, _nodes[sibling].box);
+    _nodes[newParent].height = _nodes[sibling].height + 1;
+    _nodes[newParent].left = sibling;
+    _nodes[newParent].right = leaf;
+    _nodes[sibling].parent = newParent;
+    _nodes[leaf].parent = newParent;
+
+    if (oldParent == NULL_NODE)
+    {
+        _root = newParent;
+    }
+    else if (_nodes[oldParent].left == sibling)
+    {
+        _nodes[oldParent].left = newParent;
+    }
+    else
+    {
+        _nodes[oldParent].right = newParent;
+    }
+
+    refit(_nodes[leaf].parent);
+}
+
+void AABBTree::removeLeaf(int leaf)
+{
+    if (leaf == _root)
+    {
+        _root = NULL_NODE;
+        return;
+    }
+
+    const int parent = _nodes[leaf].parent;
+    const int grandParent = _nodes[parent].parent;
+    const int sibling = _nodes[parent].left == leaf ? _nodes[parent].right : _nodes[parent].left;
+
+    if (grandParent == NULL_NODE)
+    {
+        _root = sibling;
+        _nodes[sibling].parent = NULL_NODE;
+        freeNode(parent);
+        return;
+    }
+
+    // Replace the parent with the sibling and refit the ancestors
+    if (_nodes[grandParent].left == parent)
+    {
+        _nodes[grandParent].left = sibling;
+    }
+    else
+    {
+        _nodes[grandParent].right = sibling;
+    }
+    _nodes[sibling].parent = grandParent;
+    freeNode(parent);
+
+    refit(grandParent);
+}
+
+void AABBTree::refit(int node)
+{
+    while (node != NULL_NODE)
+    {
+        node = balance(node);
+
+        const int left = _nodes[node].left;
+        const int right = _nodes[node].right;
+        _nodes[node].height = 1 + std::max(_nodes[left].height, _nodes[right].height);
+        _nodes[node].box = combine(_nodes[left].box, _nodes[right].box);
+
+        node = _nodes[node].parent;
+    }
+}
+
+int AABBTree::balance(int a)
+{
+    // Rotates a child up when the subtree heights differ by more than one.
+    // Returns the index of the node that now takes the place of a.
+    Node& nodeA = _nodes[a];
+    if (nodeA.isLeaf() || nodeA.height < 2)
+    {
+        return a;
+    }
+
+    const int b = nodeA.left;
+    const int c = nodeA.right;
+    const int heightDifference = _nodes[c].height - _nodes[b].height;
+
+    auto rotateUp = [this, a](int up, int down, bool upWasRight)
+    {
+        // 'up' becomes the parent of 'a'; its taller child stays with it
+        Node& nodeA = _nodes[a];
+        Node& nodeUp = _nodes[up];
+        const int f = nodeUp.left;
+        const int g = nodeUp.right;
+
+        nodeUp.left = a;
+        nodeUp.parent = nodeA.parent;
+        nodeA.parent = up;
+
+        if (nodeUp.parent != NULL_NODE)
+        {
+            if (_nodes[nodeUp.parent].left == a)
+                _nodes[nodeUp.parent].left = up;
+            else
+                _nodes[nodeUp.parent].right = up;
+        }
+        else
+        {
+            _root = up;
+        }
+
+        const int keep = _nodes[f].height > _nodes[g].height ? f : g;
+        const int give = keep == f ? g : f;
+
+        nodeUp.right = keep;
+        if (upWasRight)
+            nodeA.right = give;
+        else
+            nodeA.left = give;
+        _nodes[give].parent = a;
+
+        nodeA.box = combine(_nodes[down].box, _nodes[give].box);
+        nodeA.height = 1 + std::max(_nodes[down].height, _nodes[give].height);
+        nodeUp.box = combine(nodeA.box, _nodes[keep].box);
+        nodeUp.height = 1 + std::max(nodeA.height, _nodes[keep].height);
+    };
+
+    if (heightDifference > 1)
+    {
+        rotateUp(c, b, true);
+        return c;
+    }
+    if (heightDifference < -1)
+    {
+        rotateUp(b, c, false);
+        return b;
+    }
+    return a;
+}
+
+AABBTree::Box AABBTree::combine(const Box& a, const Box& b)
+{
+    return Box(Point2(std::min(a.first.getX(), b.first.getX()), std::min(a.first.getY(), b.first.getY())),
+               Point2(std::max(a.second.getX(), b.second.getX()), std::max(a.second.getY(), b.second.getY())));
+}
+
+double AABBTree::perimeter(const Box& box)
+{
+    return 2.0 * ((box.second.getX() - box.first.getX()) + (box.second.getY() - box.first.getY()));
+}
+
+bool AABBTree::contains(const Box& outer, const Box& inner)
+{
+    return outer.first.getX() <= inner.first.getX() && outer.first.getY() <= inner.first.getY() &&
+           inner.second.getX() <= outer.second.getX() && inner.second.getY() <= outer.second.getY();
+}
@@ -0,0 +1,77 @@
+/**
+ * @file AABBTree.h
+ *
+ * @brief Defines the AABBTree class, a dynamic bounding volume hierarchy used as the Scene broadphase.
+ */
+
+#ifndef AABBTREE_H
+#define AABBTREE_H
+
+#include "broadphase.h"
+
+/**
+ * @class AABBTree
+ * @brief Dynamic binary tree of axis aligned bounding boxes.
+ *
+ * Leaves store a fattened copy of the entry box, so small movements are absorbed without
+ * touching the tree. When an entry leaves its fat box it is removed and reinserted next to
+ * the sibling that grows the tree perimeter the least, and the ancestors are refitted and
+ * rebalanced with tree rotations on the way up. Queries descend only into overlapping
+ * nodes, so their cost grows with the tree height rather than with the number of entries,
+ * independently of how much the entry sizes differ.
+ */
+class AABBTree : public Broadphase
+{
+public:
+    /**
+    * @brief Constructor for AABBTree.
+    * @param margin Distance by which the stored leaf boxes are enlarged on every side.
+    */
+    explicit AABBTree(double margin);
+
+    void insert(Id id, const Box& box) override;
+    void update(Id id, const Box& box) override;
+    void remove(Id id) override;
+
+    void query(const Box& region, IdList& result) const override;
+    void queryPoint(const Point& point, IdList& result) const override;
+    void querySegment(const Point& start, const Point& end, IdList& result) const override;
+
+    int height() const;
+
+private:
+    static constexpr int NULL_NODE = -1;
+
+    struct Node
+    {
+        Box box;
+        int parent = NULL_NODE;
+        int left = NULL_NODE;
+        int right = NULL_NODE;
+        int height = 0;
+        Id id = 0;
+
+        bool isLeaf() const { return left == NULL_NODE; }
+    };
+
+    int allocateNode();
+    void freeNode(int node);
+    void insertLeaf(int leaf);
+    void removeLeaf(int leaf);
+    void refit(int node);
+    int balance(int node);
+    template <typename Accept>
+    void collect(IdList& result, Accept accept) const;
+
+    static Box combine(const Box& a, const Box& b);
+    static double perimeter(const Box& box);
+    static bool contains(const Box& outer, const Box& inner);
+
+    double _margin;
+    int _root = NULL_NODE;
+    int _freeList = NULL_NODE;
+    std::vector<Node> _nodes;
+    std::vector<int> _leaves;
+};
+
+#endif // AABBTREE_H
@@ -0,0 +1,73 @@
+#ifndef BROADPHASE_H
+#define BROADPHASE_H
+
+#include <algorithm>
+#include <cstddef>
+#include <memory_resource>
+#include <utility>
+#include <vector>
+#include "point.h"
+
+/**
+ * @brief The Broadphase class
+ * Abstract spatial index over the bounding boxes of the Scene components. It only reports
+ * candidates whose boxes touch the query; the exact test is left to the caller.
+ */
+class Broadphase
+{
+public:
+    using Id = std::size_t;
+    using Box = std::pair<Point2, Point2>;
+    // Result list; its elements may live in a ScratchArena
+    using IdList = std::pmr::vector<Id>;
+
+    virtual ~Broadphase() = default;
+    virtual void insert(Id id, const Box& box) = 0;
+    virtual void update(Id id, const Box& box) = 0;
+    virtual void remove(Id id) = 0;
+
+    // The result vectors are cleared before they are filled and hold every id once
+    virtual void query(const Box& region, IdList& result) const = 0;
+    virtual void queryPoint(const Point& point, IdList& result) const = 0;
+    virtual void querySegment(const Point& start, const Point& end, IdList& result) const = 0;
+
+    // The box of a shape as Shape::calculateBoundingBox() gives it, in the plane of the index
+    static Box boxOf(const std::pair<Point, Point>& bounds) { return {Point2(bounds.first), Point2(bounds.second)}; }
+
+    static bool overlaps(const Box& a, const Box& b)
+    {
+        return a.first.getX() <= b.second.getX() && b.first.getX() <= a.second.getX() &&
+               a.first.getY() <= b.second.getY() && b.first.getY() <= a.second.getY();
+    }
+
+    // Slab test of the segment start-end against a box
+    static bool segmentOverlaps(const Point& start, const Point& end, const Box& box)
+    {
+        double tMin = 0.0, tMax = 1.0;
+        const double origin[2] = {start.getX(), start.getY()};
+        const double delta[2] = {end.getX() - start.getX(), end.getY() - start.getY()};
+        const double lower[2] = {box.first.getX(), box.first.getY()};
+        const double upper[2] = {box.second.getX(), box.second.getY()};
+
+        for (int axis = 0; axis < 2; ++axis)
+        {
+            if (delta[axis] == 0.0)
+            {
+                if (origin[axis] < lower[axis] || origin[axis] > upper[axis])
+                    return false;
+                continue;
+            }
+            double t1 = (lower[axis] - origin[axis]) / delta[axis];
+            double t2 = (upper[axis] - origin[axis]) / delta[axis];
+            if (t1 > t2)
+                std::swap(t1, t2);
+            tMin = std::max(tMin, t1);
+            tMax = std::min(tMax, t2);
+            if (tMin > tMax)
+                return false;
+        }
+        return true;
+    }
+};
+
+#endif // BROADPHASE_H
@@ -5,25 +5,22 @@ CircularShape::CircularShape(const Point &center, double r, double minorR) : _ce
 {
 }
 
-std::shared_ptr<Polygon> CircularShape::getBoundingRectangle() const
+Polygon CircularShape::getBoundingRectangle() const
 {
     auto [min, max] = calculateBoundingBox();
 
-    auto rect = std::make_shared<Polygon>(std::initializer_list<Point>
-                                          {
-                                              (Point(min.getX(), max.getY())),
-                                              (max),
-                                              (Point(max.getX(), min.getY())),
-                                              (min)
-                                          });
-
-    return rect;
+    return Polygon({
+                       (Point(min.getX(), max.getY())),
+                       (max),
+                       (Point(max.getX(), min.getY())),
+                       (min)
+                   });
 }
 
 std::pair<Point, Point> CircularShape::calculateBoundingBox() const
 {
 
-    Point center = _center;
+    const Point& center = _center;
     double majorRadius = radius;
     double minorRadius = _minorRadius;
 
@@ -47,9 +44,10 @@ std::pair<Point, Point> CircularShape::calculateBoundingBox() const
     return {Point(left, top),  Point(right, bottom)};
 }
 
-void CircularShape::rotate(const Point &pivot, double angle, bool clockwise)
+double CircularShape::rotate(const Point &pivot, double angle, bool clockwise)
 {
     // To be implemented
+    return 0.0;
 }
 
 void CircularShape::move(const Point &delta, double step)
@@ -57,13 +55,13 @@ void CircularShape::move(const Point &delta, double step)
     // To be implemented
 }
 
-bool CircularShape::isColliding(const std::shared_ptr<Shape> &other) const
+bool CircularShape::isColliding(const Shape &other) const
 {
     // Implementation of collision detection for CircularShape
     return false; // Replace with actual implementation
 }
 
-Point CircularShape::center() const
+const Point& CircularShape::center() const
 {
     return _center;
 }
@@ -82,3 +80,30 @@ void CircularShape::setRadius(double newRadius)
 {
     radius = newRadius;
 }
+
+double CircularShape::getMinorRadius() const
+{
+    return _minorRadius;
+}
+
+bool CircularShape::intersects(const CircularShape& other) const
+{
+    const double dx = other._center.getX() - _center.getX();
+    const double dy = other._center.getY() - _center.getY();
+    const double distance = std::sqrt(dx * dx + dy * dy);
+    if (distance == 0.0)
+    {
+        return true;
+    }
+
+    // Extent of an axis-aligned ellipse along the unit axis (ux, uy)
+    const double ux = dx / distance;
+    const double uy = dy / distance;
+    auto support = [ux, uy](const CircularShape& shape)
+    {
+        const double horizontal = shape.radius;
+        const double vertical = shape._minorRadius ? shape._minorRadius : shape.radius;
+        return std::sqrt(horizontal * horizontal * ux * ux + vertical * vertical * uy * uy);
+    };
+    return support(*this) + support(other) >= distance;
+}
@@ -12,15 +12,25 @@ class CircularShape : public Shape
 public:
     CircularShape(const Point &center, double r, double minorR = 0);
     ~CircularShape() = default;
-    std::shared_ptr<Polygon> getBoundingRectangle() const;
+    Polygon getBoundingRectangle() const;
     std::pair<Point, Point> calculateBoundingBox() const override;
-    void rotate( const Point& pivot,double angle, bool clockwise) override;
+    double rotate( const Point& pivot,double angle, bool clockwise) override;
     void move(const Point& delta, double step) override;
-    bool isColliding(const std::shared_ptr<Shape>& other) const override;
-    Point center() const;
+    bool isColliding(const Shape& other) const override;
+    const Point& center() const;
     void setCenter(Point newCenter);
     double getRadius() const;
     void setRadius(double newRadius);
+    // Vertical radius of an ellipse, or 0 for a circle; the radius is then the horizontal one
+    double getMinorRadius() const;
+    /**
+     * @brief Checks if the shape overlaps another circle or ellipse.
+     *
+     * The shapes are tested on the axis through their centers, on which each one extends by
+     * its support radius. The test is exact for two circles; two ellipses may also be kept
+     * apart by a slanted axis, so for them it can report an overlap that is not there.
+     */
+    bool intersects(const CircularShape& other) const;
 
 private:
     Point _center;
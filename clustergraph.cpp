@@ -0,0 +1,679 @@
+#include "clustergraph.h"
+#include <algorithm>
+#include <cstdlib>
+#include <functional>
+
+namespace
+{
+constexpr int DIRECTIONS = 8;
+constexpr int DX[DIRECTIONS] = {1, 0, -1, 0, 1, -1, -1, 1};
+constexpr int DY[DIRECTIONS] = {0, 1, 0, -1, 1, 1, -1, -1};
+}
+
+ClusterGraph::ClusterGraph(int clusterSize) : _clusterSize{std::max(clusterSize, 2)} {}
+
+void ClusterGraph::invalidateAll()
+{
+    _allDirty = true;
+    _dirty.clear();
+}
+
+void ClusterGraph::invalidate(const OccupancyGrid::CellRange& range)
+{
+    if (_allDirty || range.empty())
+    {
+        return;
+    }
+
+    // The entrances of a border depend on the cells on both sides of it
+    const int minX = std::max(range.minX - 1, 0) / _clusterSize;
+    const int minY = std::max(range.minY - 1, 0) / _clusterSize;
+    const int maxX = std::min(std::max(range.maxX + 1, 0) / _clusterSize, _clustersX - 1);
+    const int maxY = std::min(std::max(range.maxY + 1, 0) / _clusterSize, _clustersY - 1);
+    for (int cy = minY; cy <= maxY; ++cy)
+    {
+        for (int cx = minX; cx <= maxX; ++cx)
+        {
+            Cluster& cluster = _clusters[cy * _clustersX + cx];
+            if (!cluster.dirty)
+            {
+                cluster.dirty = true;
+                _dirty.push_back(cy * _clustersX + cx);
+            }
+        }
+    }
+}
+
+std::vector<ClusterGraph::Cell> ClusterGraph::findPath(const OccupancyGrid& grid, const Cell& start, const Cell& goal)
+{
+    _expandedNodes = 0;
+    _rebuiltClusters = 0;
+    refresh(grid);
+    if (!grid.contains(start.first, start.second) || grid.isBlocked(goal.first, goal.second))
+    {
+        return {};
+    }
+    if (start == goal)
+    {
+        return {goal};
+    }
+
+    const int width = grid.width();
+    const int startCluster = clusterOf(start.first, start.second);
+    const int goalCluster = clusterOf(goal.first, goal.second);
+    const Cluster& first = _clusters[startCluster];
+    const Cluster& last = _clusters[goalCluster];
+
+    // Links of the goal to the nodes of its cluster; the goal is free, so the costs from it
+    // are the costs to it
+    std::vector<int> goalLinks(last.cells.size(), UNREACHABLE);
+    if (last.open)
+    {
+        for (std::size_t i = 0; i < last.cells.size(); ++i)
+        {
+            goalLinks[i] = octile(last.cells[i] % width - goal.first, last.cells[i] / width - goal.second);
+        }
+    }
+    else
+    {
+        searchCluster(grid, goalCluster, goal, last.cells);
+        for (std::size_t i = 0; i < last.cells.size(); ++i)
+        {
+            goalLinks[i] = localCost(goalCluster, last.cells[i]);
+        }
+    }
+
+    const int total = _offsets.back();
+    const int startNode = total;
+    const int goalNode = total + 1;
+    if (_stamp.size() < static_cast<std::size_t>(total) + 2)
+    {
+        _cost.resize(total + 2);
+        _parent.resize(total + 2);
+        _stamp.resize(total + 2, 0);
+    }
+    if (++_generation == 0)
+    {
+        std::fill(_stamp.begin(), _stamp.end(), 0);
+        _generation = 1;
+    }
+    _open.clear();
+    _startSteps.clear();
+
+    auto cellOfNode = [&](int node)
+    {
+        if (node == startNode)
+        {
+            return start;
+        }
+        if (node == goalNode)
+        {
+            return goal;
+        }
+        const int cluster = clusterOfNode(node);
+        const int cell = _clusters[cluster].cells[node - _offsets[cluster]];
+        return Cell{cell % width, cell / width};
+    };
+    auto heuristic = [&](int cell)
+    {
+        return octile(cell % width - goal.first, cell / width - goal.second) * HEURISTIC_PERCENT / 100;
+    };
+
+    relax(startNode, 0, -1, octile(start.first - goal.first, start.second - goal.second));
+    while (!_open.empty())
+    {
+        std::pop_heap(_open.begin(), _open.end(), std::greater<>{});
+        const auto [estimate, negativeCost, node] = _open.back();
+        _open.pop_back();
+        // Stale entry, the node was reached more cheaply after it was pushed
+        const int cost = _cost[node];
+        if (-negativeCost != cost)
+        {
+            continue;
+        }
+        ++_expandedNodes;
+        if (node == goalNode)
+        {
+            break;
+        }
+
+        if (node == startNode)
+        {
+            std::vector<int> targets = first.cells;
+            if (startCluster == goalCluster)
+            {
+                targets.push_back(goal.second * width + goal.first);
+            }
+            if (first.open)
+            {
+                for (std::size_t j = 0; j < first.cells.size(); ++j)
+                {
+                    const int to = _offsets[startCluster] + static_cast<int>(j);
+                    relax(to, octile(first.cells[j] % width - start.first, first.cells[j] / width - start.second), node,
+                          heuristic(first.cells[j]));
+                }
+            }
+            else
+            {
+                searchCluster(grid, startCluster, start, targets);
+                for (std::size_t j = 0; j < first.cells.size(); ++j)
+                {
+                    const int link = localCost(startCluster, first.cells[j]);
+                    const int to = _offsets[startCluster] + static_cast<int>(j);
+                    if (link != UNREACHABLE)
+                    {
+                        relax(to, link, node, heuristic(first.cells[j]));
+                    }
+                }
+            }
+            if (startCluster == goalCluster)
+            {
+                const int link = first.open ? octile(goal.first - start.first, goal.second - start.second)
+                                            : localCost(startCluster, targets.back());
+                if (link != UNREACHABLE)
+                {
+                    relax(goalNode, link, node, 0);
+                }
+            }
+            if (grid.isBlocked(start.first, start.second))
+            {
+                linkBlockedStart(grid, start, goal, node, goalNode);
+            }
+            continue;
+        }
+
+        const int cluster = clusterOfNode(node);
+        const Cluster& current = _clusters[cluster];
+        const int i = node - _offsets[cluster];
+        const int n = static_cast<int>(current.cells.size());
+        for (int j = 0; j < n; ++j)
+        {
+            const int link = current.costs[i * n + j];
+            if (j != i && link != UNREACHABLE)
+            {
+                relax(_offsets[cluster] + j, cost + link, node, heuristic(current.cells[j]));
+            }
+        }
+
+        // Across the border to the twin node of the neighboring cluster
+        const int twin = current.twins[i];
+        const int neighbor = clusterOf(twin % width, twin / width);
+        const Cluster& other = _clusters[neighbor];
+        for (std::size_t j = 0; j < other.cells.size(); ++j)
+        {
+            if (other.cells[j] == twin && other.twins[j] == current.cells[i])
+            {
+                const int to = _offsets[neighbor] + static_cast<int>(j);
+                relax(to, cost + STRAIGHT_COST, node, heuristic(twin));
+                break;
+            }
+        }
+
+        if (cluster == goalCluster && goalLinks[i] != UNREACHABLE)
+        {
+            relax(goalNode, cost + goalLinks[i], node, 0);
+        }
+    }
+
+    if (_stamp[goalNode] != _generation)
+    {
+        return {};
+    }
+
+    std::vector<Cell> path;
+    for (int node = goalNode; node != -1; node = _parent[node])
+    {
+        path.push_back(cellOfNode(node));
+        if (_parent[node] == startNode)
+        {
+            // A link from a blocked start into a neighboring cluster goes through its first step
+            const auto via = std::find_if(_startSteps.begin(), _startSteps.end(), [node](const auto& step)
+                                          {
+                                              return step.first == node;
+                                          });
+            if (via != _startSteps.end())
+            {
+                path.push_back(via->second);
+            }
+        }
+    }
+    std::reverse(path.begin(), path.end());
+    // Nodes sharing a cell, at a cluster corner or on the start, follow each other at no cost
+    path.erase(std::unique(path.begin(), path.end()), path.end());
+    return path;
+}
+
+std::vector<ClusterGraph::Cell> ClusterGraph::refine(const OccupancyGrid& grid, const Cell& from, const Cell& to)
+{
+    refresh(grid);
+    if (!grid.contains(from.first, from.second) || grid.isBlocked(to.first, to.second))
+    {
+        return {};
+    }
+
+    const int cluster = clusterOf(from.first, from.second);
+    if (clusterOf(to.first, to.second) != cluster)
+    {
+        // Only single steps leave a cluster: between twin nodes, or out of a blocked start
+        const int dx = to.first - from.first;
+        const int dy = to.second - from.second;
+        const bool step = std::abs(dx) <= 1 && std::abs(dy) <= 1 &&
+                          (dx == 0 || dy == 0 || (!grid.isBlocked(from.first + dx, from.second) &&
+                                                  !grid.isBlocked(from.first, from.second + dy)));
+        return step ? std::vector<Cell>{to} : std::vector<Cell>{};
+    }
+
+    std::vector<Cell> cells;
+    if (_clusters[cluster].open)
+    {
+        // Diagonal steps first, then straight ones
+        Cell cell = from;
+        while (cell != to)
+        {
+            cell.first += (to.first > cell.first) - (to.first < cell.first);
+            cell.second += (to.second > cell.second) - (to.second < cell.second);
+            cells.push_back(cell);
+        }
+        return cells;
+    }
+
+    const int width = grid.width();
+    searchCluster(grid, cluster, from, {to.second * width + to.first});
+    if (localCost(cluster, to.second * width + to.first) == UNREACHABLE)
+    {
+        return {};
+    }
+
+    const auto range = rangeOf(cluster);
+    const int stride = _clusterSize + 2;
+    const int fromLocal = localIndex(cluster, from.second * width + from.first);
+    for (int local = localIndex(cluster, to.second * width + to.first); local != fromLocal; local = _localParent[local])
+    {
+        cells.emplace_back(range.minX + local % stride - 1, range.minY + local / stride - 1);
+    }
+    std::reverse(cells.begin(), cells.end());
+    return cells;
+}
+
+std::size_t ClusterGraph::nodeCount() const
+{
+    return _offsets.empty() ? 0 : static_cast<std::size_t>(_offsets.back());
+}
+
+void ClusterGraph::refresh(const OccupancyGrid& grid)
+{
+    if (grid.width() != _gridWidth || grid.height() != _gridHeight || _clusters.empty())
+    {
+        _gridWidth = grid.width();
+        _gridHeight = grid.height();
+        _clustersX = (_gridWidth + _clusterSize - 1) / _clusterSize;
+        _clustersY = (_gridHeight + _clusterSize - 1) / _clusterSize;
+        _clusters.assign(static_cast<std::size_t>(_clustersX) * _clustersY, Cluster{});
+        const std::size_t area = static_cast<std::size_t>(_clusterSize + 2) * (_clusterSize + 2);
+        _localBlocked.assign(area, 1);
+        _localCost.assign(area, 0);
+        _localParent.assign(area, -1);
+        _localStamp.assign(area, 0);
+        _localTarget.assign(area, 0);
+        _localGeneration = 0;
+        _allDirty = true;
+    }
+
+    _loadedCluster = -1;
+    if (!_allDirty && _dirty.empty())
+    {
+        return;
+    }
+
+    if (_allDirty)
+    {
+        for (int cluster = 0; cluster < static_cast<int>(_clusters.size()); ++cluster)
+        {
+            buildCluster(grid, cluster);
+        }
+        _rebuiltClusters += _clusters.size();
+    }
+    else
+    {
+        for (int cluster : _dirty)
+        {
+            buildCluster(grid, cluster);
+        }
+        _rebuiltClusters += _dirty.size();
+    }
+
+    // Node counts may have changed, so the nodes are numbered again
+    _offsets.resize(_clusters.size() + 1);
+    _offsets[0] = 0;
+    for (std::size_t cluster = 0; cluster < _clusters.size(); ++cluster)
+    {
+        _offsets[cluster + 1] = _offsets[cluster] + static_cast<int>(_clusters[cluster].cells.size());
+    }
+    _dirty.clear();
+    _allDirty = false;
+}
+
+void ClusterGraph::buildCluster(const OccupancyGrid& grid, int cluster)
+{
+    Cluster& current = _clusters[cluster];
+    current.cells.clear();
+    current.twins.clear();
+
+    const auto range = rangeOf(cluster);
+    current.open = true;
+    for (int y = range.minY; y <= range.maxY && current.open; ++y)
+    {
+        for (int x = range.minX; x <= range.maxX; ++x)
+        {
+            if (grid.isBlocked(x, y))
+            {
+                current.open = false;
+                break;
+            }
+        }
+    }
+
+    addEntrances(grid, cluster, 1, 0);
+    addEntrances(grid, cluster, -1, 0);
+    addEntrances(grid, cluster, 0, 1);
+    addEntrances(grid, cluster, 0, -1);
+
+    const int width = grid.width();
+    const int n = static_cast<int>(current.cells.size());
+    current.costs.assign(static_cast<std::size_t>(n) * n, UNREACHABLE);
+    for (int i = 0; i < n; ++i)
+    {
+        current.costs[i * n + i] = 0;
+        if (!current.open)
+        {
+            searchCluster(grid, cluster, {current.cells[i] % width, current.cells[i] / width}, current.cells);
+        }
+        // The costs are symmetric, so each search only fills the nodes after its own
+        for (int j = i + 1; j < n; ++j)
+        {
+            const int cost = current.open ? octile(current.cells[j] % width - current.cells[i] % width,
+                                                   current.cells[j] / width - current.cells[i] / width)
+                                          : localCost(cluster, current.cells[j]);
+            current.costs[i * n + j] = cost;
+            current.costs[j * n + i] = cost;
+        }
+    }
+    current.dirty = false;
+}
+
+void ClusterGraph::addEntrances(const OccupancyGrid& grid, int cluster, int dx, int dy)
+{
+    const int cx = cluster % _clustersX + dx;
+    const int cy = cluster / _clustersX + dy;
+    if (cx < 0 || cy < 0 || cx >= _clustersX || cy >= _clustersY)
+    {
+        return;
+    }
+
+    // The border is walked along t, on the side of this cluster
+    const auto range = rangeOf(cluster);
+    const bool vertical = dx != 0;
+    const int length = vertical ? range.maxY - range.minY + 1 : range.maxX - range.minX + 1;
+    auto cellAt = [&](int t)
+    {
+        if (vertical)
+        {
+            return Cell{dx > 0 ? range.maxX : range.minX, range.minY + t};
+        }
+        return Cell{range.minX + t, dy > 0 ? range.maxY : range.minY};
+    };
+    auto add = [&](int t)
+    {
+        const Cell cell = cellAt(t);
+        _clusters[cluster].cells.push_back(grid.index(cell.first, cell.second));
+        _clusters[cluster].twins.push_back(grid.index(cell.first + dx, cell.second + dy));
+    };
+
+    int runStart = -1;
+    for (int t = 0; t <= length; ++t)
+    {
+        bool free = false;
+        if (t < length)
+        {
+            const Cell cell = cellAt(t);
+            free = !grid.isBlocked(cell.first, cell.second) && !grid.isBlocked(cell.first + dx, cell.second + dy);
+        }
+        if (free && runStart < 0)
+        {
+            runStart = t;
+        }
+        else if (!free && runStart >= 0)
+        {
+            // Both clusters walk the same run and pick the same crossings
+            const int runEnd = t - 1;
+            if (runEnd - runStart + 1 < LONG_ENTRANCE)
+            {
+                add((runStart + runEnd) / 2);
+            }
+            else
+            {
+                add(runStart);
+                add(runEnd);
+            }
+            runStart = -1;
+        }
+    }
+}
+
+OccupancyGrid::CellRange ClusterGraph::rangeOf(int cluster) const
+{
+    const int x = cluster % _clustersX * _clusterSize;
+    const int y = cluster / _clustersX * _clusterSize;
+    return {x, y, std::min(x + _clusterSize, _gridWidth) - 1, std::min(y + _clusterSize, _gridHeight) - 1};
+}
+
+int ClusterGraph::clusterOf(int x, int y) const
+{
+    return y / _clusterSize * _clustersX + x / _clusterSize;
+}
+
+int ClusterGraph::clusterOfNode(int node) const
+{
+    // Clusters without nodes share their offset with the next one
+    return static_cast<int>(std::upper_bound(_offsets.begin(), _offsets.end(), node) - _offsets.begin()) - 1;
+}
+
+void ClusterGraph::loadCluster(const OccupancyGrid& grid, int cluster)
+{
+    if (cluster == _loadedCluster)
+    {
+        return;
+    }
+
+    // Cells outside the cluster, the padding ring included, count as blocked
+    const auto range = rangeOf(cluster);
+    const int stride = _clusterSize + 2;
+    std::fill(_localBlocked.begin(), _localBlocked.end(), 1);
+    for (int y = range.minY; y <= range.maxY; ++y)
+    {
+        for (int x = range.minX; x <= range.maxX; ++x)
+        {
+            _localBlocked[(y - range.minY + 1) * stride + x - range.minX + 1] = grid.isBlocked(x, y);
+        }
+    }
+    _loadedCluster = cluster;
+}
+
+void ClusterGraph::searchCluster(const OccupancyGrid& grid, int cluster, const Cell& start, const std::vector<int>& targets)
+{
+    loadCluster(grid, cluster);
+    const int stride = _clusterSize + 2;
+    const int offsets[DIRECTIONS] = {1, stride, -1, -stride, stride + 1, stride - 1, -stride - 1, -stride + 1};
+
+    if (++_localGeneration == 0)
+    {
+        std::fill(_localStamp.begin(), _localStamp.end(), 0);
+        std::fill(_localTarget.begin(), _localTarget.end(), 0);
+        _localGeneration = 1;
+    }
+
+    int remaining = 0;
+    for (int target : targets)
+    {
+        const int id = localIndex(cluster, target);
+        if (_localTarget[id] != _localGeneration)
+        {
+            _localTarget[id] = _localGeneration;
+            ++remaining;
+        }
+    }
+
+    for (auto& bucket : _buckets)
+    {
+        bucket.clear();
+    }
+    const int startId = localIndex(cluster, start.second * grid.width() + start.first);
+    _localStamp[startId] = _localGeneration;
+    _localCost[startId] = 0;
+    _localParent[startId] = -1;
+    _buckets[0].push_back(startId);
+    std::size_t pending = 1;
+
+    // Dial's algorithm: the step costs are small integers, so a ring of buckets indexed by cost
+    // replaces the heap; a step never lands in the bucket being scanned
+    for (int cost = 0; pending > 0 && remaining > 0; ++cost)
+    {
+        auto& bucket = _buckets[cost % BUCKETS];
+        for (std::size_t k = 0; k < bucket.size() && remaining > 0; ++k)
+        {
+            const int id = bucket[k];
+            // Stale entry, the cell was reached more cheaply after it was pushed
+            if (_localCost[id] != cost)
+            {
+                continue;
+            }
+            if (_localTarget[id] == _localGeneration)
+            {
+                // Settled: cleared so that a second entry of the same cell is not counted again
+                _localTarget[id] = 0;
+                --remaining;
+            }
+
+            for (int direction = 0; direction < DIRECTIONS; ++direction)
+            {
+                const int neighbor = id + offsets[direction];
+                if (_localBlocked[neighbor])
+                {
+                    continue;
+                }
+
+                const bool diagonal = direction >= 4;
+                // No corner cutting, as in PathFinding
+                if (diagonal && (_localBlocked[id + DX[direction]] || _localBlocked[id + DY[direction] * stride]))
+                {
+                    continue;
+                }
+
+                const int newCost = cost + (diagonal ? DIAGONAL_COST : STRAIGHT_COST);
+                if (_localStamp[neighbor] == _localGeneration && newCost >= _localCost[neighbor])
+                {
+                    continue;
+                }
+                _localStamp[neighbor] = _localGeneration;
+                _localCost[neighbor] = newCost;
+                _localParent[neighbor] = id;
+                _buckets[newCost % BUCKETS].push_back(neighbor);
+                ++pending;
+            }
+        }
+        pending -= bucket.size();
+        bucket.clear();
+    }
+}
+
+int ClusterGraph::localIndex(int cluster, int cell) const
+{
+    const auto range = rangeOf(cluster);
+    return (cell / _gridWidth - range.minY + 1) * (_clusterSize + 2) + cell % _gridWidth - range.minX + 1;
+}
+
+int ClusterGraph::localCost(int cluster, int cell) const
+{
+    const int id = localIndex(cluster, cell);
+    return _localStamp[id] == _localGeneration ? _localCost[id] : UNREACHABLE;
+}
+
+void ClusterGraph::linkBlockedStart(const OccupancyGrid& grid, const Cell& start, const Cell& goal, int startNode, int goalNode)
+{
+    const int width = grid.width();
+    const int startCluster = clusterOf(start.first, start.second);
+    const int goalCluster = clusterOf(goal.first, goal.second);
+    for (int direction = 0; direction < DIRECTIONS; ++direction)
+    {
+        const Cell step{start.first + DX[direction], start.second + DY[direction]};
+        const bool diagonal = direction >= 4;
+        if (grid.isBlocked(step.first, step.second) ||
+            (diagonal && (grid.isBlocked(step.first, start.second) || grid.isBlocked(start.first, step.second))))
+        {
+            continue;
+        }
+        const int cluster = clusterOf(step.first, step.second);
+        if (cluster == startCluster)
+        {
+            continue;
+        }
+
+        const Cluster& next = _clusters[cluster];
+        std::vector<int> targets = next.cells;
+        if (cluster == goalCluster)
+        {
+            targets.push_back(goal.second * width + goal.first);
+        }
+        if (!next.open)
+        {
+            searchCluster(grid, cluster, step, targets);
+        }
+        auto link = [&](int cell)
+        {
+            return next.open ? octile(cell % width - step.first, cell / width - step.second) : localCost(cluster, cell);
+        };
+
+        const int stepCost = diagonal ? DIAGONAL_COST : STRAIGHT_COST;
+        for (std::size_t j = 0; j < next.cells.size(); ++j)
+        {
+            const int cost = link(next.cells[j]);
+            const int to = _offsets[cluster] + static_cast<int>(j);
+            const int cell = next.cells[j];
+            if (cost != UNREACHABLE &&
+                relax(to, stepCost + cost, startNode, octile(cell % width - goal.first, cell / width - goal.second)))
+            {
+                _startSteps.emplace_back(to, step);
+            }
+        }
+        if (cluster == goalCluster)
+        {
+            const int cost = link(targets.back());
+            if (cost != UNREACHABLE && relax(goalNode, stepCost + cost, startNode, 0))
+            {
+                _startSteps.emplace_back(goalNode, step);
+            }
+        }
+    }
+}
+
+bool ClusterGraph::relax(int node, int cost, int parent, int heuristic)
+{
+    if (_stamp[node] == _generation && cost >= _cost[node])
+    {
+        return false;
+    }
+
+    _stamp[node] = _generation;
+    _cost[node] = cost;
+    _parent[node] = parent;
+    _open.emplace_back(cost + heuristic, -cost, node);
+    std::push_heap(_open.begin(), _open.end(), std::greater<>{});
+    return true;
+}
+
+int ClusterGraph::octile(int dx, int dy)
+{
+    dx = std::abs(dx);
+    dy = std::abs(dy);
+    return STRAIGHT_COST * std::max(dx, dy) + (DIAGONAL_COST - STRAIGHT_COST) * std::min(dx, dy);
+}
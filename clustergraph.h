@@ -0,0 +1,161 @@
+/**
+ * @file ClusterGraph.h
+ *
+ * @brief Defines the ClusterGraph class, the hierarchical (HPA*) planner used by PathFinding.
+ */
+
+#ifndef CLUSTERGRAPH_H
+#define CLUSTERGRAPH_H
+
+#include <array>
+#include <cstdint>
+#include <tuple>
+#include <utility>
+#include <vector>
+#include "occupancygrid.h"
+
+/**
+ * @class ClusterGraph
+ * @brief Abstract graph of an OccupancyGrid for hierarchical path finding (HPA*).
+ *
+ * The grid is cut into square clusters. Along the border of two neighboring clusters every
+ * run of cells that is free on both sides forms an entrance, crossed at its middle when it
+ * is short and at both ends otherwise. The cells next to those crossings are the nodes of the
+ * graph: a node is linked to its twin across the border by a straight step, and to the other
+ * nodes of its cluster by the cost of the shortest path that stays inside the cluster.
+ *
+ * A query links the start and the goal to the nodes of their clusters and runs A* on that
+ * small graph; the result is a list of nodes, and each hop between two of them is turned
+ * into grid cells only when the caller asks for it with refine(). When cells change, only
+ * the clusters they touch are marked dirty and rebuilt before the next query.
+ */
+class ClusterGraph
+{
+public:
+    using Cell = std::pair<int, int>;
+
+    explicit ClusterGraph(int clusterSize = 32);
+
+    // Marks every cluster for rebuilding, after the grid was rasterized from scratch
+    void invalidateAll();
+    // Marks the clusters whose entrances or inner paths depend on the cells of the range
+    void invalidate(const OccupancyGrid::CellRange& range);
+
+    /**
+    * @brief Searches the abstract graph between two cells of the grid.
+    *
+    * Dirty clusters are rebuilt first. The start cell may be blocked; the goal must be free.
+    * Paths may only cross cluster borders through entrances and the A* estimate is weighted,
+    * so they can be slightly longer than the optimal grid path.
+    *
+    * @return The start, the entrance cells the path goes through and the goal (only the goal
+    *         if it is the start), or an empty vector if the goal cannot be reached.
+    */
+    std::vector<Cell> findPath(const OccupancyGrid& grid, const Cell& start, const Cell& goal);
+
+    /**
+    * @brief Turns one hop of an abstract path into grid cells.
+    * @param from, to Consecutive cells of a path returned by findPath().
+    * @return The cells after from up to to, or an empty vector if they are not linked.
+    */
+    std::vector<Cell> refine(const OccupancyGrid& grid, const Cell& from, const Cell& to);
+
+    int clusterSize() const { return _clusterSize; }
+    std::size_t clusterCount() const { return _clusters.size(); }
+    std::size_t nodeCount() const;
+    // Number of clusters rebuilt before the last query
+    std::size_t rebuiltClusters() const { return _rebuiltClusters; }
+    // Number of abstract nodes expanded by the last query
+    std::size_t expandedNodes() const { return _expandedNodes; }
+
+private:
+    struct Cluster
+    {
+        // Grid cell id of each node and of its twin across the border
+        std::vector<int> cells;
+        std::vector<int> twins;
+        // Cost between each pair of nodes inside the cluster, row-major, UNREACHABLE if none
+        std::vector<int> costs;
+        // No blocked cell: costs are octile distances and paths straight lines
+        bool open = false;
+        bool dirty = true;
+    };
+
+    // Resizes the cluster array to the grid and rebuilds the dirty clusters
+    void refresh(const OccupancyGrid& grid);
+    void buildCluster(const OccupancyGrid& grid, int cluster);
+    // Adds the crossings of the border between a cluster and its neighbor at offset (dx, dy)
+    void addEntrances(const OccupancyGrid& grid, int cluster, int dx, int dy);
+    OccupancyGrid::CellRange rangeOf(int cluster) const;
+    int clusterOf(int x, int y) const;
+    int clusterOfNode(int node) const;
+    // Copies the blocked cells of a cluster into the local mask, unless it is already there
+    void loadCluster(const OccupancyGrid& grid, int cluster);
+    /**
+    * @brief Dijkstra over the free cells of a cluster.
+    *
+    * Stops once every target has been reached; the costs are then read with localCost().
+    */
+    void searchCluster(const OccupancyGrid& grid, int cluster, const Cell& start, const std::vector<int>& targets);
+    // Index of a grid cell in the local arrays of its cluster
+    int localIndex(int cluster, int cell) const;
+    // Cost from the start of the last searchCluster() to a cell, UNREACHABLE if not reached
+    int localCost(int cluster, int cell) const;
+    /**
+    * @brief Links a blocked start to the clusters next to it.
+    *
+    * A piece can leave a blocked cell by a single step in any direction, so that step may
+    * cross the cluster border where there is no entrance.
+    */
+    void linkBlockedStart(const OccupancyGrid& grid, const Cell& start, const Cell& goal, int startNode, int goalNode);
+    // Returns false if the node already has a cheaper cost
+    bool relax(int node, int cost, int parent, int heuristic);
+
+    static int octile(int dx, int dy);
+
+    static constexpr int STRAIGHT_COST = 10;
+    static constexpr int DIAGONAL_COST = 14;
+    static constexpr int UNREACHABLE = INT32_MAX;
+    // Entrances at least this long are crossed at both ends instead of the middle
+    static constexpr int LONG_ENTRANCE = 6;
+    // Weight of the abstract heuristic: the abstract path is already approximate, and a slightly
+    // greedy search stops exploring the many entrances whose estimates differ by a few cells
+    static constexpr int HEURISTIC_PERCENT = 110;
+    // Cost buckets of the searches inside a cluster, more than the largest step cost
+    static constexpr int BUCKETS = 16;
+
+    int _clusterSize;
+    int _gridWidth = 0;
+    int _gridHeight = 0;
+    int _clustersX = 0;
+    int _clustersY = 0;
+    std::vector<Cluster> _clusters;
+    std::vector<int> _dirty;
+    bool _allDirty = true;
+    // Index of the first node of each cluster in the abstract search arrays, plus the total
+    std::vector<int> _offsets;
+    std::size_t _rebuiltClusters = 0;
+    std::size_t _expandedNodes = 0;
+
+    // Search inside one cluster, over a copy of its cells padded by a ring of blocked ones
+    std::vector<std::uint8_t> _localBlocked;
+    int _loadedCluster = -1;
+    std::array<std::vector<int>, BUCKETS> _buckets;
+    std::vector<int> _localCost;
+    std::vector<int> _localParent;
+    std::vector<std::uint32_t> _localStamp;
+    std::vector<std::uint32_t> _localTarget;
+    std::uint32_t _localGeneration = 0;
+
+    // Search of the abstract graph, the start and the goal come after the cluster nodes; the
+    // open list is ordered by estimate, then towards the nodes farther from the start
+    std::vector<std::tuple<int, int, int>> _open;
+    std::vector<int> _cost;
+    std::vector<int> _parent;
+    std::vector<std::uint32_t> _stamp;
+    std::uint32_t _generation = 0;
+    // Nodes linked to a blocked start through a step into their cluster, with that step
+    std::vector<std::pair<int, Cell>> _startSteps;
+};
+
+#endif // CLUSTERGRAPH_H
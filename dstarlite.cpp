@@ -0,0 +1,242 @@
+#include "dstarlite.h"
+#include <algorithm>
+#include <cstdlib>
+#include <functional>
+
+namespace
+{
+constexpr int DIRECTIONS = 8;
+constexpr int DX[DIRECTIONS] = {1, 0, -1, 0, 1, -1, -1, 1};
+constexpr int DY[DIRECTIONS] = {0, 1, 0, -1, 1, 1, -1, -1};
+}
+
+std::vector<int> DStarLite::plan(const OccupancyGrid& grid, const Cell& start, const Cell& goal,
+                                 const std::vector<int>& changedCells)
+{
+    _expandedNodes = 0;
+    const int startId = grid.index(start.first, start.second);
+    const int goalId = grid.index(goal.first, goal.second);
+    if (goalId != _goal || grid.width() != _width || grid.height() != _height)
+    {
+        initialize(grid, startId, goalId);
+    }
+    else
+    {
+        // The keys queued so far used the old start; km keeps them lower bounds
+        if (startId != _start)
+        {
+            const int previous = _start;
+            _km += heuristic(previous, startId);
+            _start = startId;
+            // Only a blocked start may be left, so both cells change their outgoing steps
+            if (grid.isBlocked(previous % _width, previous / _width))
+            {
+                updateVertex(grid, previous);
+            }
+            if (grid.isBlocked(start.first, start.second))
+            {
+                updateVertex(grid, startId);
+            }
+        }
+
+        // A cell changes the steps into it and the diagonal steps around its corners, all
+        // of which leave from the cell itself or one of its neighbors
+        for (int cell : changedCells)
+        {
+            const int x = cell % _width;
+            const int y = cell / _width;
+            updateVertex(grid, cell);
+            for (int direction = 0; direction < DIRECTIONS; ++direction)
+            {
+                if (grid.contains(x + DX[direction], y + DY[direction]))
+                {
+                    updateVertex(grid, grid.index(x + DX[direction], y + DY[direction]));
+                }
+            }
+        }
+    }
+
+    computeShortestPath(grid);
+    if (_g[_start] >= UNREACHABLE)
+    {
+        return {};
+    }
+
+    // Greedy descent of the distances to the goal
+    std::vector<int> path{_start};
+    for (int cell = _start; cell != _goal;)
+    {
+        int best = -1;
+        int bestCost = UNREACHABLE;
+        for (int direction = 0; direction < DIRECTIONS; ++direction)
+        {
+            const int step = cost(grid, cell, direction);
+            if (step >= UNREACHABLE)
+            {
+                continue;
+            }
+            const int next = cell + DY[direction] * _width + DX[direction];
+            if (step + _g[next] < bestCost)
+            {
+                bestCost = step + _g[next];
+                best = next;
+            }
+        }
+        if (best < 0 || path.size() > _g.size())
+        {
+            return {};
+        }
+        path.push_back(best);
+        cell = best;
+    }
+    return path;
+}
+
+void DStarLite::initialize(const OccupancyGrid& grid, int start, int goal)
+{
+    _width = grid.width();
+    _height = grid.height();
+    _start = start;
+    _goal = goal;
+    _km = 0;
+    const std::size_t cellCount = grid.cellCount();
+    _g.assign(cellCount, UNREACHABLE);
+    _rhs.assign(cellCount, UNREACHABLE);
+    _keys.assign(cellCount, {0, 0});
+    _queued.assign(cellCount, 0);
+    _open.clear();
+
+    _rhs[goal] = 0;
+    _keys[goal] = calculateKey(goal);
+    _queued[goal] = 1;
+    _open.emplace_back(_keys[goal].first, _keys[goal].second, goal);
+}
+
+DStarLite::Key DStarLite::calculateKey(int cell) const
+{
+    const int distance = std::min(_g[cell], _rhs[cell]);
+    return {distance + heuristic(_start, cell) + _km, distance};
+}
+
+int DStarLite::heuristic(int from, int to) const
+{
+    const int dx = std::abs(from % _width - to % _width);
+    const int dy = std::abs(from / _width - to / _width);
+    return STRAIGHT_COST * std::max(dx, dy) + (DIAGONAL_COST - STRAIGHT_COST) * std::min(dx, dy);
+}
+
+int DStarLite::cost(const OccupancyGrid& grid, int cell, int direction) const
+{
+    const int x = cell % _width;
+    const int y = cell / _width;
+    const int nx = x + DX[direction];
+    const int ny = y + DY[direction];
+    if (grid.isBlocked(nx, ny) || (cell != _start && grid.isBlocked(x, y)))
+    {
+        return UNREACHABLE;
+    }
+
+    const bool diagonal = direction >= 4;
+    // No corner cutting, as in PathFinding
+    if (diagonal && (grid.isBlocked(nx, y) || grid.isBlocked(x, ny)))
+    {
+        return UNREACHABLE;
+    }
+    return diagonal ? DIAGONAL_COST : STRAIGHT_COST;
+}
+
+void DStarLite::updateVertex(const OccupancyGrid& grid, int cell)
+{
+    if (cell != _goal)
+    {
+        int best = UNREACHABLE;
+        for (int direction = 0; direction < DIRECTIONS; ++direction)
+        {
+            const int step = cost(grid, cell, direction);
+            if (step < UNREACHABLE)
+            {
+                best = std::min(best, step + _g[cell + DY[direction] * _width + DX[direction]]);
+            }
+        }
+        _rhs[cell] = std::min(best, UNREACHABLE);
+    }
+
+    if (_g[cell] != _rhs[cell])
+    {
+        const Key key = calculateKey(cell);
+        if (_queued[cell] && _keys[cell] == key)
+        {
+            return;
+        }
+        _keys[cell] = key;
+        _queued[cell] = 1;
+        _open.emplace_back(_keys[cell].first, _keys[cell].second, cell);
+        std::push_heap(_open.begin(), _open.end(), std::greater<>{});
+    }
+    else
+    {
+        _queued[cell] = 0;
+    }
+}
+
+void DStarLite::computeShortestPath(const OccupancyGrid& grid)
+{
+    for (discardStale(); !_open.empty(); discardStale())
+    {
+        const auto [first, second, cell] = _open.front();
+        const Key top{first, second};
+        if (top >= calculateKey(_start) && _rhs[_start] == _g[_start])
+        {
+            break;
+        }
+
+        std::pop_heap(_open.begin(), _open.end(), std::greater<>{});
+        _open.pop_back();
+        _queued[cell] = 0;
+
+        const Key current = calculateKey(cell);
+        if (top < current)
+        {
+            // Queued before the start moved: pushed back with its up-to-date key
+            _keys[cell] = current;
+            _queued[cell] = 1;
+            _open.emplace_back(current.first, current.second, cell);
+            std::push_heap(_open.begin(), _open.end(), std::greater<>{});
+            continue;
+        }
+
+        ++_expandedNodes;
+        const int x = cell % _width;
+        const int y = cell / _width;
+        if (_g[cell] > _rhs[cell])
+        {
+            _g[cell] = _rhs[cell];
+        }
+        else
+        {
+            _g[cell] = UNREACHABLE;
+            updateVertex(grid, cell);
+        }
+        for (int direction = 0; direction < DIRECTIONS; ++direction)
+        {
+            if (grid.contains(x + DX[direction], y + DY[direction]))
+            {
+                updateVertex(grid, grid.index(x + DX[direction], y + DY[direction]));
+            }
+        }
+    }
+}
+
+void DStarLite::discardStale()
+{
+    while (!_open.empty())
+    {
+        const auto [first, second, cell] = _open.front();
+        if (_queued[cell] && _keys[cell] == Key{first, second})
+        {
+            return;
+        }
+        std::pop_heap(_open.begin(), _open.end(), std::greater<>{});
+        _open.pop_back();
+    }
+}
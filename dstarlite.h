@@ -0,0 +1,87 @@
+/**
+ * @file DStarLite.h
+ *
+ * @brief Defines the DStarLite class, the incremental planner used by PathFinding.
+ */
+
+#ifndef DSTARLITE_H
+#define DSTARLITE_H
+
+#include <cstdint>
+#include <tuple>
+#include <utility>
+#include <vector>
+#include "occupancygrid.h"
+
+/**
+ * @class DStarLite
+ * @brief Incremental shortest paths on an OccupancyGrid (D* Lite, Koenig and Likhachev).
+ *
+ * The search runs backwards from the goal, so the costs it keeps are distances to the goal
+ * and stay valid while the start moves along the path. When cells of the grid change, only
+ * the cells whose distance depends on them are put back on the open list; a replan after a
+ * local change expands a small fraction of the cells a new A* search would. The open list is
+ * ordered by the usual pair of keys, with the key modifier km absorbing the moves of the
+ * start instead of reordering the list.
+ *
+ * Moves are 8-connected with the costs and the no-corner-cutting rule of PathFinding; a
+ * blocked start may still be left.
+ */
+class DStarLite
+{
+public:
+    using Cell = std::pair<int, int>;
+
+    DStarLite() = default;
+
+    /**
+    * @brief Repairs the search and returns the shortest path from the start to the goal.
+    *
+    * The search is started over when the goal or the size of the grid changes; otherwise the
+    * previous search tree is reused, the start is moved and the changed cells are repaired.
+    *
+    * @param grid The grid, already updated.
+    * @param start The current cell of the piece.
+    * @param goal The goal cell.
+    * @param changedCells Ids of the cells whose blocked state changed since the last call.
+    * @return The cell ids from the start to the goal, or an empty vector if the goal cannot be reached.
+    */
+    std::vector<int> plan(const OccupancyGrid& grid, const Cell& start, const Cell& goal, const std::vector<int>& changedCells);
+
+    // Number of cells expanded by the last plan
+    std::size_t expandedNodes() const { return _expandedNodes; }
+
+private:
+    using Key = std::pair<int, int>;
+
+    void initialize(const OccupancyGrid& grid, int start, int goal);
+    Key calculateKey(int cell) const;
+    int heuristic(int from, int to) const;
+    // Cost of the step from a cell in one direction, UNREACHABLE if it is not allowed
+    int cost(const OccupancyGrid& grid, int cell, int direction) const;
+    // Recomputes the one-step lookahead of a cell and queues it if it became inconsistent
+    void updateVertex(const OccupancyGrid& grid, int cell);
+    void computeShortestPath(const OccupancyGrid& grid);
+    // Drops the outdated entries from the top of the open list
+    void discardStale();
+
+    // Large enough for any path, small enough to add two of them
+    static constexpr int UNREACHABLE = 1 << 29;
+    static constexpr int STRAIGHT_COST = 10;
+    static constexpr int DIAGONAL_COST = 14;
+
+    int _width = 0;
+    int _height = 0;
+    int _start = -1;
+    int _goal = -1;
+    int _km = 0;
+    std::vector<int> _g;
+    std::vector<int> _rhs;
+    // Key of each queued cell; heap entries with another key are outdated
+    std::vector<Key> _keys;
+    std::vector<std::uint8_t> _queued;
+    std::vector<std::tuple<int, int, int>> _open;
+    std::size_t _expandedNodes = 0;
+};
+
+#endif // DSTARLITE_H
@@ -0,0 +1,52 @@
+# The game engine, shared by the game and the tests
+INCLUDEPATH += $$PWD
+
+SOURCES += \
+        $$PWD/aabbtree.cpp \
+        $$PWD/circularshape.cpp \
+        $$PWD/clustergraph.cpp \
+        $$PWD/dstarlite.cpp \
+        $$PWD/flowfield.cpp \
+        $$PWD/game.cpp \
+        $$PWD/islandscheduler.cpp \
+        $$PWD/node.cpp \
+        $$PWD/occupancygrid.cpp \
+        $$PWD/pathfinding.cpp \
+        $$PWD/point.cpp \
+        $$PWD/polygon.cpp \
+        $$PWD/reservationtable.cpp \
+        $$PWD/satkernel.cpp \
+        $$PWD/scene.cpp \
+        $$PWD/scratcharena.cpp \
+        $$PWD/shape.cpp \
+        $$PWD/spatialgrid.cpp \
+        $$PWD/sweepandprune.cpp \
+        $$PWD/threadpool.cpp \
+        $$PWD/visibilitygraph.cpp
+
+HEADERS += \
+    $$PWD/aabbtree.h \
+    $$PWD/broadphase.h \
+    $$PWD/circularshape.h \
+    $$PWD/clustergraph.h \
+    $$PWD/dstarlite.h \
+    $$PWD/fixedpolygon.h \
+    $$PWD/flowfield.h \
+    $$PWD/game.h \
+    $$PWD/islandscheduler.h \
+    $$PWD/node.h \
+    $$PWD/occupancygrid.h \
+    $$PWD/pathfinding.h \
+    $$PWD/point.h \
+    $$PWD/polygon.h \
+    $$PWD/reservationtable.h \
+    $$PWD/satkernel.h \
+    $$PWD/scene.h \
+    $$PWD/scratcharena.h \
+    $$PWD/shape.h \
+    $$PWD/shapepool.h \
+    $$PWD/spatialgrid.h \
+    $$PWD/sweepandprune.h \
+    $$PWD/threadpool.h \
+    $$PWD/triplebuffer.h \
+    $$PWD/visibilitygraph.h
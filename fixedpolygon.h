@@ -0,0 +1,163 @@
+/**
+ * @file FixedPolygon.h
+ *
+ * @brief Defines the FixedPolygon class template, a convex polygon whose number of vertices is known at compile time.
+ */
+
+#ifndef FIXEDPOLYGON_H
+#define FIXEDPOLYGON_H
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <limits>
+#include <utility>
+
+// Vertex counts for which the FixedPolygon kernels exist
+constexpr std::size_t FIXED_POLYGON_MIN_VERTICES = 3;
+constexpr std::size_t FIXED_POLYGON_MAX_VERTICES = 8;
+
+/**
+ * @brief Columns of a polygon in its local frame, laid out as Polygon stores them: the vertices,
+ *        the edge normals and the projection of the polygon on each normal.
+ */
+struct PolygonColumns
+{
+    const double* xs;
+    const double* ys;
+    const double* normalsX;
+    const double* normalsY;
+    const double* selfMin;
+    const double* selfMax;
+};
+
+// Rotation and translation placing the vertices of a polygon in the local frame of another one
+struct PolygonPose
+{
+    double cosTheta = 1.0;
+    double sinTheta = 0.0;
+    double centerX = 0.0;
+    double centerY = 0.0;
+};
+
+/**
+ * @class FixedPolygon
+ * @brief Convex polygon of N vertices stored in std::array, with a separating axis test unrolled for N.
+ *
+ * The loops over the vertices and the axes are expanded at compile time, so a test runs without
+ * loop counters, heap or scratch memory. Everything is constexpr, which lets static_assert check
+ * the test on literal polygons.
+ *
+ * The static kernels work on PolygonColumns, so a Polygon of FIXED_POLYGON_MIN_VERTICES to
+ * FIXED_POLYGON_MAX_VERTICES vertices runs them on its own columns, picked by its vertex count.
+ * They repeat the arithmetic of Polygon::projectPosed() and SatKernel operation by operation,
+ * so the fixed and the generic paths give the same results.
+ */
+template<std::size_t N>
+class FixedPolygon
+{
+    static_assert(N >= FIXED_POLYGON_MIN_VERTICES && N <= FIXED_POLYGON_MAX_VERTICES,
+                  "FixedPolygon covers 3 to 8 vertices");
+
+public:
+    /**
+    * @brief Constructor for FixedPolygon.
+    *
+    * The edge normals are left unnormalized, since the separating axis test only compares
+    * projections on the same axis; Polygon passes its unit normals to the kernels instead.
+    *
+    * @param xs, ys Coordinates of the vertices, in order around the polygon.
+    */
+    constexpr FixedPolygon(const std::array<double, N>& xs, const std::array<double, N>& ys) : _xs {xs}, _ys {ys}
+    {
+        for (std::size_t i = 0; i < N; ++i)
+        {
+            const std::size_t next = (i + 1) % N;
+            _normalsX[i] = _ys[next] - _ys[i];
+            _normalsY[i] = -(_xs[next] - _xs[i]);
+            project(columns(), PolygonPose(), _normalsX[i], _normalsY[i], _selfMin[i], _selfMax[i]);
+        }
+    }
+
+    constexpr PolygonColumns columns() const
+    {
+        return {_xs.data(), _ys.data(), _normalsX.data(), _normalsY.data(), _selfMin.data(), _selfMax.data()};
+    }
+
+    // Separating axis test with another polygon given in the same frame
+    template<std::size_t M>
+    constexpr bool intersects(const FixedPolygon<M>& other) const
+    {
+        return !separates<M>(columns(), other.columns(), PolygonPose())
+               && !FixedPolygon<M>::template separates<N>(other.columns(), columns(), PolygonPose());
+    }
+
+    /**
+    * @brief Projects the N vertices of a polygon, placed by the pose, on an axis.
+    *
+    * Like Polygon::projectPosed(), the axis is turned into the local frame of the polygon and the
+    * projection of the translation is added to the interval afterwards.
+    */
+    static constexpr void project(const PolygonColumns& polygon, const PolygonPose& pose, double axisX, double axisY,
+                                  double& min, double& max)
+    {
+        const double localX = pose.cosTheta * axisX + pose.sinTheta * axisY;
+        const double localY = pose.cosTheta * axisY - pose.sinTheta * axisX;
+        min = std::numeric_limits<double>::infinity();
+        max = -std::numeric_limits<double>::infinity();
+        const auto addVertex = [&](std::size_t i)
+        {
+            const double projection = polygon.xs[i] * localX + polygon.ys[i] * localY;
+            min = std::min(min, projection);
+            max = std::max(max, projection);
+        };
+        [&]<std::size_t... I>(std::index_sequence<I...>)
+        {
+            (addVertex(I), ...);
+        }(std::make_index_sequence<N>());
+
+        const double offset = axisX * pose.centerX + axisY * pose.centerY;
+        min += offset;
+        max += offset;
+    }
+
+    // Projects the other polygon of M vertices, placed in the local frame of this one by the pose, on the N
+    // edge normals of this one; mins and maxs receive N values
+    template<std::size_t M>
+    static constexpr void projectOnAxes(const PolygonColumns& polygon, const PolygonColumns& other,
+                                        const PolygonPose& pose, double* mins, double* maxs)
+    {
+        [&]<std::size_t... I>(std::index_sequence<I...>)
+        {
+            (FixedPolygon<M>::project(other, pose, polygon.normalsX[I], polygon.normalsY[I], mins[I], maxs[I]), ...);
+        }(std::make_index_sequence<N>());
+    }
+
+    // True if one of the N edge normals separates the polygon from the other polygon of M vertices, placed
+    // in its local frame by the pose; stops at the first separating axis
+    template<std::size_t M>
+    static constexpr bool separates(const PolygonColumns& polygon, const PolygonColumns& other, const PolygonPose& pose)
+    {
+        const auto separatesOn = [&](std::size_t axis)
+        {
+            double min = 0.0;
+            double max = 0.0;
+            FixedPolygon<M>::project(other, pose, polygon.normalsX[axis], polygon.normalsY[axis], min, max);
+            return polygon.selfMax[axis] < min || max < polygon.selfMin[axis];
+        };
+        return [&]<std::size_t... I>(std::index_sequence<I...>)
+        {
+            return (separatesOn(I) || ...);
+        }(std::make_index_sequence<N>());
+    }
+
+private:
+    std::array<double, N> _xs {};
+    std::array<double, N> _ys {};
+    std::array<double, N> _normalsX {};
+    std::array<double, N> _normalsY {};
+    std::array<double, N> _selfMin {};
+    std::array<double, N> _selfMax {};
+};
+
+#endif // FIXEDPOLYGON_H
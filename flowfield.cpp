@@ -0,0 +1,332 @@
+#include "flowfield.h"
+#include <algorithm>
+#include <cstdlib>
+#include <functional>
+
+namespace
+{
+constexpr int DIRECTIONS = 8;
+constexpr int DX[DIRECTIONS] = {1, 0, -1, 0, 1, -1, -1, 1};
+constexpr int DY[DIRECTIONS] = {0, 1, 0, -1, 1, 1, -1, -1};
+
+int opposite(int direction)
+{
+    return direction < 4 ? (direction + 2) % 4 : 4 + (direction - 2) % 4;
+}
+}
+
+void FlowField::compute(const OccupancyGrid& grid, const Cell& goal)
+{
+    _width = grid.width();
+    _height = grid.height();
+    _goal = grid.index(goal.first, goal.second);
+    _distance.assign(grid.cellCount(), UNREACHABLE);
+    _direction.assign(grid.cellCount(), -1);
+    _open.clear();
+    _expandedNodes = 0;
+    if (grid.isBlocked(goal.first, goal.second))
+    {
+        seedAroundGoal(grid);
+    }
+    else
+    {
+        _distance[_goal] = 0;
+        push(_goal);
+    }
+    propagate(grid);
+}
+
+void FlowField::update(const OccupancyGrid& grid, const std::vector<int>& changedCells)
+{
+    _expandedNodes = 0;
+    if (!isComputed())
+    {
+        return;
+    }
+    // The targets around a blocked goal depend on the whole blocked area
+    if (grid.width() != _width || grid.height() != _height || grid.isBlocked(_goal % _width, _goal / _width)
+        || std::find(changedCells.begin(), changedCells.end(), _goal) != changedCells.end())
+    {
+        compute(grid, goal());
+        return;
+    }
+
+    // Clears the cells that became blocked and those whose next step is no longer allowed,
+    // which are all next to a changed cell since a cell only affects the steps around it
+    std::vector<int> cleared;
+    const auto clear = [&](int cell)
+    {
+        if (_distance[cell] != UNREACHABLE)
+        {
+            _distance[cell] = UNREACHABLE;
+            _direction[cell] = -1;
+            cleared.push_back(cell);
+        }
+    };
+    for (int cell : changedCells)
+    {
+        const int x = cell % _width;
+        const int y = cell / _width;
+        if (grid.isBlocked(x, y))
+        {
+            clear(cell);
+        }
+        for (int direction = 0; direction < DIRECTIONS; ++direction)
+        {
+            const int nx = x + DX[direction];
+            const int ny = y + DY[direction];
+            if (!grid.contains(nx, ny))
+            {
+                continue;
+            }
+            const int neighbor = grid.index(nx, ny);
+            if (neighbor != _goal && _distance[neighbor] != UNREACHABLE
+                && (grid.isBlocked(nx, ny) || cost(grid, nx, ny, _direction[neighbor]) == UNREACHABLE))
+            {
+                clear(neighbor);
+            }
+        }
+    }
+
+    // The cells whose path to the goal went through a cleared cell lost their distance too
+    for (std::size_t i = 0; i < cleared.size(); ++i)
+    {
+        const int x = cleared[i] % _width;
+        const int y = cleared[i] / _width;
+        for (int direction = 0; direction < DIRECTIONS; ++direction)
+        {
+            const int nx = x + DX[direction];
+            const int ny = y + DY[direction];
+            if (grid.contains(nx, ny) && _direction[grid.index(nx, ny)] == opposite(direction))
+            {
+                clear(grid.index(nx, ny));
+            }
+        }
+    }
+
+    // Every other distance is still reachable and at most the new one: searching again from
+    // the cells around the changes lowers whatever the changes or the clearing made too high
+    _open.clear();
+    for (int cell : cleared)
+    {
+        lowerFromNeighbors(grid, cell);
+    }
+    for (int cell : changedCells)
+    {
+        const int x = cell % _width;
+        const int y = cell / _width;
+        lowerFromNeighbors(grid, cell);
+        for (int direction = 0; direction < DIRECTIONS; ++direction)
+        {
+            if (grid.contains(x + DX[direction], y + DY[direction]))
+            {
+                lowerFromNeighbors(grid, grid.index(x + DX[direction], y + DY[direction]));
+            }
+        }
+    }
+    propagate(grid);
+}
+
+std::vector<int> FlowField::path(const OccupancyGrid& grid, const Cell& start) const
+{
+    if (!isComputed() || !grid.contains(start.first, start.second))
+    {
+        return {};
+    }
+
+    int cell = grid.index(start.first, start.second);
+    std::vector<int> cells{cell};
+    if (grid.isBlocked(start.first, start.second))
+    {
+        // A piece can leave a blocked cell by a single step
+        int best = -1;
+        int bestCost = UNREACHABLE;
+        for (int direction = 0; direction < DIRECTIONS; ++direction)
+        {
+            const int step = cost(grid, start.first, start.second, direction);
+            const int next = cell + DY[direction] * _width + DX[direction];
+            if (step != UNREACHABLE && _distance[next] != UNREACHABLE && step + _distance[next] < bestCost)
+            {
+                bestCost = step + _distance[next];
+                best = next;
+            }
+        }
+        if (best < 0)
+        {
+            // The cells around are blocked too: the piece leaves the blocked area straight to the
+            // closest free cell around it, the one closest to a target among equally close ones
+            int bestStep = UNREACHABLE;
+            grid.freeCellsAround(start.first, start.second, _marks, _freeCells);
+            for (int next : _freeCells)
+            {
+                const int step = octile(next % _width - start.first, next / _width - start.second);
+                if (_distance[next] != UNREACHABLE
+                    && (step < bestStep || (step == bestStep && _distance[next] < _distance[best])))
+                {
+                    bestStep = step;
+                    best = next;
+                }
+            }
+        }
+        if (best < 0)
+        {
+            return {};
+        }
+        cell = best;
+        cells.push_back(cell);
+    }
+    else if (_distance[cell] == UNREACHABLE)
+    {
+        return {};
+    }
+
+    while (_direction[cell] >= 0)
+    {
+        const int direction = _direction[cell];
+        cell += DY[direction] * _width + DX[direction];
+        cells.push_back(cell);
+    }
+    return cells;
+}
+
+int FlowField::cost(const OccupancyGrid& grid, int x, int y, int direction)
+{
+    const int nx = x + DX[direction];
+    const int ny = y + DY[direction];
+    if (grid.isBlocked(nx, ny))
+    {
+        return UNREACHABLE;
+    }
+
+    const bool diagonal = direction >= 4;
+    // No corner cutting, as in PathFinding
+    if (diagonal && (grid.isBlocked(nx, y) || grid.isBlocked(x, ny)))
+    {
+        return UNREACHABLE;
+    }
+    return diagonal ? DIAGONAL_COST : STRAIGHT_COST;
+}
+
+int FlowField::octile(int dx, int dy)
+{
+    dx = std::abs(dx);
+    dy = std::abs(dy);
+    return STRAIGHT_COST * std::max(dx, dy) + (DIAGONAL_COST - STRAIGHT_COST) * std::min(dx, dy);
+}
+
+bool FlowField::lowerFromNeighbors(const OccupancyGrid& grid, int cell)
+{
+    const int x = cell % _width;
+    const int y = cell / _width;
+    if (cell == _goal || grid.isBlocked(x, y))
+    {
+        return false;
+    }
+
+    bool lowered = false;
+    for (int direction = 0; direction < DIRECTIONS; ++direction)
+    {
+        const int step = cost(grid, x, y, direction);
+        const int next = cell + DY[direction] * _width + DX[direction];
+        if (step != UNREACHABLE && _distance[next] != UNREACHABLE && step + _distance[next] < _distance[cell])
+        {
+            _distance[cell] = step + _distance[next];
+            _direction[cell] = static_cast<std::int8_t>(direction);
+            lowered = true;
+        }
+    }
+    if (lowered)
+    {
+        push(cell);
+    }
+    return lowered;
+}
+
+void FlowField::seedAroundGoal(const OccupancyGrid& grid)
+{
+    const int goalX = _goal % _width;
+    const int goalY = _goal / _width;
+    grid.freeCellsAround(goalX, goalY, _marks, _freeCells);
+    const std::vector<int>& around = _freeCells;
+
+    // The free cells split into areas the pieces cannot move between; in each area only the
+    // cells around the goal that are closest to it are targets, so a piece gets as near as it can
+    std::vector<int> area(grid.cellCount(), -1);
+    std::vector<int> closest;
+    std::vector<int> flood;
+    for (int cell : around)
+    {
+        if (area[cell] < 0)
+        {
+            area[cell] = static_cast<int>(closest.size());
+            flood.assign(1, cell);
+            for (std::size_t i = 0; i < flood.size(); ++i)
+            {
+                const int x = flood[i] % _width;
+                const int y = flood[i] / _width;
+                for (int direction = 0; direction < DIRECTIONS; ++direction)
+                {
+                    const int neighbor = flood[i] + DY[direction] * _width + DX[direction];
+                    if (cost(grid, x, y, direction) != UNREACHABLE && area[neighbor] < 0)
+                    {
+                        area[neighbor] = area[cell];
+                        flood.push_back(neighbor);
+                    }
+                }
+            }
+            closest.push_back(UNREACHABLE);
+        }
+        closest[area[cell]] = std::min(closest[area[cell]], octile(cell % _width - goalX, cell / _width - goalY));
+    }
+
+    for (int cell : around)
+    {
+        const int distance = octile(cell % _width - goalX, cell / _width - goalY);
+        if (distance == closest[area[cell]])
+        {
+            // Each target starts at the cost of the straight line to the goal
+            _distance[cell] = distance;
+            push(cell);
+        }
+    }
+}
+
+void FlowField::push(int cell)
+{
+    _open.emplace_back(_distance[cell], cell);
+    std::push_heap(_open.begin(), _open.end(), std::greater<>{});
+}
+
+void FlowField::propagate(const OccupancyGrid& grid)
+{
+    while (!_open.empty())
+    {
+        std::pop_heap(_open.begin(), _open.end(), std::greater<>{});
+        const auto [distance, cell] = _open.back();
+        _open.pop_back();
+        if (distance != _distance[cell])
+        {
+            continue;
+        }
+
+        ++_expandedNodes;
+        const int x = cell % _width;
+        const int y = cell / _width;
+        for (int direction = 0; direction < DIRECTIONS; ++direction)
+        {
+            // Steps between free cells cost the same both ways
+            const int step = cost(grid, x, y, direction);
+            if (step == UNREACHABLE)
+            {
+                continue;
+            }
+            const int neighbor = cell + DY[direction] * _width + DX[direction];
+            if (distance + step < _distance[neighbor])
+            {
+                _distance[neighbor] = distance + step;
+                _direction[neighbor] = static_cast<std::int8_t>(opposite(direction));
+                push(neighbor);
+            }
+        }
+    }
+}
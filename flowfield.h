@@ -0,0 +1,105 @@
+/**
+ * @file FlowField.h
+ *
+ * @brief Defines the FlowField class, the distances to a goal shared by many pieces.
+ */
+
+#ifndef FLOWFIELD_H
+#define FLOWFIELD_H
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+#include "occupancygrid.h"
+
+/**
+ * @class FlowField
+ * @brief Distance to a goal and direction of the next step for every cell of an OccupancyGrid.
+ *
+ * A single Dijkstra search runs outward from the goal over the free cells, with the moves,
+ * costs and no-corner-cutting rule of PathFinding. Each cell then stores its distance to the
+ * goal and the direction of the neighbor its shortest path continues with, so a piece reads
+ * its next step in constant time whatever the number of pieces heading to the same goal.
+ *
+ * A goal inside an obstacle, such as an end position within the inflation band of a shape, is
+ * not unreachable: the search then starts from the free cells around the blocked area that
+ * holds the goal and closest to it, one set for each area of free cells the pieces cannot leave,
+ * so every piece heads to the nearest of them it can reach. Those cells, like a free goal, are
+ * the targets of the field.
+ *
+ * When cells change, update() first clears the cells whose path went through a changed cell
+ * (the subtree of the field below it), then runs the search again from the border of the
+ * cleared and changed cells only, which gives the same distances as a full recomputation.
+ */
+class FlowField
+{
+public:
+    using Cell = std::pair<int, int>;
+
+    FlowField() = default;
+
+    // Computes the field from scratch; a blocked goal is replaced by the free cells around it
+    void compute(const OccupancyGrid& grid, const Cell& goal);
+    /**
+    * @brief Repairs the field after cells of the grid changed.
+    * @param grid The grid the field was computed on, already updated.
+    * @param changedCells Ids of the cells whose blocked state changed since the last call.
+    */
+    void update(const OccupancyGrid& grid, const std::vector<int>& changedCells);
+
+    /**
+    * @brief Follows the field from a cell to the goal.
+    *
+    * The start cell may be blocked; it is then left by the step to the free neighbor that is
+    * closest to the goal or, when every neighbor is blocked, straight to the closest free cell
+    * around the blocked area.
+    *
+    * @return The cell ids from the start to the goal, or to the target standing in for a blocked
+    *         goal, or an empty vector if no target can be reached.
+    */
+    std::vector<int> path(const OccupancyGrid& grid, const Cell& start) const;
+
+    bool isComputed() const { return _goal >= 0; }
+    Cell goal() const { return {_goal % _width, _goal / _width}; }
+    // Cost to the goal in tenths of a cell, UNREACHABLE for blocked and cut-off cells
+    int distance(int cell) const { return _distance[cell]; }
+    // Index of the direction of the next step, in the order of PathFinding, or -1 if there is none
+    int direction(int cell) const { return _direction[cell]; }
+    // True for the goal and, when it is blocked, the free cells standing in for it
+    bool isTarget(int cell) const { return _distance[cell] != UNREACHABLE && _direction[cell] < 0; }
+    // Number of cells taken from the open list by the last compute() or update()
+    std::size_t expandedNodes() const { return _expandedNodes; }
+
+    static constexpr int UNREACHABLE = INT32_MAX;
+
+private:
+    // Cost of the step from a free cell in one direction, UNREACHABLE if it is not allowed
+    static int cost(const OccupancyGrid& grid, int x, int y, int direction);
+    // Cost of the moves across an offset of cells when nothing is in the way
+    static int octile(int dx, int dy);
+    // Takes the cheapest step from a cell towards the goal, if it lowers its distance
+    bool lowerFromNeighbors(const OccupancyGrid& grid, int cell);
+    void push(int cell);
+    // Seeds the search with the free cells bordering the blocked area that holds the goal
+    void seedAroundGoal(const OccupancyGrid& grid);
+    // Dijkstra from the queued cells outward, lowering the distances of their neighbors
+    void propagate(const OccupancyGrid& grid);
+
+    static constexpr int STRAIGHT_COST = 10;
+    static constexpr int DIAGONAL_COST = 14;
+
+    int _width = 0;
+    int _height = 0;
+    int _goal = -1;
+    std::vector<int> _distance;
+    std::vector<std::int8_t> _direction;
+    // Min-heap of (distance, cell); entries whose distance is outdated are skipped
+    std::vector<std::pair<int, int>> _open;
+    std::size_t _expandedNodes = 0;
+    // Flood fill around a blocked goal or start; path() reuses them, so it must not race with
+    // other calls
+    mutable CellMarks _marks;
+    mutable std::vector<int> _freeCells;
+};
+
+#endif // FLOWFIELD_H
@@ -1,114 +1,98 @@
 #include "game.h"
+#include "scratcharena.h"
 
-Game::Game() {}
+Game::Game(std::shared_ptr<Scene> scene) :
+    _scene{std::move(scene)}
+{
+}
 
 
-ShapePtrVector createPolygons()
+// Vertices of the polygons of the game, relative to the scene's origin
+std::vector<std::vector<Point>> createPolygons()
 {
-    ShapePtrVector shapes;
+    std::vector<std::vector<Point>> shapes;
 
     //Polygon 0
-    auto rect = std::make_unique<Polygon>(std::initializer_list<Point>
-                                          {
-                                              std::move(Point(-12.0,-10.0, 0.0)),
-                                              std::move(Point(-12.0, -5.0, 0.0)),
-                                              std::move(Point(-4.0, -10.0, 0.0)),
-                                              std::move(Point(-5.0, -15.0, 0.0))
-                                          });
-
-    shapes.push_back(std::move(rect));
+    shapes.push_back({
+                         Point(-12.0,-10.0, 0.0),
+                         Point(-12.0, -5.0, 0.0),
+                         Point(-4.0, -10.0, 0.0),
+                         Point(-5.0, -15.0, 0.0)
+                     });
 
     // Polygon 1
-    auto rect1 = std::make_unique<Polygon>(std::initializer_list<Point>
-                                           {
-                                               std::move(Point(-3.36603, 11.1603, 0)),
-                                               std::move(Point(6.16025, 11.1603, 0)),
-                                               std::move(Point(6.16025, 3.83013, 0)),
-                                               std::move(Point(-3.36603, 3.83013, 0))
-                                           });
-
-    shapes.push_back(std::move(rect1));
+    shapes.push_back({
+                         Point(-3.36603, 11.1603, 0),
+                         Point(6.16025, 11.1603, 0),
+                         Point(6.16025, 3.83013, 0),
+                         Point(-3.36603, 3.83013, 0)
+                     });
 
     // Polygon 2
-    auto triangle = std::make_unique<Polygon>(std::initializer_list<Point>
-                                              {
-                                                  std::move(Point(-1.0, 5.0, 0.0)),
-                                                  std::move(Point(5.0, 10.0, 0.0)),
-                                                  std::move(Point(10.0, 5.0, 0.0))
-                                              });
-
-    shapes.push_back(std::move(triangle));
+    shapes.push_back({
+                         Point(-1.0, 5.0, 0.0),
+                         Point(5.0, 10.0, 0.0),
+                         Point(10.0, 5.0, 0.0)
+                     });
     // Polygon 3
-    auto rect2 = std::make_unique<Polygon>(std::initializer_list<Point>
-                                           {
-                                               std::move(Point(5.0, -1.0, 0.0)),
-                                               std::move(Point(18.0, 2.0, 0.0)),
-                                               std::move(Point(18.0, -10.0, 0.0)),
-                                               std::move(Point(30.0, 0.0, 0.0))
-                                           });
-
-    shapes.push_back(std::move(rect2));
+    shapes.push_back({
+                         Point(5.0, -1.0, 0.0),
+                         Point(18.0, 2.0, 0.0),
+                         Point(18.0, -10.0, 0.0),
+                         Point(30.0, 0.0, 0.0)
+                     });
     // Polygon 4
-    auto pentagon = std::make_unique<Polygon>(std::initializer_list<Point>
-                                              {
-                                                  std::move(Point(-30.0, 15.0, 0.0)),
-                                                  std::move(Point(-20.0, 15, 0.0)),
-                                                  std::move(Point(-30.0, 8.0, 0.0)),
-                                                  std::move(Point(-15.0, 0.0, 0.0)),
-                                                  std::move(Point(-12.0, 8.0, 0.0))
-                                              });
-
-    shapes.push_back(std::move(pentagon));
+    shapes.push_back({
+                         Point(-30.0, 15.0, 0.0),
+                         Point(-20.0, 15, 0.0),
+                         Point(-30.0, 8.0, 0.0),
+                         Point(-15.0, 0.0, 0.0),
+                         Point(-12.0, 8.0, 0.0)
+                     });
     // Polygon 5
-    auto triangle2 = std::make_unique<Polygon>(std::initializer_list<Point>
-                                               {
-                                                   std::move(Point(-30.0, -3.0, 0.0)),
-                                                   std::move(Point(-34.0, -5.0, 0.0)),
-                                                   std::move(Point(-27.0, -9.0, 0.0))
-                                               });
-
-    shapes.push_back(std::move(triangle2));
+    shapes.push_back({
+                         Point(-30.0, -3.0, 0.0),
+                         Point(-34.0, -5.0, 0.0),
+                         Point(-27.0, -9.0, 0.0)
+                     });
 
     // Polygon 6
-    auto square = std::make_unique<Polygon>(std::initializer_list<Point>
-                                            {
-                                                std::move(Point(30.0, -30.0, 0.0)),
-                                                std::move(Point(35.0, -30.0, 0.0)),
-                                                std::move(Point(30.0, -35.0, 0.0)),
-                                                std::move(Point(35.0, -35.0, 0.0))
-                                            });
-
-    shapes.push_back(std::move(square));
+    shapes.push_back({
+                         Point(30.0, -30.0, 0.0),
+                         Point(35.0, -30.0, 0.0),
+                         Point(30.0, -35.0, 0.0),
+                         Point(35.0, -35.0, 0.0)
+                     });
 
     //Polygon 7
-    auto rect3 = std::make_unique<Polygon>(std::initializer_list<Point>
-                                           {
-                                               std::move(Point(-40.0, -30.0, 0.0)),
-                                               std::move(Point(-25.0, -30.0, 0.0)),
-                                               std::move(Point(-40.0, -35.0, 0.0)),
-                                               std::move(Point(-25.0, -35.0, 0.0))
-                                           });
-
-    shapes.push_back(std::move(rect3));
-
-    auto ellipse = std::make_shared<CircularShape>(std::move(Point(45, 30, 0)), 5.0, 3.0);
-    auto circle = std::make_shared<CircularShape>(std::move(Point(-45, 10, 0)), 5.0);
+    shapes.push_back({
+                         Point(-40.0, -30.0, 0.0),
+                         Point(-25.0, -30.0, 0.0),
+                         Point(-40.0, -35.0, 0.0),
+                         Point(-25.0, -35.0, 0.0)
+                     });
+
     return shapes;
 }
 
-void Game::initGameEnv(std::shared_ptr<Scene> scene)
+void Game::initGameEnv()
 {
-    const auto& polygons = createPolygons();
-    for(const auto& polygon : polygons)
+    for(auto& vertices : createPolygons())
     {
-        scene->mapComponentToScene(polygon);
+        _scene->addPolygon(std::move(vertices));
     }
 }
 
-void Game::checkPossibleCollisions(std::shared_ptr<Shape> playerPiece, const Point &endPosition)
+void Game::checkPossibleCollisions(ShapeHandle playerPiece, const Point &endPosition)
 {
-    std::shared_ptr<Polygon> polygon = std::dynamic_pointer_cast<Polygon>(playerPiece);
-    const auto& collisionPoints = Scene::getInstance()->scanPossibleCollision(polygon, endPosition);
+    const Polygon* polygon = _scene->polygon(playerPiece);
+    if (!polygon)
+    {
+        return;
+    }
+    ScratchArena::Scope scope;
+    std::pmr::vector<std::pair<Broadphase::Id, Point>> collisions(&scope.arena());
+    _scene->scanPossibleCollision(*polygon, endPosition, collisions);
 
     std::cout << "\nFor the playing piece(polygon vertices): "  << std::endl;
     for(const auto& player: polygon->transformedVertices())
@@ -116,9 +100,13 @@ void Game::checkPossibleCollisions(std::shared_ptr<Shape> playerPiece, const Poi
         std::cout  << " ->" << player  << std::endl;
     }
     //std::cout << std::endl;
-    if(collisionPoints.size())
+    if(collisions.size())
     {
         std::cout <<  "there're obstruction shape(s) along the way to " << endPosition << std::endl;
+        for(const auto& [id, contact] : collisions)
+        {
+            std::cout << " -> component " << id << " is hit with the center at " << contact << std::endl;
+        }
     }
     else
     {
@@ -127,12 +115,15 @@ void Game::checkPossibleCollisions(std::shared_ptr<Shape> playerPiece, const Poi
     std::cout << std::endl;
 }
 
-void Game::rotatePlayingPieces(ShapePtrVector playerPieces, double step, bool clockwise, std::optional<Point> pivot)
+std::vector<double> Game::rotatePlayingPieces(std::span<const ShapeHandle> playerPieces, double step, bool clockwise, std::optional<Point> pivot)
 {
-    for (const auto& playerPiece : playerPieces)
-    {
-        std::shared_ptr<Polygon> polygon = std::dynamic_pointer_cast<Polygon>(playerPiece);
+    std::vector<double> angles;
+    angles.reserve(playerPieces.size());
+    std::vector<Polygon*> polygons;
+    std::vector<Point> pivots;
 
+    for (Polygon* polygon : playingPolygons(playerPieces))
+    {
         Point rotateAt;
         if(pivot.has_value())
         {
@@ -140,38 +131,247 @@ void Game::rotatePlayingPieces(ShapePtrVector playerPieces, double step, bool cl
         }
         else
         {
-            //rotateAt = polygon->getCenter();
+            rotateAt = polygon->calculatePolygonCenter();
+        }
+        if (_scheduler)
+        {
+            polygons.push_back(polygon);
+            pivots.push_back(rotateAt);
+            continue;
         }
-        polygon->rotate(rotateAt, step, clockwise);
+        angles.push_back(polygon->rotate(rotateAt, step, clockwise));
+    }
+    if (_scheduler)
+    {
+        angles = _scheduler->rotate(*_scene, polygons, pivots, step, clockwise);
+    }
+    _scene->publishSnapshot();
+    return angles;
+}
+
+void Game::movePlayingPieces(std::span<const ShapeHandle> playerPieces, const Point &endPosition)
+{
+    std::vector<Polygon*> polygons = playingPolygons(playerPieces);
+    if (_navigation == Navigation::Cooperative)
+    {
+        moveCooperatively(std::move(polygons), endPosition);
+        return;
+    }
+
+    if (_navigation == Navigation::FlowField)
+    {
+        // One search from the end position serves every piece
+        const std::vector<const Polygon*> pieces(polygons.begin(), polygons.end());
+        _pathFinding.buildFlowField(*_scene, pieces, endPosition);
     }
 
+    for (Polygon* polygon : polygons)
+    {
+        const Point start = polygon->calculatePolygonCenter();
+        std::vector<Point> waypoints;
+        if (_navigation == Navigation::FlowField)
+        {
+            waypoints = _pathFinding.followFlowField(start);
+        }
+        else
+        {
+            // Any-angle paths need the fewest moves
+            _pathFinding.buildVisibilityGraph(*_scene, *polygon);
+            waypoints = _pathFinding.findAnyAnglePath(start, endPosition);
+        }
+        // The grid search of the piece alone still finds a way when it starts wedged between
+        // shapes. It is incremental, so replanning after the other pieces moved only repairs
+        // what their moves changed.
+        if (waypoints.empty())
+        {
+            waypoints = _pathFinding.replan(*_scene, *polygon, endPosition);
+        }
+        if (waypoints.empty())
+        {
+            std::cout << "No path found to " << endPosition << ", moving straight." << std::endl;
+            polygon->move(endPosition, _moveStepSize);
+            _scene->publishSnapshot();
+            continue;
+        }
+        followWaypoints(*polygon, std::move(waypoints), endPosition);
+    }
 }
 
-void Game::movePlayingPieces(ShapePtrVector playerPieces, const Point &endPosition)
+void Game::followWaypoints(Polygon& piece, std::vector<Point> waypoints, const Point& endPosition)
 {
-    for (const auto& playerPiece : playerPieces)
+    for (int attempt = 0; attempt <= MAX_REPLANS && !waypoints.empty(); ++attempt)
     {
-        std::shared_ptr<Polygon> polygon = std::dynamic_pointer_cast<Polygon>(playerPiece);
-        polygon->move(endPosition, _moveStepSize);
+        bool stopped = false;
+        for (std::size_t i = 0; i < waypoints.size(); ++i)
+        {
+            piece.move(waypoints[i], _moveStepSize);
+            _scene->publishSnapshot();
+            // Stopped by a contact the path did not foresee. The last leg is the swept move to the
+            // end position itself, which may lie next to a shape: a contact there ends the move.
+            if (i + 1 < waypoints.size() && piece.getCenter().calculateDistance(waypoints[i]) > _pathFinding.cellSize())
+            {
+                stopped = true;
+                break;
+            }
+        }
+        if (!stopped)
+        {
+            break;
+        }
+        waypoints = _pathFinding.replan(*_scene, piece, endPosition);
     }
 }
 
-ShapePtrVector Game::selectPlayerPiecesRandom(int numOfPlayerPieces)
+std::vector<Polygon*> Game::playingPolygons(std::span<const ShapeHandle> playerPieces) const
+{
+    std::vector<Polygon*> polygons;
+    polygons.reserve(playerPieces.size());
+    for (const ShapeHandle& playerPiece : playerPieces)
+    {
+        if (Polygon* polygon = _scene->polygon(playerPiece))
+        {
+            polygons.push_back(polygon);
+        }
+    }
+    return polygons;
+}
+
+void Game::moveCooperatively(std::vector<Polygon*> order, const Point& endPosition)
+{
+    std::vector<const Polygon*> pieces(order.begin(), order.end());
+    _pathFinding.buildFlowField(*_scene, pieces, endPosition);
+
+    // The pieces the field cannot lead to the end position stay where they are until the others are done
+    std::vector<Polygon*> stranded;
+    std::erase_if(order, [&](Polygon* piece)
+    {
+        if (_pathFinding.followFlowField(piece->getCenter()).empty())
+        {
+            stranded.push_back(piece);
+            return true;
+        }
+        return false;
+    });
+
+    // The pieces move cell by cell until the final swept move, which alone reports where each one ends
+    {
+        Scene::QuietScope quiet;
+
+        // The cooperative search steps between neighboring cells only: the pieces in a blocked cell,
+        // within the inflation band of a shape, first leave it for the cell the field gives them
+        std::vector<Polygon*> leaving;
+        std::vector<Point> exits;
+        for (Polygon* piece : order)
+        {
+            const auto cell = _pathFinding.flowGrid().cellOf(piece->getCenter());
+            const auto exit = _pathFinding.flowStep(piece->getCenter());
+            if (cell && exit && _pathFinding.flowGrid().isBlocked(cell->first, cell->second))
+            {
+                leaving.push_back(piece);
+                exits.push_back(*exit);
+            }
+        }
+        if (!leaving.empty())
+        {
+            moveAll(leaving, exits);
+        }
+
+        for (int round = 0; round < MAX_COOPERATIVE_ROUNDS && !order.empty(); ++round)
+        {
+            pieces.assign(order.begin(), order.end());
+            const auto plans = _pathFinding.planCooperative(*_scene, pieces, endPosition, COOPERATIVE_WINDOW);
+            bool moved = false;
+            for (int time = 1; time <= COOPERATIVE_WINDOW / 2; ++time)
+            {
+                std::vector<Polygon*> steppers;
+                std::vector<Point> destinations;
+                for (std::size_t i = 0; i < order.size(); ++i)
+                {
+                    if (static_cast<int>(plans[i].size()) > time && plans[i][time].calculateDistance(plans[i][time - 1]) > 0)
+                    {
+                        steppers.push_back(order[i]);
+                        destinations.push_back(plans[i][time]);
+                    }
+                }
+                moved = moved || !steppers.empty();
+                moveAll(steppers, destinations);
+            }
+            if (!moved)
+            {
+                break;
+            }
+            // The piece planned first has the most room; rotating the order lets each one lead in turn
+            std::rotate(order.begin(), order.begin() + 1, order.end());
+        }
+    }
+
+    // The plans end on the cell of the end position, or next to it when it lies within the
+    // inflation band of a shape; a swept move covers the rest of the way
+    if (!order.empty())
+    {
+        moveAll(order, std::vector<Point>(order.size(), endPosition));
+    }
+
+    for (Polygon* piece : stranded)
+    {
+        std::cout << "No path found to " << endPosition << ", moving straight." << std::endl;
+        piece->move(endPosition, _moveStepSize);
+        _scene->publishSnapshot();
+    }
+}
+
+void Game::moveAll(std::span<Polygon* const> pieces, std::span<const Point> destinations)
+{
+    if (_scheduler)
+    {
+        _scheduler->move(*_scene, pieces, destinations, _moveStepSize);
+    }
+    else
+    {
+        for (std::size_t i = 0; i < pieces.size(); ++i)
+        {
+            pieces[i]->move(destinations[i], _moveStepSize);
+        }
+    }
+    // The pieces all took one step
+    _scene->publishSnapshot();
+}
+
+void Game::reportCollisions()
+{
+    ScratchArena::Scope scope;
+    std::pmr::vector<std::pair<Broadphase::Id, Broadphase::Id>> collisions(&scope.arena());
+    _scene->collidingPairs(collisions);
+    if (collisions.empty())
+    {
+        std::cout << "There aren't overlapping shapes in the scene." << std::endl;
+        return;
+    }
+
+    std::cout << "Overlapping shapes in the scene:" << std::endl;
+    for (const auto& [id, other] : collisions)
+    {
+        std::cout << " -> component " << id << " and component " << other << std::endl;
+    }
+}
+
+ShapeHandles Game::selectPlayerPiecesRandom(int numOfPlayerPieces)
 {
     std::random_device rd;
     std::mt19937 rng(rd());
-    std::uniform_int_distribution<int> dist(1, Scene::getInstance()->components().size() - 1);
+    std::uniform_int_distribution<int> dist(1, _scene->components().size() - 1);
     std::unordered_set<int> selectedIndices;
 
     while (selectedIndices.size() < numOfPlayerPieces)
     {
         int randomComponent = dist(rng);
 
-        if (selectedIndices.find(randomComponent) == selectedIndices.end())
+        // Only polygons are moved and rotated
+        if (selectedIndices.find(randomComponent) == selectedIndices.end() && _scene->polygon(static_cast<Broadphase::Id>(randomComponent)))
         {
             selectedIndices.insert(randomComponent);
-            Scene::getInstance()->components().at(randomComponent).second = true;
-            _playerPieces.push_back(Scene::getInstance()->components().at(randomComponent).first);
+            _scene->setPlayerPiece(randomComponent, true);
+            _playerPieces.push_back(_scene->component(randomComponent).handle);
         }
     }
 
@@ -196,7 +396,7 @@ Point Game::endPosition() const
 void Game::setEndPosition(Point newEndPosition)
 {
     _endPosition = newEndPosition;
-    Scene::getInstance()->mapPointToScene(_endPosition);
+    _scene->mapPointToScene(_endPosition);
 
 }
 
@@ -209,3 +409,35 @@ void Game::setRotateStepSize(double newRotateStepSize)
 {
     _rotateStepSize = newRotateStepSize;
 }
+
+const std::shared_ptr<Scene>& Game::scene() const
+{
+    return _scene;
+}
+
+Game::Navigation Game::navigation() const
+{
+    return _navigation;
+}
+
+void Game::setNavigation(Navigation newNavigation)
+{
+    _navigation = newNavigation;
+}
+
+std::size_t Game::threadCount() const
+{
+    return _scheduler ? _scheduler->threadCount() : 1;
+}
+
+void Game::setThreadCount(std::size_t newThreadCount)
+{
+    if (newThreadCount > 1)
+    {
+        _scheduler = std::make_unique<IslandScheduler>(newThreadCount);
+    }
+    else
+    {
+        _scheduler.reset();
+    }
+}
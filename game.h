@@ -3,37 +3,80 @@
 #include <vector>
 #include <memory>
 #include "scene.h"
+#include "islandscheduler.h"
+#include "pathfinding.h"
 /**
  * @brief The Game class
  */
 
-using ShapePtrVector = std::vector<std::shared_ptr<Shape>>;
+using ShapeHandles = std::vector<ShapeHandle>;
 
 class Game
 {
 public:
-    Game();
+    // How the pieces find their way: each on its own, all along one flow field to the end
+    // position, or along the flow field together, each booking its next steps for the others
+    enum class Navigation { Individual, FlowField, Cooperative };
+
+    // The game plays in the scene; games on different scenes can run on different threads
+    explicit Game(std::shared_ptr<Scene> scene);
     ~Game() = default;
 
-    void initGameEnv(std::shared_ptr<Scene> scene);
+    void initGameEnv();
 
     // This function determines if a player can use the shortest path from start to end position.
-    void checkPossibleCollisions(std::shared_ptr<Shape>playerPiece, const Point& endPosition);
-    void rotatePlayingPieces(ShapePtrVector playerPieces, double step, bool clockwise, std::optional<Point> pivot = std::nullopt);
-    void movePlayingPieces(ShapePtrVector playerPieces, const Point& endPosition );
-    ShapePtrVector selectPlayerPiecesRandom(int numOfPlayerPieces);
+    void checkPossibleCollisions(ShapeHandle playerPiece, const Point& endPosition);
+    // Rotates every piece by the angle or until its first contact; returns the angle each piece reached
+    std::vector<double> rotatePlayingPieces(std::span<const ShapeHandle> playerPieces, double step, bool clockwise, std::optional<Point> pivot = std::nullopt);
+    // Moves every piece along its shortest path to the end position, or straight if no path is found;
+    // the scene publishes a snapshot after every step
+    void movePlayingPieces(std::span<const ShapeHandle> playerPieces, const Point& endPosition );
+    // Lists the shapes that overlap each other, using one broadphase pass over the whole scene
+    void reportCollisions();
+    ShapeHandles selectPlayerPiecesRandom(int numOfPlayerPieces);
     double moveStepSize() const;
     void setMoveStepSize(double newMoveStepSize);
     Point endPosition() const;
     void setEndPosition(Point newEndPosition);
     double rotateStepSize() const;
     void setRotateStepSize(double newRotateStepSize);
+    const std::shared_ptr<Scene>& scene() const;
+    Navigation navigation() const;
+    void setNavigation(Navigation newNavigation);
+    std::size_t threadCount() const;
+    /**
+     * @brief Sets the number of threads moving and rotating the pieces.
+     *
+     * With more than one, the rotations and the steps of cooperative moves run on an
+     * IslandScheduler, with the same results as one thread. The other navigation modes plan
+     * each piece's path after the previous piece moved, so they always run on one thread.
+     */
+    void setThreadCount(std::size_t newThreadCount);
 
 private:
-    ShapePtrVector _playerPieces;
+    // The polygons the handles name, in order, leaving out the handles of removed shapes
+    std::vector<Polygon*> playingPolygons(std::span<const ShapeHandle> playerPieces) const;
+    // Moves a piece along the waypoints, planning again from where an unforeseen contact stops it
+    void followWaypoints(Polygon& piece, std::vector<Point> waypoints, const Point& endPosition);
+    // Moves all the pieces one cell per time step along cooperative plans, planning again every half window
+    void moveCooperatively(std::vector<Polygon*> order, const Point& endPosition);
+    // Moves each piece toward its destination, in order, on the scheduler if there is one, and publishes the step
+    void moveAll(std::span<Polygon* const> pieces, std::span<const Point> destinations);
+
+    std::shared_ptr<Scene> _scene;
+    ShapeHandles _playerPieces;
     Point _startPosition;
     Point _endPosition;
     double _moveStepSize;
     double _rotateStepSize;
+    Navigation _navigation = Navigation::Individual;
+    PathFinding _pathFinding;
+    // Only created for more than one thread
+    std::unique_ptr<IslandScheduler> _scheduler;
+    // Number of times a piece stopped by an unforeseen contact plans again from where it is
+    static constexpr int MAX_REPLANS = 3;
+    // Time steps the cooperative plans look ahead, and the most planning rounds of one move
+    static constexpr int COOPERATIVE_WINDOW = 16;
+    static constexpr int MAX_COOPERATIVE_ROUNDS = 500;
 };
 #endif // GAME_H
@@ -1,25 +1,9 @@
 TEMPLATE = app
-CONFIG += console c++20
+CONFIG += console c++20 thread
 CONFIG -= app_bundle
 CONFIG -= qt
 
-SOURCES += \
-        circularshape.cpp \
-        game.cpp \
-        main.cpp \
-        node.cpp \
-        pathfinding.cpp \
-        point.cpp \
-        polygon.cpp \
-        scene.cpp \
-        shape.cpp
+include(engine.pri)
 
-HEADERS += \
-    circularshape.h \
-    game.h \
-    node.h \
-    pathfinding.h \
-    point.h \
-    polygon.h \
-    scene.h \
-    shape.h
+SOURCES += \
+        main.cpp
@@ -0,0 +1,153 @@
+#include "islandscheduler.h"
+#include <algorithm>
+#include <numeric>
+#include <sstream>
+#include "polygon.h"
+
+IslandScheduler::IslandScheduler(std::size_t threadCount) :
+    _pool{threadCount}
+{
+}
+
+void IslandScheduler::move(Scene& scene, std::span<Polygon* const> pieces, std::span<const Point> destinations, double stepSize)
+{
+    std::vector<Broadphase::Box> regions;
+    std::vector<Broadphase::Id> ids;
+    for (std::size_t i = 0; i < pieces.size(); ++i)
+    {
+        regions.push_back(Scene::sweptBox(*pieces[i], destinations[i]));
+        ids.push_back(pieces[i]->componentId());
+    }
+    run(scene, regions, ids, [&](std::size_t i) { pieces[i]->move(destinations[i], stepSize); });
+}
+
+std::vector<double> IslandScheduler::rotate(Scene& scene, std::span<Polygon* const> pieces, std::span<const Point> pivots,
+                                            double step, bool clockwise)
+{
+    std::vector<Broadphase::Box> regions;
+    std::vector<Broadphase::Id> ids;
+    for (std::size_t i = 0; i < pieces.size(); ++i)
+    {
+        regions.push_back(pieces[i]->rotationRegion(pivots[i]));
+        ids.push_back(pieces[i]->componentId());
+    }
+    std::vector<double> angles(pieces.size(), 0.0);
+    run(scene, regions, ids, [&](std::size_t i) { angles[i] = pieces[i]->rotate(pivots[i], step, clockwise); });
+    return angles;
+}
+
+std::vector<std::vector<std::size_t>> IslandScheduler::islands(std::span<const Broadphase::Box> regions)
+{
+    return islands(regions.size(), overlappingRegions(regions));
+}
+
+std::vector<std::pair<std::size_t, std::size_t>> IslandScheduler::overlappingRegions(std::span<const Broadphase::Box> regions)
+{
+    std::vector<std::size_t> sorted(regions.size());
+    std::iota(sorted.begin(), sorted.end(), 0);
+    std::sort(sorted.begin(), sorted.end(), [&regions](std::size_t a, std::size_t b)
+              {
+                  return regions[a].first.getX() < regions[b].first.getX();
+              });
+
+    // Sweep along x, keeping the regions whose x extent is still open at the current minimum
+    std::vector<std::pair<std::size_t, std::size_t>> pairs;
+    std::vector<std::size_t> active;
+    for (std::size_t i : sorted)
+    {
+        std::erase_if(active, [&](std::size_t j) { return regions[j].second.getX() < regions[i].first.getX(); });
+        for (std::size_t j : active)
+        {
+            if (Broadphase::overlaps(regions[i], regions[j]))
+            {
+                pairs.push_back(std::minmax(i, j));
+            }
+        }
+        active.push_back(i);
+    }
+    return pairs;
+}
+
+std::vector<std::vector<std::size_t>> IslandScheduler::islands(std::size_t count, std::span<const std::pair<std::size_t, std::size_t>> pairs)
+{
+    std::vector<std::size_t> parent(count);
+    std::iota(parent.begin(), parent.end(), 0);
+    const auto find = [&parent](std::size_t i)
+    {
+        while (parent[i] != i)
+        {
+            parent[i] = parent[parent[i]];
+            i = parent[i];
+        }
+        return i;
+    };
+    for (const auto& [i, j] : pairs)
+    {
+        // The smaller root wins, so the grouping does not depend on the order of the pairs
+        const std::size_t a = find(i);
+        const std::size_t b = find(j);
+        parent[std::max(a, b)] = std::min(a, b);
+    }
+
+    std::vector<std::vector<std::size_t>> groups;
+    std::vector<std::size_t> groupOf(count, count);
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        const std::size_t root = find(i);
+        if (groupOf[root] == count)
+        {
+            groupOf[root] = groups.size();
+            groups.emplace_back();
+        }
+        groups[groupOf[root]].push_back(i);
+    }
+    std::stable_sort(groups.begin(), groups.end(), [](const auto& a, const auto& b) { return a.size() > b.size(); });
+    return groups;
+}
+
+void IslandScheduler::run(Scene& scene, std::span<const Broadphase::Box> regions, std::span<const Broadphase::Id> pieces,
+                          const std::function<void(std::size_t)>& operation)
+{
+    const auto pairs = overlappingRegions(regions);
+    const auto groups = islands(regions.size(), pairs);
+    _islandCount = groups.size();
+
+    std::vector<std::vector<Broadphase::Id>> neighbors(regions.size());
+    for (const auto& [i, j] : pairs)
+    {
+        neighbors[i].push_back(pieces[j]);
+        neighbors[j].push_back(pieces[i]);
+    }
+
+    std::vector<Scene::Island> states(groups.size());
+    std::vector<std::string> outputs(regions.size());
+    _pool.run(groups.size(), [&](std::size_t index)
+              {
+                  // One buffer per thread, emptied after every operation
+                  thread_local std::ostringstream buffer;
+                  Scene::Island& island = states[index];
+                  island.scene = &scene;
+                  island.output = &buffer;
+                  Scene::enterIsland(&island);
+                  for (std::size_t i : groups[index])
+                  {
+                      island.operation = i;
+                      island.neighbors = neighbors[i];
+                      operation(i);
+                      outputs[i] = buffer.str();
+                      buffer.str({});
+                  }
+                  Scene::enterIsland(nullptr);
+              });
+
+    std::vector<Scene::Update> updates;
+    for (const auto& island : states)
+    {
+        updates.insert(updates.end(), island.updates.begin(), island.updates.end());
+    }
+    scene.applyUpdates(std::move(updates));
+    for (const auto& output : outputs)
+    {
+        Scene::output() << output;
+    }
+}
@@ -0,0 +1,67 @@
+/**
+ * @file IslandScheduler.h
+ *
+ * @brief Defines the IslandScheduler class, which moves and rotates independent pieces in parallel.
+ */
+
+#ifndef ISLANDSCHEDULER_H
+#define ISLANDSCHEDULER_H
+
+#include <functional>
+#include <span>
+#include <vector>
+#include "scene.h"
+#include "threadpool.h"
+
+class Polygon;
+
+/**
+ * @class IslandScheduler
+ * @brief Runs a batch of moves or rotations of distinct pieces on a ThreadPool.
+ *
+ * Each operation only reads and changes the components inside its region: the box swept by a
+ * move, or the box of the disc swept by a rotation. Operations whose regions overlap, directly
+ * or through others, form an island and run on one thread in the order of the batch; islands
+ * run on any thread, largest first. The broadphase of the Scene keeps its boxes from before
+ * the batch until all islands are done; their updates are then applied, and their messages
+ * printed, in the order of the batch. The pieces therefore end
+ * exactly where calling Polygon::move or Polygon::rotate on each one in turn leaves them, and
+ * the Scene holds the same broadphase, versions and change log.
+ */
+class IslandScheduler
+{
+public:
+    explicit IslandScheduler(std::size_t threadCount = std::thread::hardware_concurrency());
+
+    // Moves each piece toward its destination, as Polygon::move would in the order given
+    void move(Scene& scene, std::span<Polygon* const> pieces, std::span<const Point> destinations, double stepSize);
+    // Rotates each piece around its pivot, as Polygon::rotate would; returns the angle each piece reached
+    std::vector<double> rotate(Scene& scene, std::span<Polygon* const> pieces, std::span<const Point> pivots,
+                               double step, bool clockwise);
+
+    /**
+    * @brief Groups the operations whose regions overlap, directly or through others.
+    *
+    * The overlapping pairs are joined in a union-find.
+    *
+    * @return The islands, each listing its operations in increasing order, largest island first.
+    */
+    static std::vector<std::vector<std::size_t>> islands(std::span<const Broadphase::Box> regions);
+    // Pairs of operations whose regions overlap, the smaller index first
+    static std::vector<std::pair<std::size_t, std::size_t>> overlappingRegions(std::span<const Broadphase::Box> regions);
+
+    std::size_t threadCount() const { return _pool.threadCount(); }
+    // Number of islands of the last batch
+    std::size_t islandCount() const { return _islandCount; }
+
+private:
+    static std::vector<std::vector<std::size_t>> islands(std::size_t count, std::span<const std::pair<std::size_t, std::size_t>> pairs);
+    // Runs the operations, each changing only the piece with the matching id inside its region
+    void run(Scene& scene, std::span<const Broadphase::Box> regions, std::span<const Broadphase::Id> pieces,
+             const std::function<void(std::size_t)>& operation);
+
+    ThreadPool _pool;
+    std::size_t _islandCount = 0;
+};
+
+#endif // ISLANDSCHEDULER_H
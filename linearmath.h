@@ -1,6 +1,11 @@
 #ifndef LINEARMATH_H
 #define LINEARMATH_H
 
+#include <algorithm>
+#include <cmath>
+#include <optional>
+#include <span>
+#include <vector>
 #include "point.h"
 
 class LinearMath
@@ -18,7 +23,7 @@ public:
     struct LineSegment
     {
         LineSegment() {}
-        LineSegment(const Point& aStart, const Point& anEnd):
+        LineSegment(const Point2& aStart, const Point2& anEnd):
             startPoint{aStart}, endPoint{anEnd}
         {}
 
@@ -41,8 +46,174 @@ public:
             return equation.A * x + equation.C;
         }
 
-        Point startPoint, endPoint;
+        Point2 startPoint, endPoint;
     };
+
+    // Convex hull of the points in counterclockwise order (Andrew's monotone chain)
+    static std::vector<Point2> convexHull(std::span<const Point2> points)
+    {
+        std::vector<Point2> sorted(points.begin(), points.end());
+        std::sort(sorted.begin(), sorted.end(), [](const Point2& a, const Point2& b)
+                  {
+                      return a.getX() < b.getX() || (a.getX() == b.getX() && a.getY() < b.getY());
+                  });
+        sorted.erase(std::unique(sorted.begin(), sorted.end(), [](const Point2& a, const Point2& b)
+                                 {
+                                     return a.getX() == b.getX() && a.getY() == b.getY();
+                                 }), sorted.end());
+        if (sorted.size() < 3)
+        {
+            return sorted;
+        }
+
+        auto cross = [](const Point2& o, const Point2& a, const Point2& b)
+        {
+            return (a.getX() - o.getX()) * (b.getY() - o.getY()) - (a.getY() - o.getY()) * (b.getX() - o.getX());
+        };
+
+        std::vector<Point2> hull(2 * sorted.size());
+        std::size_t k = 0;
+        for (std::size_t i = 0; i < sorted.size(); ++i)
+        {
+            while (k >= 2 && cross(hull[k - 2], hull[k - 1], sorted[i]) <= 0)
+                --k;
+            hull[k++] = sorted[i];
+        }
+        for (std::size_t i = sorted.size() - 1, lower = k + 1; i > 0; --i)
+        {
+            while (k >= lower && cross(hull[k - 2], hull[k - 1], sorted[i - 1]) <= 0)
+                --k;
+            hull[k++] = sorted[i - 1];
+        }
+        hull.resize(k - 1);
+        return hull;
+    }
+
+    // Minkowski sum of two convex polygons given counterclockwise, merging their edges by angle in O(n + m)
+    static std::vector<Point2> minkowskiSum(std::span<const Point2> a, std::span<const Point2> b)
+    {
+        if (a.size() < 3 || b.size() < 3)
+        {
+            std::vector<Point2> sums;
+            for (const Point2& p : a)
+                for (const Point2& q : b)
+                    sums.emplace_back(p.getX() + q.getX(), p.getY() + q.getY());
+            return convexHull(sums);
+        }
+
+        // Both walks start at the lowest vertex, where the edge angles begin
+        auto lowest = [](std::span<const Point2> polygon)
+        {
+            return static_cast<std::size_t>(std::min_element(polygon.begin(), polygon.end(), [](const Point2& p, const Point2& q)
+                                                             {
+                                                                 return p.getY() < q.getY() || (p.getY() == q.getY() && p.getX() < q.getX());
+                                                             }) - polygon.begin());
+        };
+        const std::size_t n = a.size(), m = b.size();
+        const std::size_t a0 = lowest(a), b0 = lowest(b);
+        auto vertexA = [&](std::size_t i) -> const Point2& { return a[(a0 + i) % n]; };
+        auto vertexB = [&](std::size_t j) -> const Point2& { return b[(b0 + j) % m]; };
+
+        std::vector<Point2> sum;
+        sum.reserve(n + m);
+        std::size_t i = 0, j = 0;
+        while (i < n || j < m)
+        {
+            sum.emplace_back(vertexA(i).getX() + vertexB(j).getX(), vertexA(i).getY() + vertexB(j).getY());
+            const double edgeAX = vertexA(i + 1).getX() - vertexA(i).getX();
+            const double edgeAY = vertexA(i + 1).getY() - vertexA(i).getY();
+            const double edgeBX = vertexB(j + 1).getX() - vertexB(j).getX();
+            const double edgeBY = vertexB(j + 1).getY() - vertexB(j).getY();
+            const double cross = edgeAX * edgeBY - edgeAY * edgeBX;
+            // Parallel edges are merged into one; a finished polygon leaves the rest to the other
+            const bool advanceA = j == m || (i < n && cross >= 0);
+            const bool advanceB = i == n || (j < m && cross <= 0);
+            if (advanceA)
+                ++i;
+            if (advanceB)
+                ++j;
+        }
+        return sum;
+    }
+
+    // True if the point lies inside the counterclockwise convex polygon, farther than the inset from its edges
+    static bool containsPoint(std::span<const Point2> polygon, const Point2& point, double inset = 0.0)
+    {
+        if (polygon.size() < 3)
+            return false;
+
+        for (std::size_t i = 0; i < polygon.size(); ++i)
+        {
+            const Point2& a = polygon[i];
+            const Point2& b = polygon[(i + 1) % polygon.size()];
+            const double side = (b.getX() - a.getX()) * (point.getY() - a.getY()) - (b.getY() - a.getY()) * (point.getX() - a.getX());
+            if (side <= inset * a.calculateDistance(b))
+                return false;
+        }
+        return true;
+    }
+
+    /**
+     * Cyrus-Beck clipping of the segment start-end against a counterclockwise convex polygon
+     * shrunk by the inset, so that grazing an edge or a vertex does not count as entering.
+     * Returns the parameters, in [0, 1], at which the segment enters and leaves the interior.
+     */
+    static std::optional<std::pair<double, double>> clipSegment(std::span<const Point2> polygon, const Point2& start,
+                                                                const Point2& end, double inset = 0.0)
+    {
+        if (polygon.size() < 3)
+            return std::nullopt;
+
+        const double dx = end.getX() - start.getX();
+        const double dy = end.getY() - start.getY();
+        double enter = 0.0, leave = 1.0;
+        for (std::size_t i = 0; i < polygon.size(); ++i)
+        {
+            const Point2& a = polygon[i];
+            const Point2& b = polygon[(i + 1) % polygon.size()];
+            const double edgeLength = a.calculateDistance(b);
+            if (edgeLength == 0.0)
+                continue;
+
+            // Inward unit normal of a counterclockwise edge
+            const double nx = -(b.getY() - a.getY()) / edgeLength;
+            const double ny = (b.getX() - a.getX()) / edgeLength;
+            const double distance = nx * (start.getX() - a.getX()) + ny * (start.getY() - a.getY()) - inset;
+            const double speed = nx * dx + ny * dy;
+            if (speed == 0.0)
+            {
+                if (distance <= 0.0)
+                    return std::nullopt;
+                continue;
+            }
+
+            const double t = -distance / speed;
+            if (speed > 0.0)
+                enter = std::max(enter, t);
+            else
+                leave = std::min(leave, t);
+            if (enter >= leave)
+                return std::nullopt;
+        }
+        return std::make_pair(enter, leave);
+    }
+
+    // Distance from a point to the segment a-b
+    static double distanceToSegment(const Point2& point, const Point2& a, const Point2& b)
+    {
+        const double dx = b.getX() - a.getX();
+        const double dy = b.getY() - a.getY();
+        const double lengthSquared = dx * dx + dy * dy;
+        double t = 0.0;
+        if (lengthSquared > 0.0)
+        {
+            t = ((point.getX() - a.getX()) * dx + (point.getY() - a.getY()) * dy) / lengthSquared;
+            t = std::clamp(t, 0.0, 1.0);
+        }
+        const double px = a.getX() + t * dx - point.getX();
+        const double py = a.getY() + t * dy - point.getY();
+        return std::sqrt(px * px + py * py);
+    }
 };
 
 #endif // LINEARMATH_H
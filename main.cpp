@@ -1,4 +1,5 @@
 #include <iostream>
+#include <thread>
 
 #include "polygon.h"
 #include "game.h"
@@ -6,9 +7,8 @@
 int main()
 {
 
-    const auto& scene = Scene::getInstance();
-
-    Game game;
+    // Each match plays in a scene of its own
+    Game game(Scene::create());
 
     int numOfPlayingPieces = 2;
     double moveStep = 0.2;
@@ -17,7 +17,7 @@ int main()
     bool rotateCW = true;
 
     game.setEndPosition(Point(-12,8,0));
-    game.initGameEnv(scene);
+    game.initGameEnv();
     const auto& playerPieces = game.selectPlayerPiecesRandom(numOfPlayingPieces);
 
     for(const auto& playingPiece : playerPieces)
@@ -26,7 +26,12 @@ int main()
     }
     game.setMoveStepSize(moveStep);
     game.setRotateStepSize(angle);
+    // Every piece heads to the same end position: they share one flow field and move together
+    game.setNavigation(Game::Navigation::Cooperative);
+    // Pieces far apart move and rotate on different threads
+    game.setThreadCount(std::thread::hardware_concurrency());
     game.movePlayingPieces(playerPieces, game.endPosition());
+    game.reportCollisions();
     game.rotatePlayingPieces(playerPieces, angle, rotateCW, rotateAt);
     return 0;
 }
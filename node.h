@@ -11,18 +11,18 @@ public:
     Node(int xPos, int yPos, int dist, int priority);
 
 
-    // getters and setters
-    int getXPos() const;
-    void setXPos(int newXPos);
+    // getters and setters, defined inline because the A* open list compares nodes in its hot loop
+    int getXPos() const { return xPos; }
+    void setXPos(int newXPos) { xPos = newXPos; }
 
-    int getYPos() const;
-    void setYPos(int newYPos);
+    int getYPos() const { return yPos; }
+    void setYPos(int newYPos) { yPos = newYPos; }
 
-    int getLevel() const;
-    void setLevel(int newLevel);
+    int getLevel() const { return level; }
+    void setLevel(int newLevel) { level = newLevel; }
 
-    int getPriority() const;
-    void setPriority(int newPriority);
+    int getPriority() const { return priority; }
+    void setPriority(int newPriority) { priority = newPriority; }
 
 private:
     int xPos, yPos;
@@ -0,0 +1,274 @@
+#include "occupancygrid.h"
+#include "polygon.h"
+#include "linearmath.h"
+#include "scratcharena.h"
+
+OccupancyGrid::OccupancyGrid(const std::pair<Point, Point>& bounds, double cellSize) :
+    _origin{bounds.first}, _cellSize{cellSize}
+{
+    _width = static_cast<int>(std::ceil((bounds.second.getX() - bounds.first.getX()) / cellSize));
+    _height = static_cast<int>(std::ceil((bounds.second.getY() - bounds.first.getY()) / cellSize));
+    _cells.assign(static_cast<std::size_t>(_width) * _height, 0);
+}
+
+void OccupancyGrid::rasterize(const Scene& scene, std::span<const Shape* const> exclude, double inflation)
+{
+    clear();
+    // Straight through the pools, which keep the shapes of each kind next to each other
+    const auto excluded = [exclude](const Shape& shape)
+    {
+        return std::find(exclude.begin(), exclude.end(), &shape) != exclude.end();
+    };
+    scene.forEachPolygon([&](const Polygon& polygon)
+                         {
+                             if (!excluded(polygon))
+                             {
+                                 addPolygon(polygon.transformedVertices(), inflation);
+                             }
+                         });
+    scene.forEachCircularShape([&](const CircularShape& circularShape)
+                               {
+                                   if (!excluded(circularShape))
+                                   {
+                                       addCircularShape(circularShape, inflation, all());
+                                   }
+                               });
+}
+
+void OccupancyGrid::rasterize(const Scene& scene, std::span<const Shape* const> exclude, double inflation, const CellRange& range,
+                              std::vector<int>* changedCells)
+{
+    const CellRange clip = intersect(range, all());
+    if (clip.empty())
+    {
+        return;
+    }
+
+    const int rowLength = clip.maxX - clip.minX + 1;
+    std::vector<std::uint8_t> previous;
+    if (changedCells)
+    {
+        previous.reserve(static_cast<std::size_t>(rowLength) * (clip.maxY - clip.minY + 1));
+    }
+    for (int y = clip.minY; y <= clip.maxY; ++y)
+    {
+        const auto row = _cells.begin() + index(clip.minX, y);
+        if (changedCells)
+        {
+            previous.insert(previous.end(), row, row + rowLength);
+        }
+        std::fill_n(row, rowLength, 0);
+    }
+
+    // Components farther than the inflation from the range cannot reach it
+    auto [min, max] = boxOf(clip);
+    const Broadphase::Box region{Point2(min.getX() - inflation, min.getY() - inflation),
+                                 Point2(max.getX() + inflation, max.getY() + inflation)};
+    ScratchArena::Scope scope;
+    Broadphase::IdList ids(&scope.arena());
+    scene.overlappingShapes(region, ids);
+    for (Broadphase::Id id : ids)
+    {
+        const Shape* shape = scene.component(id).shape;
+        if (std::find(exclude.begin(), exclude.end(), shape) != exclude.end())
+        {
+            continue;
+        }
+        if (const auto* polygon = scene.polygon(id))
+        {
+            addPolygon(polygon->transformedVertices(), inflation, clip);
+        }
+        else if (const auto* circularShape = scene.circularShape(id))
+        {
+            addCircularShape(*circularShape, inflation, clip);
+        }
+    }
+    if (changedCells)
+    {
+        auto before = previous.begin();
+        for (int y = clip.minY; y <= clip.maxY; ++y)
+        {
+            for (int x = clip.minX; x <= clip.maxX; ++x, ++before)
+            {
+                if (*before != _cells[index(x, y)])
+                {
+                    changedCells->push_back(index(x, y));
+                }
+            }
+        }
+    }
+}
+
+void OccupancyGrid::addPolygon(std::span<const Point2> vertices, double inflation, const CellRange& clip)
+{
+    if (vertices.empty())
+    {
+        return;
+    }
+
+    const std::vector<Point2> hull = LinearMath::convexHull(vertices);
+    auto [min, max] = std::pair<Point2, Point2>(hull.front(), hull.front());
+    for (const Point2& vertex : hull)
+    {
+        min = Point2(std::min(min.getX(), vertex.getX()), std::min(min.getY(), vertex.getY()));
+        max = Point2(std::max(max.getX(), vertex.getX()), std::max(max.getY(), vertex.getY()));
+    }
+
+    const CellRange range = intersect(cellRange({Point(min.getX() - inflation, min.getY() - inflation),
+                                                 Point(max.getX() + inflation, max.getY() + inflation)}), clip);
+
+    for (int y = range.minY; y <= range.maxY; ++y)
+    {
+        for (int x = range.minX; x <= range.maxX; ++x)
+        {
+            if (_cells[index(x, y)])
+            {
+                continue;
+            }
+
+            const Point2 center(cellCenter(x, y));
+            bool inside = hull.size() >= 3;
+            double distance = INFINITY;
+            for (std::size_t i = 0; i < hull.size(); ++i)
+            {
+                const Point2& a = hull[i];
+                const Point2& b = hull[(i + 1) % hull.size()];
+                const double cross = (b.getX() - a.getX()) * (center.getY() - a.getY()) -
+                                     (b.getY() - a.getY()) * (center.getX() - a.getX());
+                if (cross < 0.0)
+                {
+                    inside = false;
+                }
+                distance = std::min(distance, LinearMath::distanceToSegment(center, a, b));
+            }
+
+            if (inside || distance <= inflation)
+            {
+                _cells[index(x, y)] = 1;
+            }
+        }
+    }
+}
+
+void OccupancyGrid::addDisc(const Point& center, double radius, const CellRange& clip)
+{
+    const CellRange range = intersect(cellRange({Point(center.getX() - radius, center.getY() - radius),
+                                                 Point(center.getX() + radius, center.getY() + radius)}), clip);
+
+    for (int y = range.minY; y <= range.maxY; ++y)
+    {
+        for (int x = range.minX; x <= range.maxX; ++x)
+        {
+            if (cellCenter(x, y).calculateDistance(Point(center.getX(), center.getY())) <= radius)
+            {
+                _cells[index(x, y)] = 1;
+            }
+        }
+    }
+}
+
+void OccupancyGrid::clear()
+{
+    std::fill(_cells.begin(), _cells.end(), 0);
+}
+
+void OccupancyGrid::setBlocked(int x, int y, bool blocked)
+{
+    if (contains(x, y))
+    {
+        _cells[index(x, y)] = blocked;
+    }
+}
+
+std::optional<std::pair<int, int>> OccupancyGrid::cellOf(const Point& point) const
+{
+    const int x = static_cast<int>(std::floor((point.getX() - _origin.getX()) / _cellSize));
+    const int y = static_cast<int>(std::floor((point.getY() - _origin.getY()) / _cellSize));
+    if (!contains(x, y))
+    {
+        return std::nullopt;
+    }
+    return std::make_pair(x, y);
+}
+
+Point OccupancyGrid::cellCenter(int x, int y) const
+{
+    return Point(_origin.getX() + (x + 0.5) * _cellSize, _origin.getY() + (y + 0.5) * _cellSize);
+}
+
+void OccupancyGrid::addCircularShape(const CircularShape& shape, double inflation, const CellRange& clip)
+{
+    // Ellipses are covered by the circle of their major radius, cut to their inflated bounding
+    // box so that the cells stay within the box of the component
+    const auto [min, max] = shape.calculateBoundingBox();
+    const CellRange box = cellRange({Point(min.getX() - inflation, min.getY() - inflation),
+                                     Point(max.getX() + inflation, max.getY() + inflation)});
+    addDisc(shape.center(), shape.getRadius() + inflation, intersect(box, clip));
+}
+
+OccupancyGrid::CellRange OccupancyGrid::cellRange(const std::pair<Point, Point>& box) const
+{
+    const auto& [min, max] = box;
+    return {std::max(0, static_cast<int>(std::floor((min.getX() - _origin.getX()) / _cellSize))),
+            std::max(0, static_cast<int>(std::floor((min.getY() - _origin.getY()) / _cellSize))),
+            std::min(_width - 1, static_cast<int>(std::floor((max.getX() - _origin.getX()) / _cellSize))),
+            std::min(_height - 1, static_cast<int>(std::floor((max.getY() - _origin.getY()) / _cellSize)))};
+}
+
+std::pair<Point, Point> OccupancyGrid::boxOf(const CellRange& range) const
+{
+    return {Point(_origin.getX() + range.minX * _cellSize, _origin.getY() + range.minY * _cellSize),
+            Point(_origin.getX() + (range.maxX + 1) * _cellSize, _origin.getY() + (range.maxY + 1) * _cellSize)};
+}
+
+void CellMarks::clear(std::size_t cellCount)
+{
+    // Stamps added for a larger grid are 0, which no generation after the first increment uses
+    if (_stamp.size() < cellCount)
+    {
+        _stamp.resize(cellCount, 0);
+    }
+    if (++_generation == 0)
+    {
+        std::fill(_stamp.begin(), _stamp.end(), 0);
+        _generation = 1;
+    }
+    _queue.clear();
+}
+
+void OccupancyGrid::freeCellsAround(int x, int y, CellMarks& marks, std::vector<int>& freeCells) const
+{
+    freeCells.clear();
+    if (!contains(x, y))
+    {
+        return;
+    }
+
+    marks.clear(_cells.size());
+    std::vector<int>& blocked = marks.queue();
+    blocked.push_back(index(x, y));
+    marks.mark(blocked.front());
+    for (std::size_t i = 0; i < blocked.size(); ++i)
+    {
+        const int cellX = blocked[i] % _width;
+        const int cellY = blocked[i] / _width;
+        for (int dy = -1; dy <= 1; ++dy)
+        {
+            for (int dx = -1; dx <= 1; ++dx)
+            {
+                if (!contains(cellX + dx, cellY + dy) || marks.isMarked(index(cellX + dx, cellY + dy)))
+                {
+                    continue;
+                }
+                const int neighbor = index(cellX + dx, cellY + dy);
+                marks.mark(neighbor);
+                (_cells[neighbor] ? blocked : freeCells).push_back(neighbor);
+            }
+        }
+    }
+}
+
+OccupancyGrid::CellRange OccupancyGrid::intersect(const CellRange& a, const CellRange& b)
+{
+    return {std::max(a.minX, b.minX), std::max(a.minY, b.minY), std::min(a.maxX, b.maxX), std::min(a.maxY, b.maxY)};
+}
@@ -0,0 +1,140 @@
+/**
+ * @file OccupancyGrid.h
+ *
+ * @brief Defines the OccupancyGrid class, the blocked/free cell map searched by PathFinding.
+ */
+
+#ifndef OCCUPANCYGRID_H
+#define OCCUPANCYGRID_H
+
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <vector>
+#include "point.h"
+
+class CircularShape;
+class Scene;
+class Shape;
+
+/**
+ * @class CellMarks
+ * @brief Marks the cells visited by a flood fill; unmarking all of them takes constant time.
+ *
+ * A cell is marked while its stamp equals the current generation, so clear() only advances the
+ * generation. The stamps and the queue of the flood are kept between floods, so reusing the
+ * same marks does not allocate or touch every cell once they cover the grid.
+ */
+class CellMarks
+{
+public:
+    // Unmarks every cell of a grid of the given size and empties the queue
+    void clear(std::size_t cellCount);
+    bool isMarked(int cell) const { return _stamp[cell] == _generation; }
+    void mark(int cell) { _stamp[cell] = _generation; }
+    // Cells waiting to be visited by the flood in progress
+    std::vector<int>& queue() { return _queue; }
+
+private:
+    std::vector<std::uint32_t> _stamp;
+    std::uint32_t _generation = 0;
+    std::vector<int> _queue;
+};
+
+/**
+ * @class OccupancyGrid
+ * @brief Square cells covering the Scene area, each either blocked or free.
+ *
+ * Obstacles are inflated by the bounding radius of the moving piece before they are
+ * rasterized, so a piece whose center stays on free cells cannot touch any obstacle.
+ * Cells are stored row by row; a cell id is y * width + x.
+ */
+class OccupancyGrid
+{
+public:
+    // Inclusive rectangle of cells
+    struct CellRange
+    {
+        int minX = 0, minY = 0, maxX = -1, maxY = -1;
+
+        bool empty() const { return minX > maxX || minY > maxY; }
+    };
+
+    OccupancyGrid() = default;
+
+    /**
+    * @brief Constructor for OccupancyGrid.
+    * @param bounds Minimum and maximum corners of the covered area.
+    * @param cellSize Edge length of a cell in scene units.
+    */
+    OccupancyGrid(const std::pair<Point, Point>& bounds, double cellSize);
+
+    /**
+    * @brief Marks the cells covered by the obstacles of the scene.
+    *
+    * @param scene The Scene whose components are rasterized.
+    * @param exclude The components to leave out, usually the moving pieces themselves.
+    * @param inflation Distance by which the obstacles are grown.
+    */
+    void rasterize(const Scene& scene, std::span<const Shape* const> exclude, double inflation);
+    void rasterize(const Scene& scene, const Shape* exclude, double inflation) { rasterize(scene, {&exclude, 1}, inflation); }
+
+    /**
+    * @brief Rasterizes the obstacles again within a range of cells only.
+    *
+    * Used after a component moved or rotated: the cells of the range are cleared and every
+    * component whose inflated bounding box reaches the range is drawn clipped to it.
+    *
+    * @param changedCells If given, receives the ids of the cells whose state changed.
+    */
+    void rasterize(const Scene& scene, std::span<const Shape* const> exclude, double inflation, const CellRange& range,
+                   std::vector<int>* changedCells = nullptr);
+    void rasterize(const Scene& scene, const Shape* exclude, double inflation, const CellRange& range,
+                   std::vector<int>* changedCells = nullptr)
+    {
+        rasterize(scene, {&exclude, 1}, inflation, range, changedCells);
+    }
+
+    // Marks the cells, within the clip range, whose center lies inside the convex hull of the
+    // vertices or within the inflation distance of it
+    void addPolygon(std::span<const Point2> vertices, double inflation, const CellRange& clip);
+    void addPolygon(std::span<const Point2> vertices, double inflation) { addPolygon(vertices, inflation, all()); }
+    void addDisc(const Point& center, double radius, const CellRange& clip);
+    void addDisc(const Point& center, double radius) { addDisc(center, radius, all()); }
+    void clear();
+
+    int width() const { return _width; }
+    int height() const { return _height; }
+    double cellSize() const { return _cellSize; }
+    int cellCount() const { return _width * _height; }
+    int index(int x, int y) const { return y * _width + x; }
+
+    bool contains(int x, int y) const { return x >= 0 && y >= 0 && x < _width && y < _height; }
+    // Cells outside the grid count as blocked
+    bool isBlocked(int x, int y) const { return !contains(x, y) || _cells[index(x, y)]; }
+    void setBlocked(int x, int y, bool blocked);
+
+    // Cell containing the point, if it lies inside the grid
+    std::optional<std::pair<int, int>> cellOf(const Point& point) const;
+    Point cellCenter(int x, int y) const;
+    // Cells covered by a box, clamped to the grid
+    CellRange cellRange(const std::pair<Point, Point>& box) const;
+    // Box covered by a range of cells
+    std::pair<Point, Point> boxOf(const CellRange& range) const;
+    CellRange all() const { return {0, 0, _width - 1, _height - 1}; }
+    // Ids of the free cells bordering the blocked area that holds a blocked cell, in the order a
+    // flood fill over the blocked cells connected to it meets them; the flood uses the marks given
+    void freeCellsAround(int x, int y, CellMarks& marks, std::vector<int>& freeCells) const;
+
+private:
+    void addCircularShape(const CircularShape& shape, double inflation, const CellRange& clip);
+    static CellRange intersect(const CellRange& a, const CellRange& b);
+
+    Point _origin;
+    double _cellSize = 1.0;
+    int _width = 0;
+    int _height = 0;
+    std::vector<std::uint8_t> _cells;
+};
+
+#endif // OCCUPANCYGRID_H
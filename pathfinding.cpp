@@ -1,3 +1,916 @@
 #include "pathfinding.h"
+#include "polygon.h"
+#include "linearmath.h"
 
-PathFinding::PathFinding() {}
+namespace
+{
+// Heap order: lowest priority first, ties broken towards the node farther from the start
+struct LowerPriority
+{
+    bool operator()(const Node& a, const Node& b) const
+    {
+        if (a.getPriority() != b.getPriority())
+        {
+            return a.getPriority() > b.getPriority();
+        }
+        return a.getLevel() < b.getLevel();
+    }
+};
+
+// Straight directions first, then the diagonals
+constexpr int DIRECTIONS = 8;
+constexpr int DX[DIRECTIONS] = {1, 0, -1, 0, 1, -1, -1, 1};
+constexpr int DY[DIRECTIONS] = {0, 1, 0, -1, 1, 1, -1, -1};
+
+int sign(int value)
+{
+    return (value > 0) - (value < 0);
+}
+
+int directionOf(int dx, int dy)
+{
+    for (int direction = 0; direction < DIRECTIONS; ++direction)
+    {
+        if (DX[direction] == dx && DY[direction] == dy)
+        {
+            return direction;
+        }
+    }
+    return -1;
+}
+
+// The start if a search can step out of it, otherwise the free cell closest to it around the
+// blocked area that holds it: the inflation by the bounding radius is conservative, so a piece
+// whose neighbor cells are all blocked may still be able to move there
+std::optional<std::pair<int, int>> leavableStart(const OccupancyGrid& grid, const std::pair<int, int>& start,
+                                                 CellMarks& marks, std::vector<int>& freeCells)
+{
+    const auto [x, y] = start;
+    if (!grid.isBlocked(x, y))
+    {
+        return start;
+    }
+    for (int direction = 0; direction < DIRECTIONS; ++direction)
+    {
+        const int nx = x + DX[direction];
+        const int ny = y + DY[direction];
+        if (!grid.isBlocked(nx, ny) && (direction < 4 || (!grid.isBlocked(nx, y) && !grid.isBlocked(x, ny))))
+        {
+            return start;
+        }
+    }
+
+    std::optional<std::pair<int, int>> nearest;
+    long long nearestDistance = 0;
+    grid.freeCellsAround(x, y, marks, freeCells);
+    for (int cell : freeCells)
+    {
+        const long long dx = cell % grid.width() - x;
+        const long long dy = cell / grid.width() - y;
+        if (!nearest || dx * dx + dy * dy < nearestDistance)
+        {
+            nearest = {cell % grid.width(), cell / grid.width()};
+            nearestDistance = dx * dx + dy * dy;
+        }
+    }
+    return nearest;
+}
+
+// The goal if it is free, otherwise the free cell closest to it among those reachable from the
+// start with the moves of the searches; empty if the start cannot move at all
+std::optional<std::pair<int, int>> reachableGoal(const OccupancyGrid& grid, const std::pair<int, int>& start,
+                                                 const std::pair<int, int>& goal, CellMarks& marks)
+{
+    if (!grid.isBlocked(goal.first, goal.second))
+    {
+        return goal;
+    }
+
+    std::optional<std::pair<int, int>> nearest;
+    long long nearestDistance = 0;
+    marks.clear(grid.cellCount());
+    std::vector<int>& cells = marks.queue();
+    cells.push_back(grid.index(start.first, start.second));
+    marks.mark(cells.front());
+    for (std::size_t i = 0; i < cells.size(); ++i)
+    {
+        const int x = cells[i] % grid.width();
+        const int y = cells[i] / grid.width();
+        if (!grid.isBlocked(x, y))
+        {
+            const long long dx = x - goal.first;
+            const long long dy = y - goal.second;
+            if (!nearest || dx * dx + dy * dy < nearestDistance)
+            {
+                nearest = {x, y};
+                nearestDistance = dx * dx + dy * dy;
+            }
+        }
+        for (int direction = 0; direction < DIRECTIONS; ++direction)
+        {
+            const int nx = x + DX[direction];
+            const int ny = y + DY[direction];
+            if (grid.isBlocked(nx, ny) || marks.isMarked(grid.index(nx, ny))
+                || (direction >= 4 && (grid.isBlocked(nx, y) || grid.isBlocked(x, ny))))
+            {
+                continue;
+            }
+            marks.mark(grid.index(nx, ny));
+            cells.push_back(grid.index(nx, ny));
+        }
+    }
+    return nearest;
+}
+}
+
+PathFinding::PathFinding(double cellSize, Algorithm algorithm) : _cellSize{cellSize}, _algorithm{algorithm} {}
+
+void PathFinding::buildGrid(const Scene& scene, const Polygon& piece)
+{
+    if (_grid.cellCount() == 0)
+    {
+        _grid = OccupancyGrid(scene.bounds(), _cellSize);
+    }
+
+    const double inflation = inflationOf(piece);
+
+    if (_gridPiece == piece.componentId() && _gridInflation == inflation)
+    {
+        // A component changes the cells within the inflation of its old and new bounding boxes
+        for (const auto& [min, max] : scene.changedRegions(_gridChanges))
+        {
+            const auto range = _grid.cellRange({Point(min.getX() - inflation, min.getY() - inflation),
+                                                Point(max.getX() + inflation, max.getY() + inflation)});
+            _grid.rasterize(scene, &piece, inflation, range);
+            _clusterGraph.invalidate(range);
+            _jumpTableValid = false;
+        }
+    }
+    else
+    {
+        _grid.rasterize(scene, &piece, inflation);
+        _clusterGraph.invalidateAll();
+        _jumpTableValid = false;
+        _gridPiece = piece.componentId();
+        _gridInflation = inflation;
+    }
+    _gridChanges = scene.changeCount();
+}
+
+std::vector<Point> PathFinding::replan(const Scene& scene, const Polygon& piece, const Point& goal)
+{
+    _expandedNodes = 0;
+    Replanner& replanner = _replanners[piece.componentId()];
+    OccupancyGrid& grid = replanner.grid;
+    const double inflation = inflationOf(piece);
+
+    std::vector<int> changedCells;
+    if (grid.cellCount() == 0 || replanner.inflation != inflation)
+    {
+        grid = OccupancyGrid(scene.bounds(), _cellSize);
+        grid.rasterize(scene, &piece, inflation);
+        replanner.inflation = inflation;
+        replanner.search = DStarLite();
+    }
+    else
+    {
+        for (const auto& [min, max] : scene.changedRegions(replanner.sceneChanges))
+        {
+            grid.rasterize(scene, &piece, inflation,
+                           grid.cellRange({Point(min.getX() - inflation, min.getY() - inflation),
+                                           Point(max.getX() + inflation, max.getY() + inflation)}),
+                           &changedCells);
+        }
+        // Overlapping regions may report a cell twice
+        std::sort(changedCells.begin(), changedCells.end());
+        changedCells.erase(std::unique(changedCells.begin(), changedCells.end()), changedCells.end());
+    }
+    replanner.sceneChanges = scene.changeCount();
+
+    const auto startCell = grid.cellOf(piece.getCenter());
+    const auto requestedCell = grid.cellOf(goal);
+    if (!startCell || !requestedCell)
+    {
+        return {};
+    }
+    const auto searchStart = leavableStart(grid, *startCell, _marks, _freeCells);
+    const auto goalCell = searchStart ? reachableGoal(grid, *searchStart, *requestedCell, _marks) : std::nullopt;
+    if (!goalCell)
+    {
+        return {};
+    }
+
+    auto cells = replanner.search.plan(grid, *searchStart, *goalCell, changedCells);
+    _expandedNodes = replanner.search.expandedNodes();
+    if (cells.empty())
+    {
+        return {};
+    }
+    if (*searchStart != *startCell)
+    {
+        cells.insert(cells.begin(), grid.index(startCell->first, startCell->second));
+    }
+    return directionChanges(grid, cells, goal);
+}
+
+void PathFinding::buildVisibilityGraph(Scene& scene, const Polygon& piece)
+{
+    const auto& space = scene.configurationSpace(piece);
+    // The graph only depends on the obstacles, which survive translations of the piece
+    if (_visibilityPiece == piece.componentId() && _visibilityRevision == space.revision)
+    {
+        return;
+    }
+
+    _visibilityGraph.build(space.obstacles);
+    _visibilityPiece = piece.componentId();
+    _visibilityRevision = space.revision;
+}
+
+void PathFinding::buildFlowField(const Scene& scene, std::span<const Polygon* const> pieces, const Point& goal)
+{
+    std::vector<const Shape*> exclude(pieces.begin(), pieces.end());
+    std::vector<std::size_t> pieceIds;
+    double inflation = 0.0;
+    for (const Polygon* piece : pieces)
+    {
+        pieceIds.push_back(piece->componentId());
+        inflation = std::max(inflation, inflationOf(*piece));
+    }
+    std::sort(pieceIds.begin(), pieceIds.end());
+
+    std::vector<int> changedCells;
+    bool rebuilt = false;
+    if (_flowGrid.cellCount() == 0 || pieceIds != _flowPieces || inflation != _flowInflation)
+    {
+        _flowGrid = OccupancyGrid(scene.bounds(), _cellSize);
+        _flowGrid.rasterize(scene, exclude, inflation);
+        _flowPieces = std::move(pieceIds);
+        _flowInflation = inflation;
+        rebuilt = true;
+    }
+    else
+    {
+        for (const auto& [min, max] : scene.changedRegions(_flowChanges))
+        {
+            _flowGrid.rasterize(scene, exclude, inflation,
+                                _flowGrid.cellRange({Point(min.getX() - inflation, min.getY() - inflation),
+                                                     Point(max.getX() + inflation, max.getY() + inflation)}),
+                                &changedCells);
+        }
+        std::sort(changedCells.begin(), changedCells.end());
+        changedCells.erase(std::unique(changedCells.begin(), changedCells.end()), changedCells.end());
+    }
+    _flowChanges = scene.changeCount();
+
+    const auto goalCell = _flowGrid.cellOf(goal);
+    if (!goalCell)
+    {
+        _flowField = FlowField();
+        _expandedNodes = 0;
+        return;
+    }
+    if (rebuilt || !_flowField.isComputed() || _flowField.goal() != *goalCell)
+    {
+        _flowField.compute(_flowGrid, *goalCell);
+    }
+    else if (!changedCells.empty())
+    {
+        _flowField.update(_flowGrid, changedCells);
+    }
+    _flowGoal = goal;
+    _expandedNodes = _flowField.expandedNodes();
+}
+
+std::vector<Point> PathFinding::followFlowField(const Point& start) const
+{
+    const auto startCell = _flowGrid.cellOf(start);
+    if (!startCell)
+    {
+        return {};
+    }
+    const auto cells = _flowField.path(_flowGrid, *startCell);
+    if (cells.empty())
+    {
+        return {};
+    }
+    return directionChanges(_flowGrid, cells, _flowGoal);
+}
+
+std::optional<Point> PathFinding::flowStep(const Point& position) const
+{
+    const auto cell = _flowGrid.cellOf(position);
+    if (!cell || !_flowField.isComputed())
+    {
+        return std::nullopt;
+    }
+    const int id = _flowGrid.index(cell->first, cell->second);
+    if (_flowField.isTarget(id))
+    {
+        return _flowGoal;
+    }
+    if (_flowGrid.isBlocked(cell->first, cell->second))
+    {
+        // Leaving a blocked cell needs a look at its neighbors
+        const auto cells = _flowField.path(_flowGrid, *cell);
+        if (cells.size() < 2)
+        {
+            return std::nullopt;
+        }
+        return _flowGrid.cellCenter(cells[1] % _flowGrid.width(), cells[1] / _flowGrid.width());
+    }
+    const int direction = _flowField.direction(id);
+    if (direction < 0)
+    {
+        return std::nullopt;
+    }
+    return _flowGrid.cellCenter(cell->first + DX[direction], cell->second + DY[direction]);
+}
+
+std::vector<std::vector<Point>> PathFinding::planCooperative(const Scene& scene, std::span<const Polygon* const> pieces,
+                                                             const Point& goal, int window)
+{
+    buildFlowField(scene, pieces, goal);
+    std::vector<std::vector<Point>> plans(pieces.size());
+    std::vector<double> radii;
+    for (const Polygon* piece : pieces)
+    {
+        radii.push_back(inflationOf(*piece));
+    }
+    const double largest = radii.empty() ? 1.0 : *std::max_element(radii.begin(), radii.end());
+    _reservations.reset(2 * largest);
+    // The pieces that have not planned yet are expected to wait where they stand
+    for (std::size_t i = 0; i < pieces.size(); ++i)
+    {
+        _reservations.reserveStanding(i, pieces[i]->getCenter(), radii[i]);
+    }
+
+    std::size_t expanded = 0;
+    for (std::size_t i = 0; i < pieces.size(); ++i)
+    {
+        const auto start = _flowGrid.cellOf(pieces[i]->getCenter());
+        if (!start)
+        {
+            continue;
+        }
+        _reservations.release(i);
+        const auto cells = searchWindow(i, *start, radii[i], window);
+        expanded += _expandedNodes;
+        _reservations.reserve(i, 0, pieces[i]->getCenter(), radii[i]);
+        for (int time = 0; time <= window; ++time)
+        {
+            const Point center = _flowGrid.cellCenter(cells[time] % _flowGrid.width(), cells[time] / _flowGrid.width());
+            plans[i].push_back(center);
+            if (time > 0)
+            {
+                _reservations.reserve(i, time, center, radii[i]);
+            }
+        }
+    }
+    _expandedNodes = expanded;
+    return plans;
+}
+
+std::vector<int> PathFinding::searchWindow(std::size_t agent, const std::pair<int, int>& start, double radius, int window)
+{
+    // Cells the field cannot lead to the goal from are only entered when nothing else is free
+    constexpr int FAR = 1 << 28;
+    const auto estimate = [this](int cell)
+    {
+        const int distance = _flowField.distance(cell);
+        return distance == FlowField::UNREACHABLE ? FAR : distance;
+    };
+    const int width = _flowGrid.width();
+    const int startCell = _flowGrid.index(start.first, start.second);
+
+    _windowOpen.clear();
+    _windowCells.clear();
+    _windowTimes.clear();
+    _windowCosts.clear();
+    _windowParents.clear();
+    _windowStates.clear();
+    _expandedNodes = 0;
+    const auto addState = [&](int cell, int time, int cost, int parent)
+    {
+        const std::int64_t key = static_cast<std::int64_t>(cell) * (window + 1) + time;
+        const auto [found, inserted] = _windowStates.try_emplace(key, static_cast<int>(_windowCells.size()));
+        const int state = found->second;
+        if (inserted)
+        {
+            _windowCells.push_back(cell);
+            _windowTimes.push_back(time);
+            _windowCosts.push_back(cost);
+            _windowParents.push_back(parent);
+        }
+        else if (cost < _windowCosts[state])
+        {
+            _windowCosts[state] = cost;
+            _windowParents[state] = parent;
+        }
+        else
+        {
+            return;
+        }
+        // Ties go to the states later in the window
+        _windowOpen.emplace_back(cost + estimate(cell), -time, state);
+        std::push_heap(_windowOpen.begin(), _windowOpen.end(), std::greater<>{});
+    };
+
+    addState(startCell, 0, 0, -1);
+    int last = -1;
+    while (!_windowOpen.empty())
+    {
+        std::pop_heap(_windowOpen.begin(), _windowOpen.end(), std::greater<>{});
+        const auto [priority, negativeTime, state] = _windowOpen.back();
+        _windowOpen.pop_back();
+        const int cell = _windowCells[state];
+        const int time = _windowTimes[state];
+        const int cost = _windowCosts[state];
+        if (priority != cost + estimate(cell))
+        {
+            continue;
+        }
+        if (time == window)
+        {
+            last = state;
+            break;
+        }
+
+        ++_expandedNodes;
+        const int x = cell % width;
+        const int y = cell / width;
+        const Point from = _flowGrid.cellCenter(x, y);
+        // Waiting is free only on a target of the field, and a blocked start may still be waited on
+        for (int direction = -1; direction < DIRECTIONS; ++direction)
+        {
+            const int nx = direction < 0 ? x : x + DX[direction];
+            const int ny = direction < 0 ? y : y + DY[direction];
+            int step = _flowField.isTarget(cell) ? 0 : STRAIGHT_COST;
+            if (direction >= 0)
+            {
+                if (_flowGrid.isBlocked(nx, ny)
+                    || (direction >= 4 && (_flowGrid.isBlocked(nx, y) || _flowGrid.isBlocked(x, ny))))
+                {
+                    continue;
+                }
+                step = direction >= 4 ? DIAGONAL_COST : STRAIGHT_COST;
+            }
+            const Point to = _flowGrid.cellCenter(nx, ny);
+            // The pieces move in the planning order within a time step: the earlier ones leave
+            // their cells before this step and reach their next ones before the following step
+            if (!_reservations.isFree(agent, time, time + 2, from, to, radius))
+            {
+                continue;
+            }
+            addState(_flowGrid.index(nx, ny), time + 1, cost + step, state);
+        }
+    }
+
+    std::vector<int> cells(window + 1, startCell);
+    for (int state = last; state >= 0; state = _windowParents[state])
+    {
+        cells[_windowTimes[state]] = _windowCells[state];
+    }
+    return cells;
+}
+
+std::vector<Point> PathFinding::findHierarchicalPath(const Point& start, const Point& goal)
+{
+    const auto startCell = _grid.cellOf(start);
+    const auto goalCell = _grid.cellOf(goal);
+    if (!startCell || !goalCell)
+    {
+        return {};
+    }
+
+    const auto cells = _clusterGraph.findPath(_grid, *startCell, *goalCell);
+    _expandedNodes = _clusterGraph.expandedNodes();
+    if (cells.empty())
+    {
+        return {};
+    }
+
+    std::vector<Point> waypoints;
+    for (std::size_t i = 1; i + 1 < cells.size(); ++i)
+    {
+        waypoints.push_back(_grid.cellCenter(cells[i].first, cells[i].second));
+    }
+    waypoints.push_back(goal);
+    return waypoints;
+}
+
+std::vector<Point> PathFinding::refineHierarchicalPath(const Point& from, const Point& to)
+{
+    const auto fromCell = _grid.cellOf(from);
+    const auto toCell = _grid.cellOf(to);
+    if (!fromCell || !toCell)
+    {
+        return {};
+    }
+
+    const auto cells = _clusterGraph.refine(_grid, *fromCell, *toCell);
+    if (cells.empty() && fromCell != toCell)
+    {
+        return {};
+    }
+
+    std::vector<int> ids{_grid.index(fromCell->first, fromCell->second)};
+    for (const auto& [x, y] : cells)
+    {
+        ids.push_back(_grid.index(x, y));
+    }
+    return directionChanges(_grid, ids, to);
+}
+
+std::vector<Point> PathFinding::findAnyAnglePath(const Point& start, const Point& goal) const
+{
+    return _visibilityGraph.findPath(start, goal);
+}
+
+std::vector<Point> PathFinding::findPath(const Point& start, const Point& goal)
+{
+    _expandedNodes = 0;
+    const auto startCell = _grid.cellOf(start);
+    const auto requestedCell = _grid.cellOf(goal);
+    if (!startCell || !requestedCell)
+    {
+        return {};
+    }
+    // An end position next to a shape lies in the inflation band: the search stops at the
+    // closest free cell and the last waypoint still is the end position
+    const auto searchStart = leavableStart(_grid, *startCell, _marks, _freeCells);
+    const auto goalCell = searchStart ? reachableGoal(_grid, *searchStart, *requestedCell, _marks) : std::nullopt;
+    if (!goalCell)
+    {
+        return {};
+    }
+
+    if (_algorithm == Algorithm::JumpPointSearchPlus && !_jumpTableValid)
+    {
+        buildJumpTable();
+    }
+
+    prepareSearch();
+    _goalX = goalCell->first;
+    _goalY = goalCell->second;
+    const int originId = _grid.index(startCell->first, startCell->second);
+    const int startId = _grid.index(searchStart->first, searchStart->second);
+    const int goalId = _grid.index(_goalX, _goalY);
+    relax(searchStart->first, searchStart->second, 0, startId);
+
+    while (!_open.empty())
+    {
+        std::pop_heap(_open.begin(), _open.end(), LowerPriority{});
+        const Node node = _open.back();
+        _open.pop_back();
+
+        const int id = _grid.index(node.getXPos(), node.getYPos());
+        // Stale entry, the cell was reached more cheaply after it was pushed
+        if (node.getLevel() > _cost[id])
+        {
+            continue;
+        }
+        ++_expandedNodes;
+        if (id == goalId)
+        {
+            return buildWaypoints(originId, startId, goalId, goal);
+        }
+
+        if (_algorithm == Algorithm::AStar)
+        {
+            expandNeighbors(node);
+        }
+        else
+        {
+            expandJumpPoints(node);
+        }
+    }
+    return {};
+}
+
+void PathFinding::expandNeighbors(const Node& node)
+{
+    const int x = node.getXPos();
+    const int y = node.getYPos();
+    const int id = _grid.index(x, y);
+    for (int direction = 0; direction < DIRECTIONS; ++direction)
+    {
+        const int nx = x + DX[direction];
+        const int ny = y + DY[direction];
+        if (_grid.isBlocked(nx, ny))
+        {
+            continue;
+        }
+
+        const bool diagonal = direction >= 4;
+        // No corner cutting: both orthogonal neighbors of a diagonal step must be free
+        if (diagonal && (_grid.isBlocked(nx, y) || _grid.isBlocked(x, ny)))
+        {
+            continue;
+        }
+        relax(nx, ny, node.getLevel() + (diagonal ? DIAGONAL_COST : STRAIGHT_COST), id);
+    }
+}
+
+void PathFinding::expandJumpPoints(const Node& node)
+{
+    const int x = node.getXPos();
+    const int y = node.getYPos();
+    const int id = _grid.index(x, y);
+
+    int directions[DIRECTIONS];
+    const int count = prunedDirections(x, y, id, directions);
+    for (int i = 0; i < count; ++i)
+    {
+        const int jumpId = _algorithm == Algorithm::JumpPointSearchPlus ? jumpPlus(x, y, directions[i])
+                                                                         : jump(x, y, directions[i]);
+        if (jumpId < 0)
+        {
+            continue;
+        }
+
+        // Segments between jump points are straight or diagonal, so the octile distance is exact
+        const int jx = jumpId % _grid.width();
+        const int jy = jumpId / _grid.width();
+        relax(jx, jy, node.getLevel() + heuristic(x, y, jx, jy), id);
+    }
+}
+
+int PathFinding::prunedDirections(int x, int y, int id, int* directions) const
+{
+    if (_parent[id] == id)
+    {
+        for (int direction = 0; direction < DIRECTIONS; ++direction)
+        {
+            directions[direction] = direction;
+        }
+        return DIRECTIONS;
+    }
+
+    const int width = _grid.width();
+    const int dx = sign(x - _parent[id] % width);
+    const int dy = sign(y - _parent[id] / width);
+    int count = 0;
+    if (dx != 0 && dy != 0)
+    {
+        // Without corner cutting a diagonal move has no forced neighbors
+        directions[count++] = directionOf(dx, 0);
+        directions[count++] = directionOf(0, dy);
+        directions[count++] = directionOf(dx, dy);
+        return count;
+    }
+
+    directions[count++] = directionOf(dx, dy);
+    // A side cell is forced when the cell behind it is blocked, as it could not be reached
+    // as cheaply without passing through this one
+    for (int side = -1; side <= 1; side += 2)
+    {
+        const int sx = dx == 0 ? side : 0;
+        const int sy = dy == 0 ? side : 0;
+        if (!_grid.isBlocked(x + sx, y + sy) && _grid.isBlocked(x + sx - dx, y + sy - dy))
+        {
+            directions[count++] = directionOf(sx, sy);
+            directions[count++] = directionOf(dx + sx, dy + sy);
+        }
+    }
+    return count;
+}
+
+int PathFinding::jump(int x, int y, int direction) const
+{
+    const int dx = DX[direction];
+    const int dy = DY[direction];
+    if (dx == 0 || dy == 0)
+    {
+        return jumpStraight(x, y, dx, dy);
+    }
+
+    while (true)
+    {
+        if (_grid.isBlocked(x + dx, y) || _grid.isBlocked(x, y + dy))
+        {
+            return -1;
+        }
+        x += dx;
+        y += dy;
+        if (_grid.isBlocked(x, y))
+        {
+            return -1;
+        }
+        if ((x == _goalX && y == _goalY) || jumpStraight(x, y, dx, 0) >= 0 || jumpStraight(x, y, 0, dy) >= 0)
+        {
+            return _grid.index(x, y);
+        }
+    }
+}
+
+int PathFinding::jumpStraight(int x, int y, int dx, int dy) const
+{
+    while (true)
+    {
+        x += dx;
+        y += dy;
+        if (_grid.isBlocked(x, y))
+        {
+            return -1;
+        }
+        if ((x == _goalX && y == _goalY) || hasForcedNeighbor(x, y, dx, dy))
+        {
+            return _grid.index(x, y);
+        }
+    }
+}
+
+int PathFinding::jumpPlus(int x, int y, int direction) const
+{
+    const int dx = DX[direction];
+    const int dy = DY[direction];
+    const int distance = _jumpTable[static_cast<std::size_t>(_grid.index(x, y)) * DIRECTIONS + direction];
+    const int freeCells = std::abs(distance);
+
+    // The table ignores the goal, so stop where the scan passes it or lines up with it
+    const int goalDx = _goalX - x;
+    const int goalDy = _goalY - y;
+    if (dx == 0 || dy == 0)
+    {
+        const bool onLine = dx == 0 ? (goalDx == 0 && sign(goalDy) == dy) : (goalDy == 0 && sign(goalDx) == dx);
+        if (onLine && std::abs(goalDx + goalDy) <= freeCells)
+        {
+            return _grid.index(_goalX, _goalY);
+        }
+    }
+    else if (sign(goalDx) == dx && sign(goalDy) == dy)
+    {
+        const int steps = std::min(std::abs(goalDx), std::abs(goalDy));
+        if (steps <= freeCells)
+        {
+            return _grid.index(x + steps * dx, y + steps * dy);
+        }
+    }
+
+    if (distance <= 0)
+    {
+        return -1;
+    }
+    return _grid.index(x + distance * dx, y + distance * dy);
+}
+
+bool PathFinding::hasForcedNeighbor(int x, int y, int dx, int dy) const
+{
+    if (dx != 0)
+    {
+        return (!_grid.isBlocked(x, y - 1) && _grid.isBlocked(x - dx, y - 1)) ||
+               (!_grid.isBlocked(x, y + 1) && _grid.isBlocked(x - dx, y + 1));
+    }
+    return (!_grid.isBlocked(x - 1, y) && _grid.isBlocked(x - 1, y - dy)) ||
+           (!_grid.isBlocked(x + 1, y) && _grid.isBlocked(x + 1, y - dy));
+}
+
+void PathFinding::buildJumpTable()
+{
+    const int width = _grid.width();
+    const int height = _grid.height();
+    _jumpTable.assign(static_cast<std::size_t>(_grid.cellCount()) * DIRECTIONS, 0);
+
+    auto entry = [&](int x, int y, int direction) -> std::int16_t&
+    {
+        return _jumpTable[static_cast<std::size_t>(_grid.index(x, y)) * DIRECTIONS + direction];
+    };
+    // Extends the scan of the next cell by one step
+    auto extend = [](int next) { return static_cast<std::int16_t>(next > 0 ? next + 1 : next - 1); };
+
+    // Each entry depends on the cell ahead, so cells are visited against the scan direction.
+    // Straight scans come first because the diagonal ones stop where a straight scan finds a
+    // jump point. Entries of blocked cells are filled too, a search may start inside an obstacle.
+    for (int direction = 0; direction < DIRECTIONS; ++direction)
+    {
+        const int dx = DX[direction];
+        const int dy = DY[direction];
+        const bool diagonal = dx != 0 && dy != 0;
+        for (int row = 0; row < height; ++row)
+        {
+            const int y = dy > 0 ? height - 1 - row : row;
+            for (int column = 0; column < width; ++column)
+            {
+                const int x = dx > 0 ? width - 1 - column : column;
+                const int nx = x + dx;
+                const int ny = y + dy;
+                if (_grid.isBlocked(nx, ny) || (diagonal && (_grid.isBlocked(nx, y) || _grid.isBlocked(x, ny))))
+                {
+                    continue;
+                }
+
+                if (!diagonal)
+                {
+                    entry(x, y, direction) = hasForcedNeighbor(nx, ny, dx, dy) ? 1 : extend(entry(nx, ny, direction));
+                }
+                else if (entry(nx, ny, directionOf(dx, 0)) > 0 || entry(nx, ny, directionOf(0, dy)) > 0)
+                {
+                    entry(x, y, direction) = 1;
+                }
+                else
+                {
+                    entry(x, y, direction) = extend(entry(nx, ny, direction));
+                }
+            }
+        }
+    }
+    _jumpTableValid = true;
+}
+
+void PathFinding::relax(int x, int y, int cost, int parentId)
+{
+    const int id = _grid.index(x, y);
+    if (_stamp[id] == _generation && cost >= _cost[id])
+    {
+        return;
+    }
+
+    _stamp[id] = _generation;
+    _cost[id] = cost;
+    _parent[id] = parentId;
+    _open.emplace_back(x, y, cost, cost + heuristic(x, y, _goalX, _goalY));
+    std::push_heap(_open.begin(), _open.end(), LowerPriority{});
+}
+
+double PathFinding::inflationOf(const Polygon& piece) const
+{
+    const Point2 center(piece.getCenter());
+    double radius = 0.0;
+    for (const Point2& vertex : piece.transformedVertices())
+    {
+        radius = std::max(radius, vertex.calculateDistance(center));
+    }
+    return radius + _cellSize;
+}
+
+int PathFinding::heuristic(int x, int y, int goalX, int goalY)
+{
+    const int dx = std::abs(x - goalX);
+    const int dy = std::abs(y - goalY);
+    return STRAIGHT_COST * std::max(dx, dy) + (DIAGONAL_COST - STRAIGHT_COST) * std::min(dx, dy);
+}
+
+void PathFinding::prepareSearch()
+{
+    const std::size_t cellCount = _grid.cellCount();
+    if (_stamp.size() != cellCount)
+    {
+        _cost.assign(cellCount, 0);
+        _parent.assign(cellCount, -1);
+        _stamp.assign(cellCount, 0);
+        _generation = 0;
+    }
+
+    if (++_generation == 0)
+    {
+        std::fill(_stamp.begin(), _stamp.end(), 0);
+        _generation = 1;
+    }
+    _open.clear();
+}
+
+std::vector<Point> PathFinding::buildWaypoints(int originId, int startId, int goalId, const Point& goal) const
+{
+    std::vector<int> cells;
+    for (int id = goalId; id != startId; id = _parent[id])
+    {
+        cells.push_back(id);
+    }
+    cells.push_back(startId);
+    if (originId != startId)
+    {
+        cells.push_back(originId);
+    }
+    std::reverse(cells.begin(), cells.end());
+    return directionChanges(_grid, cells, goal);
+}
+
+std::vector<Point> PathFinding::directionChanges(const OccupancyGrid& grid, const std::vector<int>& cells, const Point& goal)
+{
+    // Keeps the cells where the direction of the path changes; consecutive cells are
+    // neighbors for A* and jump points for JPS, joined by straight or diagonal lines
+    std::vector<Point> waypoints;
+    const int width = grid.width();
+    for (std::size_t i = 1; i + 1 < cells.size(); ++i)
+    {
+        const int hopX = cells[i] % width - cells[i - 1] % width;
+        const int hopY = cells[i] / width - cells[i - 1] / width;
+        // The hop out of a blocked area around the start may be neither straight nor diagonal
+        const bool octilinear = hopX == 0 || hopY == 0 || std::abs(hopX) == std::abs(hopY);
+        const int outX = sign(cells[i + 1] % width - cells[i] % width);
+        const int outY = sign(cells[i + 1] / width - cells[i] / width);
+        if (!octilinear || sign(hopX) != outX || sign(hopY) != outY)
+        {
+            waypoints.push_back(grid.cellCenter(cells[i] % width, cells[i] / width));
+        }
+    }
+    // A path to a blocked goal ends at a free cell next to it, from which the goal is approached
+    const auto goalCell = grid.cellOf(goal);
+    if (!goalCell || grid.index(goalCell->first, goalCell->second) != cells.back())
+    {
+        waypoints.push_back(grid.cellCenter(cells.back() % width, cells.back() / width));
+    }
+    waypoints.push_back(goal);
+    return waypoints;
+}
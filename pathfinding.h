@@ -1,19 +1,319 @@
 #ifndef PATHFINDING_H
 #define PATHFINDING_H
 
-/**
-* This class is currently under development.
-* The intention is to integrate either the Dijkstra or A* search algorithm to
-* enhance the game's intelligence. This improvement aims to calculate the shortest
-* distance between the center of a shape and a designated destination point within
-* the scene.
-*/
-#include "scene.h"
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+#include "clustergraph.h"
+#include "dstarlite.h"
+#include "flowfield.h"
+#include "node.h"
+#include "occupancygrid.h"
+#include "reservationtable.h"
+#include "visibilitygraph.h"
+
+class Polygon;
+class Scene;
 
+/**
+ * @brief The PathFinding class
+ *
+ * Grid search for the center of a playing piece. The obstacles of the Scene are
+ * rasterized into an OccupancyGrid, grown by the bounding radius of the piece, so the piece
+ * can be treated as a point. The open list is a binary heap of Nodes (level = cost from the
+ * start, priority = level + octile estimate to the goal); costs, parents and visit stamps live
+ * in flat arrays indexed by cell id and are reused between searches.
+ *
+ * Besides plain A*, the search can run as Jump Point Search: instead of pushing every
+ * neighbor, it scans straight and diagonal lines across open space and only stops at cells
+ * where an obstacle forces a turn (jump points), which removes the symmetric paths that make
+ * A* expand most of a cluttered board. JPS+ reads the scans from a table of jump distances that
+ * is computed once per grid. All three return the same optimal path length.
+ *
+ * A* is the default. On open space its octile estimate is exact, so it only expands the cells
+ * along the path, while every jump point scan crosses the whole board. Jump Point Search pays
+ * off when obstacles split the space into many equally long detours, where A* expands most of
+ * them. JPS+ answers such queries fastest, but its table costs a pass over the whole grid after
+ * every change, so it suits many queries on the same grid.
+ *
+ * On very large grids PathFinding can also search hierarchically: a ClusterGraph summarizes
+ * the grid by the entrances between square clusters, so a long query only explores that
+ * small graph and the grid cells of each hop are computed when the piece gets there.
+ *
+ * While pieces move in turn, replan() keeps a grid and a D* Lite search tree for each piece
+ * and only repairs the part of the tree that depends on the cells the other pieces changed.
+ *
+ * Pieces that share a goal can instead share one FlowField: a single search from the goal
+ * gives every cell its distance and next step, so each piece then only reads the field.
+ * planCooperative() uses that field as the heuristic of a windowed space-time search (WHCA*)
+ * in which the pieces book their future positions, so they move together without bumping
+ * into each other.
+ *
+ * Grid paths can only turn in steps of 45 degrees. For any-angle paths PathFinding also
+ * keeps a VisibilityGraph over the configuration space obstacles of the piece, which gives
+ * the truly shortest polyline with as few segments as possible.
+ */
 class PathFinding
 {
 public:
-    PathFinding();
+    enum class Algorithm { AStar, JumpPointSearch, JumpPointSearchPlus };
+
+    /**
+    * @brief Constructor for PathFinding.
+    * @param cellSize Edge length of a grid cell in scene units.
+    * @param algorithm The search used by findPath().
+    */
+    explicit PathFinding(double cellSize = 1.0, Algorithm algorithm = Algorithm::AStar);
+
+    /**
+    * @brief Rasterizes the obstacles a piece has to avoid.
+    *
+    * Every shape of the scene except the piece itself is inflated by the distance from the
+    * piece's center to its farthest vertex, plus one cell to cover the straight lines between
+    * neighboring cell centers. When the grid was last built for the same piece, only the
+    * regions the Scene reports as changed since then are rasterized again.
+    *
+    * @param scene The Scene holding the obstacles.
+    * @param piece The playing piece that will follow the path.
+    */
+    void buildGrid(const Scene& scene, const Polygon& piece);
+
+    /**
+    * @brief Searches the shortest 8-connected path between two points.
+    *
+    * Diagonal steps may not cut the corner of a blocked cell. The start cell may be blocked,
+    * so a piece that already touches a shape can still leave it, straight to the closest free
+    * cell around the blocked area if its neighbor cells are blocked too. A goal in a blocked
+    * cell, such as an end position within the inflation band of a shape, is searched as the
+    * free cell closest to it that the start can reach.
+    *
+    * @param start The start point, usually the center of the piece.
+    * @param goal The destination point.
+    * @return The waypoints where the path changes direction, ending with the goal itself (after
+    *         the center of the free cell standing in for a blocked goal), or an empty vector if
+    *         no cell can be reached.
+    */
+    std::vector<Point> findPath(const Point& start, const Point& goal);
+
+    /**
+    * @brief Plans the path of a piece incrementally (D* Lite).
+    *
+    * Each piece keeps its own grid and search tree. On later calls for the same piece, the
+    * regions the Scene reports as changed are rasterized again and only the search around
+    * the cells that changed is repaired; the search starts over when the goal changes. A
+    * blocked goal is replaced by the closest reachable free cell, as in findPath().
+    *
+    * @param scene The Scene holding the obstacles.
+    * @param piece The playing piece, planned from its current center.
+    * @param goal The destination point.
+    * @return The waypoints where the path changes direction, ending with the goal itself,
+    *         or an empty vector if no cell can be reached.
+    */
+    std::vector<Point> replan(const Scene& scene, const Polygon& piece, const Point& goal);
+
+    /**
+    * @brief Builds the flow field of pieces heading to the same goal.
+    *
+    * The obstacles are all the components except the pieces, grown by the largest inflation
+    * among the pieces, so the field is safe for each of them; the pieces themselves are left
+    * to avoid each other while they move. Later calls with the same pieces and goal rasterize
+    * the regions the Scene reports as changed and only repair the field around the cells
+    * that changed.
+    *
+    * @param scene The Scene holding the obstacles.
+    * @param pieces The playing pieces that will follow the field.
+    * @param goal The destination point shared by the pieces.
+    */
+    void buildFlowField(const Scene& scene, std::span<const Polygon* const> pieces, const Point& goal);
+
+    /**
+    * @brief Follows the flow field from a point.
+    * @return The waypoints where the path changes direction, ending with the goal of the
+    *         field, or an empty vector if no target of the field can be reached from the point.
+    */
+    std::vector<Point> followFlowField(const Point& start) const;
+
+    // Center of the next cell towards the goal of the flow field, or the goal itself from a
+    // target of the field; empty if no target can be reached from the point
+    std::optional<Point> flowStep(const Point& position) const;
+
+    /**
+    * @brief Plans the next steps of pieces heading to the same goal together (WHCA*).
+    *
+    * The flow field of the pieces is brought up to date first; its distances ignore the other
+    * pieces and are the exact estimate of a space-time A* search, in which a piece moves to a
+    * neighboring cell or waits at each time step. The pieces plan one after another, in the
+    * given order, and book the disc they cover at every step in a ReservationTable, so the
+    * later pieces go around the earlier ones or wait for them. Each search is limited to the
+    * window, so the cost of a round grows with the number of pieces, not with its square.
+    *
+    * @param scene The Scene holding the obstacles.
+    * @param pieces The playing pieces, highest priority first.
+    * @param goal The destination point shared by the pieces.
+    * @param window Number of time steps planned ahead.
+    * @return For each piece, the cell centers it occupies at the time steps 0 to window, or an
+    *         empty vector if its center lies outside the grid.
+    */
+    std::vector<std::vector<Point>> planCooperative(const Scene& scene, std::span<const Polygon* const> pieces,
+                                                    const Point& goal, int window);
+
+    /**
+    * @brief Searches the abstract graph of the grid clusters (HPA*).
+    *
+    * Clusters touched since the last query are rebuilt first. The path may be slightly
+    * longer than the one of findPath(), in exchange for a search whose size depends on the
+    * number of clusters crossed rather than on the number of cells.
+    *
+    * @return The centers of the entrance cells the path crosses, ending with the goal, or an
+    *         empty vector if the goal cannot be reached. Consecutive waypoints are turned into
+    *         a grid path with refineHierarchicalPath().
+    */
+    std::vector<Point> findHierarchicalPath(const Point& start, const Point& goal);
+
+    /**
+    * @brief Computes the grid path of one hop of a hierarchical path.
+    * @param from The start or a waypoint returned by findHierarchicalPath().
+    * @param to The next waypoint.
+    * @return The waypoints where the path changes direction, ending with to, or an empty
+    *         vector if the two points are not consecutive on a hierarchical path.
+    */
+    std::vector<Point> refineHierarchicalPath(const Point& from, const Point& to);
+
+    /**
+    * @brief Builds the visibility graph of the obstacles a piece has to avoid.
+    *
+    * The obstacles are the configuration space obstacles cached by the Scene for the piece,
+    * so its center is the reference point. The graph is kept until the Scene recomputes one
+    * of them, which happens only when the piece rotates or another component moves.
+    *
+    * @param scene The Scene holding the obstacles.
+    * @param piece The playing piece that will follow the path.
+    */
+    void buildVisibilityGraph(Scene& scene, const Polygon& piece);
+
+    /**
+    * @brief Searches the shortest any-angle path in the visibility graph.
+    * @return The waypoints after the start, ending with the goal, or an empty vector if no path exists.
+    */
+    std::vector<Point> findAnyAnglePath(const Point& start, const Point& goal) const;
+
+    const VisibilityGraph& visibilityGraph() const { return _visibilityGraph; }
+    const ClusterGraph& clusterGraph() const { return _clusterGraph; }
+    const FlowField& flowField() const { return _flowField; }
+    const OccupancyGrid& flowGrid() const { return _flowGrid; }
+
+    // Number of nodes taken from the open list by the last search
+    std::size_t expandedNodes() const { return _expandedNodes; }
+    double cellSize() const { return _cellSize; }
+    Algorithm algorithm() const { return _algorithm; }
+    void setAlgorithm(Algorithm algorithm) { _algorithm = algorithm; }
+    const OccupancyGrid& grid() const { return _grid; }
+    // Mutable access; the JPS+ table and the cluster graph are rebuilt before the next search
+    OccupancyGrid& grid()
+    {
+        _jumpTableValid = false;
+        _clusterGraph.invalidateAll();
+        _gridPiece = SIZE_MAX;
+        return _grid;
+    }
+
+private:
+    // Octile distance in integer cost units
+    static int heuristic(int x, int y, int goalX, int goalY);
+    // Resizes the search arrays to the grid and starts a new search generation
+    void prepareSearch();
+    // Records a cheaper way to reach a cell and pushes it on the open list
+    void relax(int x, int y, int cost, int parentId);
+    void expandNeighbors(const Node& node);
+    void expandJumpPoints(const Node& node);
+    // Directions worth scanning from a cell, given the direction it was entered with
+    int prunedDirections(int x, int y, int id, int* directions) const;
+    // Scans from a cell in one direction and returns the id of the next jump point, or -1
+    int jump(int x, int y, int direction) const;
+    int jumpStraight(int x, int y, int dx, int dy) const;
+    int jumpPlus(int x, int y, int direction) const;
+    bool hasForcedNeighbor(int x, int y, int dx, int dy) const;
+    void buildJumpTable();
+    // Waypoints of the search tree path; the origin is the cell of the piece, left straight to the
+    // start of the search when it lies deep in the inflation band of a shape
+    std::vector<Point> buildWaypoints(int originId, int startId, int goalId, const Point& goal) const;
+    // Keeps the cells where the path changes direction, starting from the cell before them
+    static std::vector<Point> directionChanges(const OccupancyGrid& grid, const std::vector<int>& cells, const Point& goal);
+    // Distance the obstacles are grown by for a piece: its bounding radius plus one cell
+    double inflationOf(const Polygon& piece) const;
+    /**
+    * @brief Space-time A* of one piece over the flow grid, within a time window.
+    *
+    * The cell reached by a step is checked against the bookings of the pieces planned earlier
+    * at both ends of the step and at the end of the next one, since those pieces also move
+    * first within each time step.
+    *
+    * @return The cell ids at the time steps 0 to window; the piece waits where it is if no
+    *         step is free.
+    */
+    std::vector<int> searchWindow(std::size_t agent, const std::pair<int, int>& start, double radius, int window);
+
+    static constexpr int STRAIGHT_COST = 10;
+    static constexpr int DIAGONAL_COST = 14;
+
+    double _cellSize;
+    Algorithm _algorithm;
+    OccupancyGrid _grid;
+    std::vector<Node> _open;
+    std::vector<int> _cost;
+    std::vector<int> _parent;
+    // A cell's cost and parent are valid only if its stamp equals the current generation
+    std::vector<std::uint32_t> _stamp;
+    std::uint32_t _generation = 0;
+    // Flood fills of the start and goal checks, on the search grid or the grid of a replanner
+    CellMarks _marks;
+    std::vector<int> _freeCells;
+    std::size_t _expandedNodes = 0;
+    int _goalX = 0;
+    int _goalY = 0;
+    // JPS+ jump distances, 8 per cell in the order of the search directions: a positive value
+    // is the distance to the next jump point, otherwise minus the number of free cells ahead
+    std::vector<std::int16_t> _jumpTable;
+    bool _jumpTableValid = false;
+    ClusterGraph _clusterGraph;
+    // Piece, inflation and Scene change count the grid was last rasterized for
+    std::size_t _gridPiece = SIZE_MAX;
+    double _gridInflation = 0.0;
+    std::size_t _gridChanges = 0;
+
+    // Grid and incremental search of one piece, kept between calls of replan()
+    struct Replanner
+    {
+        OccupancyGrid grid;
+        double inflation = 0.0;
+        std::size_t sceneChanges = 0;
+        DStarLite search;
+    };
+    std::unordered_map<std::size_t, Replanner> _replanners;
+    // Flow field shared by the pieces heading to one goal, with its own grid
+    OccupancyGrid _flowGrid;
+    FlowField _flowField;
+    Point _flowGoal;
+    // Sorted ids of the pieces left out of the flow grid
+    std::vector<std::size_t> _flowPieces;
+    double _flowInflation = 0.0;
+    std::size_t _flowChanges = 0;
+    // Bookings and search arrays of planCooperative(); the search states are keyed by cell
+    // id and time step
+    ReservationTable _reservations;
+    std::vector<std::tuple<int, int, int>> _windowOpen;
+    std::vector<int> _windowCells;
+    std::vector<int> _windowTimes;
+    std::vector<int> _windowCosts;
+    std::vector<int> _windowParents;
+    std::unordered_map<std::int64_t, int> _windowStates;
+    VisibilityGraph _visibilityGraph;
+    // Piece and configuration space revision the visibility graph was built for
+    std::size_t _visibilityPiece = SIZE_MAX;
+    std::uint64_t _visibilityRevision = 0;
 };
 
 #endif // PATHFINDING_H
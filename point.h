@@ -1,22 +1,35 @@
 /**
  * @file Point.h
  *
- * @brief Defines the Point class, representing a point in three-dimensional space.
+ * @brief Defines the BasicPoint class template and the Point types built from it.
  */
 
 #ifndef POINT_H
 #define POINT_H
+#include <array>
+#include <cmath>
 #include <compare>
-#include <iostream>
-#include <tuple>
+#include <cstddef>
+#include <ostream>
 
 /**
- * @class Point
- * @brief Represents a point in three-dimensional space.
+ * @class BasicPoint
+ * @brief Represents a point, or a vector, with Dim coordinates of type T.
+ *
+ * The coordinates are stored next to each other and the class is trivially copyable, so arrays
+ * of points are copied with memcpy and loops over them can be vectorized. The two-dimensional
+ * points are aligned on their size, which puts a Point2 in one SSE register.
+ *
+ * Point keeps the three-dimensional API for the callers that need it. The engine itself is
+ * planar: the polygons, the Scene and LinearMath work on Point2, and Point2f stores vertices that
+ * are only read, such as the snapshots of the Scene. A point converts implicitly to a type that
+ * holds all of its coordinates (a missing z is 0) and explicitly to one that drops some.
  */
-
-class Point
+template<typename T, std::size_t Dim>
+class alignas(Dim == 2 ? 2 * sizeof(T) : alignof(T)) BasicPoint
 {
+    static_assert(Dim == 2 || Dim == 3, "BasicPoint has two or three coordinates");
+
 public:
     /**
      * @brief Point
@@ -24,49 +37,208 @@ public:
      * @param y
      * @param z
      */
-    Point(double x = 0.0, double y = 0.0, double z = 0.0);
-    Point(const Point& other);
-    Point(Point&& other) noexcept;
-    ~Point() = default;
-    Point& operator=(const Point& other);
-    Point& operator=(Point&& other) noexcept;
-
-    inline constexpr double getX() const { return _x; }
-    inline constexpr double getY() const { return _y; }
-    inline constexpr double getZ() const { return _z; }
-
-    void setX(double x) { _x = x; }
-    void setY(double y) { _y = y; }
-    void setZ(double z) { _z = z; }
-
-    friend std::ostream& operator<<(std::ostream & ss, const Point& point);
-
-    auto operator<=>(const Point& other) const;
-    bool operator<(const Point& other) const;
-    Point operator -(const Point& other) const;
-    bool operator ==(const Point& other) const;
-    bool operator!=(const Point& other) const;
-    void operator =(Point& other);
-
-    Point operator -();
-    Point operator /=( double scalar);
-    Point operator *=( double scalar);
-    Point operator *(const Point& other);
-    Point operator +=(const Point& other)const;
-    Point operator+(const Point& other) const;
-    auto calculateDistance(const Point& other) const -> double;
-
-    auto getVectorNorm(Point & vector) ->double;
-    double getVectorNorm();
-    void rotate(double angle, const Point& center);
-    void translate(const Point& delta);
-    Point crossProduct(const Point& other) const;
-    bool isZero() const;
-    double dotProduct(const Point& other) const;
+    constexpr BasicPoint(T x = 0, T y = 0, T z = 0) requires (Dim == 3) : _coordinates {x, y, z} {}
+    constexpr BasicPoint(T x = 0, T y = 0) requires (Dim == 2) : _coordinates {x, y} {}
+
+    template<typename U, std::size_t D>
+    constexpr explicit(D > Dim || sizeof(U) > sizeof(T)) BasicPoint(const BasicPoint<U, D>& other)
+    {
+        for (std::size_t i = 0; i < Dim; ++i)
+        {
+            _coordinates[i] = i < D ? static_cast<T>(other[i]) : T(0);
+        }
+    }
+
+    constexpr T getX() const { return _coordinates[0]; }
+    constexpr T getY() const { return _coordinates[1]; }
+    // A planar point lies at z = 0
+    constexpr T getZ() const
+    {
+        if constexpr (Dim == 3)
+        {
+            return _coordinates[2];
+        }
+        else
+        {
+            return T(0);
+        }
+    }
+    constexpr T operator [](std::size_t index) const { return _coordinates[index]; }
+
+    constexpr void setX(T x) { _coordinates[0] = x; }
+    constexpr void setY(T y) { _coordinates[1] = y; }
+    constexpr void setZ(T z) requires (Dim == 3) { _coordinates[2] = z; }
+
+    friend std::ostream& operator<<(std::ostream& ss, const BasicPoint& point)
+    {
+        ss << "(" << point.getX() << ", " << point.getY();
+        if constexpr (Dim == 3)
+        {
+            ss << ", " << point.getZ();
+        }
+        return ss << ")";
+    }
+
+    constexpr auto operator<=>(const BasicPoint& other) const
+    {
+        // Compare lexicographically by comparing x, y, and z
+        return _coordinates <=> other._coordinates;
+    }
+
+    constexpr bool operator<(const BasicPoint& other) const
+    {
+        return (getX() < other.getX()) ? true
+               : (getX() == other.getX()) ? (getY() < other.getY())
+               : (getY() == other.getY()) ? (getZ() < other.getZ())
+                                          : false;
+    }
+
+    constexpr bool operator ==(const BasicPoint& other) const
+    {
+        return _coordinates == other._coordinates;
+    }
+
+    constexpr BasicPoint operator -(const BasicPoint& other) const
+    {
+        return combine(other, [](T a, T b) { return a - b; });
+    }
+
+    constexpr BasicPoint operator -() const
+    {
+        return combine(*this, [](T a, T) { return -a; });
+    }
+
+    // Division by zero gives the IEEE infinities and NaN, like the coordinates themselves
+    constexpr BasicPoint& operator /=(T scalar)
+    {
+        for (T& coordinate : _coordinates)
+        {
+            coordinate /= scalar;
+        }
+        return *this;
+    }
+
+    constexpr BasicPoint& operator *=(T scalar)
+    {
+        for (T& coordinate : _coordinates)
+        {
+            coordinate *= scalar;
+        }
+        return *this;
+    }
+
+    // Coordinate-wise product
+    constexpr BasicPoint operator *(const BasicPoint& other) const
+    {
+        return combine(other, [](T a, T b) { return a * b; });
+    }
+
+    constexpr BasicPoint& operator +=(const BasicPoint& other)
+    {
+        return *this = *this + other;
+    }
+
+    constexpr BasicPoint operator+(const BasicPoint& other) const
+    {
+        return combine(other, [](T a, T b) { return a + b; });
+    }
+
+    T calculateDistance(const BasicPoint& other) const
+    {
+        return (*this - other).getVectorNorm();
+    }
+
+    T getVectorNorm(const BasicPoint& vector) const
+    {
+        return vector.getVectorNorm();
+    }
+
+    T getVectorNorm() const
+    {
+        return std::sqrt(dotProduct(*this));
+    }
+
+    // Rotates the point around the center by the angle in degrees, in the xy plane
+    void rotate(double angle, const BasicPoint& center)
+    {
+        double angle_rad = angle * (M_PI / 180.0);
+        double tolerance = 1e-6;
+        double cosTheta = cos(angle_rad);
+        double sinTheta = sin(angle_rad);
+
+        if (std::abs(cosTheta) < tolerance)
+        {
+            cosTheta = 0;
+        }
+        if (std::abs(sinTheta) < tolerance)
+        {
+            sinTheta = 0;
+        }
+
+        const double x = getX() - center.getX();
+        const double y = getY() - center.getY();
+        const double newX = cosTheta * x - sinTheta * y;
+        const double newY = sinTheta * x + cosTheta * y;
+
+        setX(static_cast<T>(newX + center.getX()));
+        setY(static_cast<T>(newY + center.getY()));
+    }
+
+    constexpr void translate(const BasicPoint& delta)
+    {
+        *this += delta;
+    }
+
+    constexpr BasicPoint crossProduct(const BasicPoint& other) const requires (Dim == 3)
+    {
+        return BasicPoint(getY() * other.getZ() - getZ() * other.getY(),
+                          getZ() * other.getX() - getX() * other.getZ(),
+                          getX() * other.getY() - getY() * other.getX());
+    }
+
+    constexpr bool isZero() const
+    {
+        for (T coordinate : _coordinates)
+        {
+            if (coordinate != T(0))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    constexpr T dotProduct(const BasicPoint& other) const
+    {
+        T sum = _coordinates[0] * other._coordinates[0];
+        for (std::size_t i = 1; i < Dim; ++i)
+        {
+            sum += _coordinates[i] * other._coordinates[i];
+        }
+        return sum;
+    }
 
 private:
-    double _x,  _y, _z;
+    // Applies the operation to each pair of coordinates
+    template<typename Operation>
+    constexpr BasicPoint combine(const BasicPoint& other, Operation operation) const
+    {
+        BasicPoint result;
+        for (std::size_t i = 0; i < Dim; ++i)
+        {
+            result._coordinates[i] = operation(_coordinates[i], other._coordinates[i]);
+        }
+        return result;
+    }
+
+    std::array<T, Dim> _coordinates {};
 };
 
+// Point in three-dimensional space, the type of the Shape interface
+using Point = BasicPoint<double, 3>;
+// Point of the plane the engine works in
+using Point2 = BasicPoint<double, 2>;
+// Planar point in single precision, for vertices that are only displayed
+using Point2f = BasicPoint<float, 2>;
 
 #endif // POINT_H
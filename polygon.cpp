@@ -1,194 +1,688 @@
 #include "polygon.h"
+#include "scratcharena.h"
 
-std::string red = "\033[31m";
-std::string green = "\033[32m";
-std::string magenta = "\033[35m";
-std::string reset = "\033[0m";
+namespace
+{
+constexpr std::string_view red = "\033[31m";
+constexpr std::string_view green = "\033[32m";
+constexpr std::string_view magenta = "\033[35m";
+constexpr std::string_view reset = "\033[0m";
 
-Polygon::Polygon(const std::initializer_list<Point> &initialVertices) : _initialVertices {std::vector<Point>(initialVertices)}
+// Adds the angle, turned in the direction of the sign from the point's angle, wrapped into [0, 2 pi)
+void addCriticalAngle(double angle, double pointAngle, double sign, std::pmr::vector<double>& critical)
 {
-    std::cout << "Class Polygon() " << std::endl;
-    _transformedVertices = std::vector<Point>();
+    angle = std::fmod(sign * (angle - pointAngle), 2.0 * M_PI);
+    if (angle < 0.0)
+    {
+        angle += 2.0 * M_PI;
+    }
+    critical.push_back(angle);
 }
 
-void Polygon::move(const Point& destination, double stepSize)
+// Adds the angles at which a point on the circle of the given squared radius around the pivot,
+// at pointAngle, reaches the segment a-b
+void addSegmentCrossings(const Point2& pivot, double radiusSquared, double pointAngle, const Point2& a, const Point2& b,
+                         double sign, std::pmr::vector<double>& critical)
 {
-    Point moveVector = destination - _center;
+    const double dx = b.getX() - a.getX();
+    const double dy = b.getY() - a.getY();
+    const double fx = a.getX() - pivot.getX();
+    const double fy = a.getY() - pivot.getY();
 
-    double distance = moveVector.getVectorNorm();
-    double tolerance = 1e-6; // suitable tolerance for considering the destination reached
+    // |f + s * d| = radius, for s in [0, 1] along the edge
+    const double qa = dx * dx + dy * dy;
+    const double qb = 2.0 * (fx * dx + fy * dy);
+    const double qc = fx * fx + fy * fy - radiusSquared;
+    const double discriminant = qb * qb - 4.0 * qa * qc;
+    if (qa == 0.0 || discriminant < 0.0)
+    {
+        return;
+    }
 
-    if (distance < tolerance)
+    const double root = std::sqrt(discriminant);
+    for (double s : {(-qb - root) / (2.0 * qa), (-qb + root) / (2.0 * qa)})
+    {
+        if (s >= 0.0 && s <= 1.0)
+        {
+            addCriticalAngle(std::atan2(fy + s * dy, fx + s * dx), pointAngle, sign, critical);
+        }
+    }
+}
+
+// Same for the circle of the given radius around the center
+void addCircleCrossings(const Point2& pivot, double radiusSquared, double pointAngle, const Point2& center, double radius,
+                        double sign, std::pmr::vector<double>& critical)
+{
+    const double cx = center.getX() - pivot.getX();
+    const double cy = center.getY() - pivot.getY();
+    const double distance = std::sqrt(cx * cx + cy * cy);
+    const double pathRadius = std::sqrt(radiusSquared);
+    if (distance == 0.0 || distance > pathRadius + radius || distance < std::abs(pathRadius - radius))
     {
-        std::cout << green << "Already at the destination." << reset << std::endl;
         return;
     }
-    // Check for potential collision before moving
-    std::shared_ptr<Shape> sharedThis = shared_from_this();
-    for (const auto& otherComponent : Scene::getInstance()->neigbhorsShapes(sharedThis, destination))
+
+    // The crossings lie on the chord at this distance from the pivot along the line to the center
+    const double along = (radiusSquared - radius * radius + distance * distance) / (2.0 * distance);
+    const double across = std::sqrt(std::max(0.0, radiusSquared - along * along));
+    const double ux = cx / distance;
+    const double uy = cy / distance;
+    for (double side : {-1.0, 1.0})
+    {
+        addCriticalAngle(std::atan2(along * uy + side * across * ux, along * ux - side * across * uy), pointAngle, sign, critical);
+    }
+}
+
+// Adds the spans between consecutive sorted critical angles that are blocked in their middle,
+// merging a span into the previous one when they touch
+template<typename IsBlocked>
+void addBlockedSpans(std::span<const double> critical, IsBlocked isBlocked, std::pmr::vector<std::pair<double, double>>& blocked)
+{
+    for (std::size_t i = 0; i + 1 < critical.size(); ++i)
     {
-        const auto& otherPolygon = std::dynamic_pointer_cast<Polygon>(otherComponent.first);
-        if (this != otherPolygon.get())
+        const double start = critical[i];
+        const double end = critical[i + 1];
+        if (end - start < 1e-12)
+        {
+            continue;
+        }
+
+        if (isBlocked(0.5 * (start + end)))
         {
-            if (intersects(otherPolygon, destination))
+            if (!blocked.empty() && blocked.back().second == start)
             {
-                std::cout << red << "Collision detected. Cannot move to the destination." << reset << std::endl;
-                return;
+                blocked.back().second = end;
+            }
+            else
+            {
+                blocked.emplace_back(start, end);
             }
         }
     }
+}
 
-    int numSteps = static_cast<int>(distance / stepSize);
-    if (numSteps == 0)
-        numSteps = 1;
+// Earliest time t >= 0 at which start + t * direction comes within the radius of the segment a-b,
+// or infinity; the point must start farther than the radius
+double timeToCapsule(double startX, double startY, double directionX, double directionY,
+                     double ax, double ay, double bx, double by, double radius)
+{
+    double first = INFINITY;
+    // The round ends
+    for (const auto& [cx, cy] : {std::pair{ax, ay}, std::pair{bx, by}})
+    {
+        const double fx = startX - cx;
+        const double fy = startY - cy;
+        const double qa = directionX * directionX + directionY * directionY;
+        const double qb = 2.0 * (fx * directionX + fy * directionY);
+        const double qc = fx * fx + fy * fy - radius * radius;
+        const double discriminant = qb * qb - 4.0 * qa * qc;
+        if (qa > 0.0 && discriminant >= 0.0)
+        {
+            const double t = (-qb - std::sqrt(discriminant)) / (2.0 * qa);
+            if (t >= 0.0)
+            {
+                first = std::min(first, t);
+            }
+        }
+    }
 
-    moveVector /= numSteps;
+    // The two sides, at the radius from the segment
+    const double ex = bx - ax;
+    const double ey = by - ay;
+    const double lengthSquared = ex * ex + ey * ey;
+    if (lengthSquared == 0.0)
+    {
+        return first;
+    }
+    const double length = std::sqrt(lengthSquared);
+    const double nx = ey / length;
+    const double ny = -ex / length;
+    const double distance = (startX - ax) * nx + (startY - ay) * ny;
+    const double speed = directionX * nx + directionY * ny;
+    if (speed == 0.0)
+    {
+        return first;
+    }
+    for (double side : {-radius, radius})
+    {
+        const double t = (side - distance) / speed;
+        const double along = ((startX + t * directionX - ax) * ex + (startY + t * directionY - ay) * ey) / lengthSquared;
+        if (t >= 0.0 && along >= 0.0 && along <= 1.0)
+        {
+            first = std::min(first, t);
+        }
+    }
+    return first;
+}
+
+// Factor that scales an ellipse vertically into the circle of its horizontal radius
+double circleScale(const CircularShape& circularShape)
+{
+    return circularShape.getMinorRadius() ? circularShape.getRadius() / circularShape.getMinorRadius() : 1.0;
+}
+
+// FixedPolygon kernels of one pair of vertex counts
+struct FixedKernels
+{
+    bool (*separates)(const PolygonColumns&, const PolygonColumns&, const PolygonPose&);
+    void (*projectOnAxes)(const PolygonColumns&, const PolygonColumns&, const PolygonPose&, double*, double*);
+};
+
+constexpr std::size_t FIXED_COUNTS = FIXED_POLYGON_MAX_VERTICES - FIXED_POLYGON_MIN_VERTICES + 1;
+
+template<std::size_t... Pair>
+constexpr std::array<FixedKernels, sizeof...(Pair)> makeFixedKernels(std::index_sequence<Pair...>)
+{
+    return {FixedKernels {
+        &FixedPolygon<FIXED_POLYGON_MIN_VERTICES + Pair / FIXED_COUNTS>::template separates<FIXED_POLYGON_MIN_VERTICES + Pair % FIXED_COUNTS>,
+        &FixedPolygon<FIXED_POLYGON_MIN_VERTICES + Pair / FIXED_COUNTS>::template projectOnAxes<FIXED_POLYGON_MIN_VERTICES + Pair % FIXED_COUNTS>}...};
+}
 
-    _transformedVertices = _initialVertices;
-    int iteration = 1;
+// Indexed by the vertex count of the polygon owning the axes, then by the count of the projected one
+constexpr std::array<FixedKernels, FIXED_COUNTS * FIXED_COUNTS> FIXED_KERNELS =
+    makeFixedKernels(std::make_index_sequence<FIXED_COUNTS * FIXED_COUNTS>());
 
-    while (_center != destination)
+// The kernels unrolled for the two vertex counts, or nullptr if one of them has none
+const FixedKernels* fixedKernels(std::size_t count, std::size_t otherCount)
+{
+    if (count < FIXED_POLYGON_MIN_VERTICES || count > FIXED_POLYGON_MAX_VERTICES
+        || otherCount < FIXED_POLYGON_MIN_VERTICES || otherCount > FIXED_POLYGON_MAX_VERTICES)
     {
-        for (int step = 0; step < numSteps; ++step)
+        return nullptr;
+    }
+    return &FIXED_KERNELS[(count - FIXED_POLYGON_MIN_VERTICES) * FIXED_COUNTS + otherCount - FIXED_POLYGON_MIN_VERTICES];
+}
+
+// The kernels are constexpr, so the unrolled test is checked while compiling
+static_assert(FixedPolygon<3>({0, 0, 4}, {0, 4, 0}).intersects(FixedPolygon<4>({1, 1, 5, 5}, {1, 5, 5, 1})));
+static_assert(!FixedPolygon<3>({0, 0, 4}, {0, 4, 0}).intersects(FixedPolygon<4>({3, 3, 5, 5}, {3, 5, 5, 3})));
+static_assert(!FixedPolygon<5>({0, 1, 3, 4, 2}, {2, 4, 4, 2, 0}).intersects(FixedPolygon<3>({5, 5, 8}, {0, 4, 2})));
+}
+
+Polygon::Polygon(const std::initializer_list<Point> &initialVertices) : Polygon(std::vector<Point>(initialVertices))
+{
+}
+
+Polygon::Polygon(std::vector<Point> initialVertices)
+{
+    std::cout << "Class Polygon() " << std::endl;
+    setInitialVertices(initialVertices);
+}
+
+void Polygon::move(const Point& destination, [[maybe_unused]] double stepSize)
+{
+    Point moveVector = destination - _center;
+
+    double distance = moveVector.getVectorNorm();
+    double tolerance = 1e-6; // suitable tolerance for considering the destination reached
+
+    if (distance < tolerance)
+    {
+        Scene::output() << green << "Already at the destination." << reset << std::endl;
+        return;
+    }
+    // The swept region covers the whole path, so it holds every shape the move can hit; a
+    // Polygon outside any scene has nothing to hit
+    Scene* scene = this->scene();
+    ScratchArena::Scope scope;
+    Broadphase::IdList neighbors(&scope.arena());
+    if (scene)
+    {
+        scene->neigbhorsShapes(*this, destination, neighbors);
+    }
+
+    double fraction = 1.0;
+    bool collided = false;
+    for (Broadphase::Id id : neighbors)
+    {
+        // The kernels for the kind of the neighbor are picked at compile time
+        const bool overlapping = scene->visit(id, [&](const auto& other)
         {
-            for (auto& point : _transformedVertices)
+            if (static_cast<const Shape*>(&other) == this)
             {
-                point.translate(moveVector);
+                return false;
             }
-            // Check for collision after each step
-            std::shared_ptr<Shape> sharedThis = shared_from_this();
-            for (const auto& otherComponent : Scene::getInstance()->neigbhorsShapes(sharedThis, destination))
+
+            // Check for potential collision before moving
+            if (intersects(other, destination))
             {
-                std::shared_ptr<Polygon> otherPolygon = std::dynamic_pointer_cast<Polygon>(otherComponent.first);
-                if (this != otherPolygon.get())
-                {
-                    if (intersects(otherPolygon, destination))
-                    {
-                        std::cout << red <<"Collision detected. Change movment direction." <<  reset << std::endl;
-                        return;
-                    }
-                }
+                return true;
             }
 
-            iteration++;
-            _center = calculatePolygonCenter();
+            if (const auto contact = timeOfImpact(other, moveVector); contact && *contact < fraction)
+            {
+                fraction = *contact;
+                collided = true;
+            }
+            return false;
+        });
+        if (overlapping)
+        {
+            Scene::output() << red << "Collision detected. Cannot move to the destination." << reset << std::endl;
+            return;
         }
+    }
+
+    if (collided)
+    {
+        // Stop just short of the first contact so the shapes do not overlap
+        fraction = std::max(0.0, fraction - CONTACT_SKIN / distance);
+    }
+
+    // Only the pose changes; the vertices follow when they are next needed
+    moveVector *= fraction;
+    _center.translate(moveVector);
+    _posed = true;
+    _verticesCurrent = false;
+
+    if (collided)
+    {
+        Scene::output() << red <<"Collision detected. Change movment direction." <<  reset << std::endl;
+    }
+    else
+    {
+        Scene::output() << green << "Reached your destination." << reset << std::endl;
+    }
+
+    if (scene)
+    {
+        scene->updateComponent(*this);
+    }
+}
 
-        double currentDistance = (_center - destination).getVectorNorm();
+double Polygon::rotate(const Point& pivot, double step, bool clockwise)
+{
+    const double reachable = maxRotationAngle(pivot, clockwise, step);
 
-        if (currentDistance <= tolerance)
+    if (reachable > 0.0)
+    {
+        applyRotation(pivot, clockwise ? reachable : -reachable);
+        if (Scene* scene = this->scene())
         {
-            std::cout << green << "Reached your destination after " << iteration << " steps." << reset << std::endl;
-            break;
+            scene->updateComponent(*this, Scene::ComponentChange::Rotated);
         }
-        if (iteration > 1 && currentDistance > distance)
+    }
+
+    if (reachable < step)
+    {
+        Scene::output() << magenta << "Collision detected. Change rotation angle. Rotated by "
+                  << reachable << " degrees only." << reset << std::endl << std::endl;
+    }
+    return reachable;
+}
+
+void Polygon::freeRotationIntervals(const Point& pivot, std::pmr::vector<std::pair<double, double>>& free) const
+{
+    free.clear();
+
+    // Only the shapes touching the disc swept by the Polygon can block it. The temporaries share
+    // the caller's scope of the arena with the result, which must outlive them.
+    ScratchArena& arena = ScratchArena::local();
+    const Scene* scene = this->scene();
+    Broadphase::IdList ids(&arena);
+    std::pmr::vector<std::pair<double, double>> blocked(&arena);
+    if (scene)
+    {
+        scene->overlappingShapes(rotationRegion(pivot), ids, this);
+    }
+    const Point2 center(pivot);
+    for (Broadphase::Id id : ids)
+    {
+        scene->visit(id, [&](const auto& other) { blockedRotationAngles(other, center, blocked); });
+    }
+    std::sort(blocked.begin(), blocked.end());
+
+    // The free intervals are the gaps between the merged blocked intervals
+    double start = 0.0;
+    for (const auto& [blockStart, blockEnd] : blocked)
+    {
+        if (blockStart > start)
         {
-            std::cout <<  "Unable to reach the destination." << std::endl;
-            break;
+            free.emplace_back(start * 180.0 / M_PI, blockStart * 180.0 / M_PI);
         }
-        distance = currentDistance;
+        start = std::max(start, blockEnd);
     }
+    if (start < 2.0 * M_PI)
+    {
+        free.emplace_back(start * 180.0 / M_PI, 360.0);
+    }
+}
+
+Broadphase::Box Polygon::rotationRegion(const Point& pivot) const
+{
+    const double radius = farthestVertexDistance(Point2(pivot));
+    return {Point2(pivot.getX() - radius, pivot.getY() - radius), Point2(pivot.getX() + radius, pivot.getY() + radius)};
 }
 
-void Polygon::rotate(const Point& pivot, double step, bool clockwise)
+double Polygon::maxRotationAngle(const Point& pivot, bool clockwise, double limit) const
 {
-    double currentAngle = 0.0;
-    double rotationStep = clockwise ? step : -step;
+    ScratchArena::Scope scope;
+    std::pmr::vector<std::pair<double, double>> intervals(&scope.arena());
+    freeRotationIntervals(pivot, intervals);
+    if (intervals.empty())
+    {
+        return 0.0;
+    }
+
+    double reachable = 0.0;
+    if (intervals.front().first == 0.0 && intervals.front().second == 360.0)
+    {
+        return limit;
+    }
+    if (clockwise && intervals.front().first == 0.0)
+    {
+        reachable = intervals.front().second;
+    }
+    else if (!clockwise && intervals.back().second == 360.0)
+    {
+        reachable = 360.0 - intervals.back().first;
+    }
 
-    while (currentAngle < 360.0)
+    if (reachable <= limit)
     {
-        // Apply rotation to the transformed vertices
-        _transformedVertices = _initialVertices;
-        for (Point& point : _transformedVertices)
+        // Stop just short of the contact, like move() does
+        const double radius = farthestVertexDistance(Point2(pivot));
+        if (radius > 0.0)
         {
-            point.rotate(rotationStep, pivot);
+            reachable = std::max(0.0, reachable - CONTACT_SKIN / radius * 180.0 / M_PI);
         }
-        _center = calculatePolygonCenter();
+    }
+    return std::min(reachable, limit);
+}
+
+void Polygon::blockedRotationAngles(const Polygon& other, const Point2& pivot,
+                                    std::pmr::vector<std::pair<double, double>>& blocked) const
+{
+    // The other polygon may be read by several islands at once, so neither cache is filled here
+    ScratchArena& arena = ScratchArena::local();
+    std::pmr::vector<Point2> storage(&arena);
+    std::pmr::vector<Point2> otherStorage(&arena);
+    const auto vertices = worldVertices(storage);
+    const auto otherVertices = other.worldVertices(otherStorage);
+
+    // Angles at which a vertex following its circle around the pivot crosses an edge. The
+    // vertices of the other polygon turn the opposite way relative to this one.
+    std::pmr::vector<double> critical({0.0, 2.0 * M_PI}, &arena);
+    auto addCrossings = [&pivot, &critical](const Point2& vertex, std::span<const Point2> polygon, double sign)
+    {
+        const double px = vertex.getX() - pivot.getX();
+        const double py = vertex.getY() - pivot.getY();
+        const double vertexAngle = std::atan2(py, px);
 
-        // Check for collision before rotation
-        for (const auto& otherComponent : Scene::getInstance()->components())
+        for (std::size_t i = 0; i < polygon.size(); ++i)
         {
-            std::shared_ptr<Polygon> otherPolygon = std::dynamic_pointer_cast<Polygon>(otherComponent.first);
-            if (this != otherPolygon.get())
-            {
-                if (intersects(otherPolygon, Point(0,0,0)))
-                {
-                    std::cout << magenta << "Collision detected. Change rotation angle." << std::endl<< std::endl;
-                    return;
-                }
-            }
+            addSegmentCrossings(pivot, px * px + py * py, vertexAngle, polygon[i], polygon[(i + 1) % polygon.size()], sign, critical);
         }
-        // Check for collision after rotation
-        for (const auto& otherComponent : Scene::getInstance()->components())
+    };
+
+    for (const Point2& vertex : vertices)
+    {
+        addCrossings(vertex, otherVertices, 1.0);
+    }
+    for (const Point2& vertex : otherVertices)
+    {
+        addCrossings(vertex, vertices, -1.0);
+    }
+    std::sort(critical.begin(), critical.end());
+
+    // The contact state is constant between two critical angles
+    addBlockedSpans(critical, [&](double angle) { return intersectsRotated(other, pivot, angle); }, blocked);
+}
+
+void Polygon::blockedRotationAngles(const CircularShape& other, const Point2& pivot,
+                                    std::pmr::vector<std::pair<double, double>>& blocked) const
+{
+    if (!_vertexCount)
+    {
+        return;
+    }
+    ScratchArena& arena = ScratchArena::local();
+    std::pmr::vector<Point2> storage(&arena);
+    const auto vertices = worldVertices(storage);
+    const double radius = std::max(other.getRadius(), other.getMinorRadius());
+
+    // Turning the Polygon is turning the circle's center the opposite way around the pivot. The
+    // contact state changes where the center's path crosses an edge moved out by the radius, on
+    // either side, or the circle of that radius around a vertex.
+    const double px = other.center().getX() - pivot.getX();
+    const double py = other.center().getY() - pivot.getY();
+    const double radiusSquared = px * px + py * py;
+    const double centerAngle = std::atan2(py, px);
+    std::pmr::vector<double> critical({0.0, 2.0 * M_PI}, &arena);
+    for (std::size_t i = 0; i < vertices.size(); ++i)
+    {
+        const Point2& a = vertices[i];
+        const Point2& b = vertices[(i + 1) % vertices.size()];
+        const Point2 normal = calculateEdgeNormal(b - a);
+        for (double side : {-radius, radius})
         {
-            std::shared_ptr<Polygon> otherPolygon = std::dynamic_pointer_cast<Polygon>(otherComponent.first);
-            if (this != otherPolygon.get())
-            {
-                if (intersects(otherPolygon, Point(0,0,0)))
-                {
-                    std::cout << "Collision detected. Change rotation angle." << std::endl;
-                    return;
-                }
-            }
+            const Point2 offset(side * normal.getX(), side * normal.getY());
+            addSegmentCrossings(pivot, radiusSquared, centerAngle, a + offset, b + offset, -1.0, critical);
         }
-        currentAngle += std::abs(rotationStep);
+        addCircleCrossings(pivot, radiusSquared, centerAngle, a, radius, -1.0, critical);
     }
+    std::sort(critical.begin(), critical.end());
+
+    addBlockedSpans(critical, [&](double angle) { return intersectsRotated(other, pivot, angle); }, blocked);
 }
 
-std::pair<const std::vector<Point>&, const std::vector<Point>&> Polygon::getPoints() const
+bool Polygon::intersectsRotated(const CircularShape& other, const Point2& pivot, double angle) const
 {
-    return {_initialVertices, _transformedVertices};
+    // The circle's center turned the opposite way around the pivot, against the Polygon as it is
+    const double cosTheta = std::cos(angle);
+    const double sinTheta = std::sin(angle);
+    const double dx = other.center().getX() - pivot.getX();
+    const double dy = other.center().getY() - pivot.getY();
+    const Point2 center(pivot.getX() + cosTheta * dx + sinTheta * dy, pivot.getY() - sinTheta * dx + cosTheta * dy);
+    return overlapsDisc(center, std::max(other.getRadius(), other.getMinorRadius()), 1.0);
 }
 
-std::shared_ptr<Polygon> Polygon::getBoundingRectangle() const
+bool Polygon::intersects(const CircularShape& other, [[maybe_unused]] const Point& destination) const
 {
-    auto [min, max] = calculateBoundingBox();
+    return overlapsDisc(Point2(other.center()), other.getRadius(), circleScale(other));
+}
 
-    auto rect = std::make_shared<Polygon>(std::initializer_list<Point>
-                                          {
-                                              (Point(min.getX(), max.getY())),
-                                              (max),
-                                              (Point(max.getX(), min.getY())),
-                                              (min)
-                                          });
+std::optional<double> Polygon::timeOfImpact(const CircularShape& other, const Point& moveVector) const
+{
+    if (!_vertexCount)
+    {
+        return std::nullopt;
+    }
+    if (intersects(other))
+    {
+        return 0.0;
+    }
 
-    return rect;
+    // In the frame where the ellipse is a circle, the center moves against the Polygon
+    const Point& center = other.center();
+    const double scaleY = circleScale(other);
+    const double directionX = -moveVector.getX();
+    const double directionY = -moveVector.getY() * scaleY;
+    auto scaled = [this, &center, scaleY](std::size_t index)
+    {
+        const Point2 vertex = worldVertex(index);
+        return std::pair{vertex.getX(), center.getY() + (vertex.getY() - center.getY()) * scaleY};
+    };
+
+    double first = INFINITY;
+    for (std::size_t i = 0; i < _vertexCount; ++i)
+    {
+        const auto [ax, ay] = scaled(i);
+        const auto [bx, by] = scaled((i + 1) % _vertexCount);
+        first = std::min(first, timeToCapsule(center.getX(), center.getY(), directionX, directionY, ax, ay, bx, by,
+                                              other.getRadius()));
+    }
+    if (first > 1.0)
+    {
+        return std::nullopt;
+    }
+    return first;
 }
 
-std::pair<Point, Point> Polygon::calculateBoundingBox() const
+bool Polygon::overlapsDisc(const Point2& center, double radius, double scaleY) const
+{
+    if (!_vertexCount)
+    {
+        return false;
+    }
+
+    // The edge normals, then the axis toward the nearest vertex, which a disc needs besides them
+    const std::size_t axisCount = _vertexCount + 1;
+    ScratchArena::Scope scope;
+    double* xs = scope.arena().array<double>(2 * _vertexCount + 4 * axisCount);
+    double* ys = xs + _vertexCount;
+    double* axesX = ys + _vertexCount;
+    double* axesY = axesX + axisCount;
+    double* mins = axesY + axisCount;
+    double* maxs = mins + axisCount;
+
+    std::size_t nearest = 0;
+    double nearestDistance = INFINITY;
+    for (std::size_t i = 0; i < _vertexCount; ++i)
+    {
+        const Point2 vertex = worldVertex(i);
+        xs[i] = vertex.getX();
+        ys[i] = center.getY() + (vertex.getY() - center.getY()) * scaleY;
+        const double distance = (xs[i] - center.getX()) * (xs[i] - center.getX()) + (ys[i] - center.getY()) * (ys[i] - center.getY());
+        if (distance < nearestDistance)
+        {
+            nearestDistance = distance;
+            nearest = i;
+        }
+    }
+    for (std::size_t i = 0; i < _vertexCount; ++i)
+    {
+        const std::size_t next = (i + 1) % _vertexCount;
+        const Point2 axis = calculateEdgeNormal(Point2(xs[next] - xs[i], ys[next] - ys[i]));
+        axesX[i] = axis.getX();
+        axesY[i] = axis.getY();
+    }
+    const double towardX = xs[nearest] - center.getX();
+    const double towardY = ys[nearest] - center.getY();
+    const double length = std::sqrt(towardX * towardX + towardY * towardY);
+    axesX[_vertexCount] = length ? towardX / length : 0.0;
+    axesY[_vertexCount] = length ? towardY / length : 0.0;
+
+    SatKernel::project(xs, ys, _vertexCount, axesX, axesY, axisCount, mins, maxs);
+    for (std::size_t axis = 0; axis < axisCount; ++axis)
+    {
+        const double middle = axesX[axis] * center.getX() + axesY[axis] * center.getY();
+        if (maxs[axis] < middle - radius || middle + radius < mins[axis])
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool Polygon::intersectsRotated(const Polygon& other, const Point2& pivot, double angle) const
 {
-    const auto& vertices = _transformedVertices.empty() ? _initialVertices : _transformedVertices;
+    const std::size_t count = _vertexCount;
+    const std::size_t otherCount = other._vertexCount;
+    const std::size_t axisCount = count + otherCount;
+    if (!count || !otherCount)
+    {
+        return false;
+    }
+
+    // Pose of this polygon turned around the pivot; its vertices are never rotated
+    const double cosTheta = std::cos(angle);
+    const double sinTheta = std::sin(angle);
+    const double dx = _center.getX() - pivot.getX();
+    const double dy = _center.getY() - pivot.getY();
+    const Point2 center(pivot.getX() + cosTheta * dx - sinTheta * dy, pivot.getY() + sinTheta * dx + cosTheta * dy);
+    const double turnedCos = cosTheta * _cos - sinTheta * _sin;
+    const double turnedSin = sinTheta * _cos + cosTheta * _sin;
+
+    ScratchArena::Scope scope;
+    double* axesX = scope.arena().array<double>(8 * axisCount);
+    double* axesY = axesX + axisCount;
+    double* localAxes = axesY + axisCount;
+    double* minA = localAxes + 2 * axisCount;
+    double* maxA = minA + axisCount;
+    double* minB = maxA + axisCount;
+    double* maxB = minB + axisCount;
 
-    std::vector<double> xValues;
-    std::vector<double> yValues;
-    std::vector<double> zValues;
+    rotateNormals(turnedCos, turnedSin, axesX, axesY);
+    other.rotateNormals(other._cos, other._sin, axesX + count, axesY + count);
 
-    for (const auto& point : vertices)
+    projectPosed(turnedCos, turnedSin, center, axesX, axesY, axisCount, localAxes, minA, maxA);
+    other.projectPosed(other._cos, other._sin, Point2(other._center), axesX, axesY, axisCount, localAxes, minB, maxB);
+
+    for (std::size_t axis = 0; axis < axisCount; ++axis)
+    {
+        if (maxA[axis] < minB[axis] || maxB[axis] < minA[axis])
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+void Polygon::applyRotation(const Point& pivot, double angle)
+{
+    // Same rounding of the sine and cosine as Point::rotate
+    const double angleRad = angle * (M_PI / 180.0);
+    const double tolerance = 1e-6;
+    double cosTheta = std::cos(angleRad);
+    double sinTheta = std::sin(angleRad);
+    if (std::abs(cosTheta) < tolerance)
+    {
+        cosTheta = 0;
+    }
+    if (std::abs(sinTheta) < tolerance)
     {
-        xValues.push_back(point.getX());
-        yValues.push_back(point.getY());
-        zValues.push_back(point.getZ());
+        sinTheta = 0;
     }
 
-    double minX = *std::min_element(xValues.begin(), xValues.end());
-    double minY = *std::min_element(yValues.begin(), yValues.end());
-    double minZ = *std::min_element(zValues.begin(), zValues.end());
-    double maxX = *std::max_element(xValues.begin(), xValues.end());
-    double maxY = *std::max_element(yValues.begin(), yValues.end());
-    double maxZ = *std::max_element(zValues.begin(), zValues.end());
+    const double dx = _center.getX() - pivot.getX();
+    const double dy = _center.getY() - pivot.getY();
+    _center.setX(cosTheta * dx - sinTheta * dy + pivot.getX());
+    _center.setY(sinTheta * dx + cosTheta * dy + pivot.getY());
 
-    Point minPoint(minX, minY, minZ);
-    Point maxPoint(maxX, maxY, maxZ);
+    // Renormalized, so the rounding of many steps never scales the Polygon
+    const double composedCos = cosTheta * _cos - sinTheta * _sin;
+    const double composedSin = sinTheta * _cos + cosTheta * _sin;
+    const double length = std::hypot(composedCos, composedSin);
+    _cos = composedCos / length;
+    _sin = composedSin / length;
 
+    _posed = true;
+    _verticesCurrent = false;
+    updateRotatedBox();
+}
 
-    return {minPoint, maxPoint};
+std::pair<std::vector<Point2>, std::span<const Point2>> Polygon::getPoints() const
+{
+    return {initialVertices(), transformedVertices()};
+}
+
+Polygon Polygon::getBoundingRectangle() const
+{
+    auto [min, max] = calculateBoundingBox();
+
+    return Polygon({
+                       (Point(min.getX(), max.getY())),
+                       (max),
+                       (Point(max.getX(), min.getY())),
+                       (min)
+                   });
+}
+
+std::pair<Point, Point> Polygon::calculateBoundingBox() const
+{
+    if (!_vertexCount)
+    {
+        return {};
+    }
+    return {_center + _boxMin, _center + _boxMax};
 }
 
 // Collision detection between any two polygons' bounding rectangles
-bool Polygon::collidesWithOther(const std::shared_ptr<Shape>& other) const
+bool Polygon::collidesWithOther(const Shape& other) const
 {
     auto [min1, max1] = calculateBoundingBox();
-    auto [min2, max2] = other->calculateBoundingBox();
+    auto [min2, max2] = other.calculateBoundingBox();
 
     // Check if the bounding boxes intersect
 
@@ -202,89 +696,189 @@ bool Polygon::collidesWithOther(const std::shared_ptr<Shape>& other) const
     return true;
 }
 
-std::vector<Point> Polygon::getEdges() const
+std::vector<Point2> Polygon::getEdges() const
 {
-    std::vector<Point> edges;
-    size_t size = transformedVertices().size();
+    const auto vertices = transformedVertices();
+    std::vector<Point2> edges;
+    edges.reserve(vertices.size());
+    size_t size = vertices.size();
     for(size_t i = 0; i < size; i++)
     {
-        const auto& vertex1 = transformedVertices().at(i);
-        const auto& vertex2 = transformedVertices().at( (i+1) % size );
+        const auto& vertex1 = vertices[i];
+        const auto& vertex2 = vertices[(i+1) % size];
 
         edges.emplace_back(vertex2 - vertex1);
     }
     return edges;
 }
 
-bool Polygon::intersects(const std::shared_ptr<Polygon>& other, const Point& destination) const
+bool Polygon::intersects(const Polygon& other, const Point& destination) const
+{
+    const Point2 excluded(destination);
+    if (hasVertex(excluded) || other.hasVertex(excluded))
+    {
+        // The cached self projections include the excluded vertex
+        return intersectsExcluding(other, excluded);
+    }
+
+    // Check overlap on the axes of polygon A, then on the axes of polygon B
+    return !separatesOnOwnAxes(other) && !other.separatesOnOwnAxes(*this);
+}
+
+std::optional<double> Polygon::timeOfImpact(const Polygon& other, const Point& moveVector) const
+{
+    double first = -INFINITY;
+    double last = INFINITY;
+
+    if (!sweepOnOwnAxes(other, moveVector, false, first, last) ||
+        !other.sweepOnOwnAxes(*this, moveVector, true, first, last))
+    {
+        return std::nullopt;
+    }
+
+    if (first > last || first > 1.0 || last < 0.0)
+    {
+        return std::nullopt;
+    }
+    return std::max(first, 0.0);
+}
+
+bool Polygon::sweepOnOwnAxes(const Polygon& other, const Point& moveVector, bool otherMoves,
+                             double& first, double& last) const
 {
-    const std::vector<Point>& verticesA =  transformedVertices();
-    const std::vector<Point>& verticesB = other->transformedVertices();
+    const std::size_t axisCount = _vertexCount;
+    if (!axisCount || !other._vertexCount)
+    {
+        return true;
+    }
 
-    const std::vector<Point>& edgesA = getEdges();
-    const std::vector<Point>& edgesB = other->getEdges();
+    // Everything is measured in this polygon's local frame, where its own intervals are cached
+    double cosTheta = 1.0;
+    double sinTheta = 0.0;
+    Point2 center;
+    relativePose(other, cosTheta, sinTheta, center);
 
-    // Check overlap on all axes of polygon A
-    for (const Point& edge : edgesA)
+    double fixedMin[FIXED_POLYGON_MAX_VERTICES];
+    double fixedMax[FIXED_POLYGON_MAX_VERTICES];
+    double* minB = fixedMin;
+    double* maxB = fixedMax;
+    ScratchArena::Scope scope;
+    if (const FixedKernels* kernels = fixedKernels(axisCount, other._vertexCount))
+    {
+        kernels->projectOnAxes(localColumns(), other.localColumns(),
+                               {cosTheta, sinTheta, center.getX(), center.getY()}, minB, maxB);
+    }
+    else
     {
-        Point axis = calculateEdgeNormal(edge);
-        float minA = INFINITY;
-        float maxA = -INFINITY;
-        for (const Point& vertex : verticesA)
+        double* localAxes = scope.arena().array<double>(4 * axisCount);
+        minB = localAxes + 2 * axisCount;
+        maxB = minB + axisCount;
+        other.projectPosed(cosTheta, sinTheta, center, column(NormalX), column(NormalY), axisCount, localAxes, minB, maxB);
+    }
+
+    const double moveX = _cos * moveVector.getX() + _sin * moveVector.getY();
+    const double moveY = _cos * moveVector.getY() - _sin * moveVector.getX();
+    const double* normalsX = column(NormalX);
+    const double* normalsY = column(NormalY);
+    const double* selfMin = column(SelfMin);
+    const double* selfMax = column(SelfMax);
+
+    for (std::size_t axis = 0; axis < axisCount; ++axis)
+    {
+        // Interval of the moving polygon, interval of the still one and the speed along the axis
+        double minMoving = otherMoves ? minB[axis] : selfMin[axis];
+        double maxMoving = otherMoves ? maxB[axis] : selfMax[axis];
+        double minStill = otherMoves ? selfMin[axis] : minB[axis];
+        double maxStill = otherMoves ? selfMax[axis] : maxB[axis];
+        const double speed = normalsX[axis] * moveX + normalsY[axis] * moveY;
+
+        if (speed == 0.0)
         {
-            if (vertex == destination) continue;
-            float projection = axis.dotProduct(vertex);
-            minA = std::min(minA, projection);
-            maxA = std::max(maxA, projection);
+            if (maxMoving < minStill || maxStill < minMoving)
+            {
+                return false;  // Separated on this axis for the whole move
+            }
+            continue;
         }
 
-        // Project vertices of polygon B onto the axis
-        float minB = INFINITY;
-        float maxB = -INFINITY;
-        for (const Point& vertex : verticesB)
+        double enter = (minStill - maxMoving) / speed;
+        double exit = (maxStill - minMoving) / speed;
+        if (speed < 0.0)
         {
-            if (vertex == destination) continue;
-            float projection = axis.dotProduct(vertex);
-            minB = std::min(minB, projection);
-            maxB = std::max(maxB, projection);
+            enter = (maxStill - minMoving) / speed;
+            exit = (minStill - maxMoving) / speed;
         }
 
-        // Check for overlap
-        if (maxA < minB || maxB < minA)
+        first = std::max(first, enter);
+        last = std::min(last, exit);
+        if (first > last)
         {
             return false;
         }
     }
+    return true;
+}
 
-    // Check overlap on all axes of polygon B
-    for (const Point& edge : edgesB)
+bool Polygon::separatesOnOwnAxes(const Polygon& other) const
+{
+    const std::size_t axisCount = _vertexCount;
+    if (!axisCount || !other._vertexCount)
     {
-        Point axis = calculateEdgeNormal(edge);
+        return false;
+    }
 
-        float minA = INFINITY;
-        float maxA = -INFINITY;
-        for (const Point& vertex : verticesA)
-        {
-            if (vertex == destination) continue;
+    // Only the other polygon is projected, in this polygon's local frame where its intervals are cached
+    double cosTheta = 1.0;
+    double sinTheta = 0.0;
+    Point2 center;
+    relativePose(other, cosTheta, sinTheta, center);
 
-            float projection = axis.dotProduct(vertex);
-            minA = std::min(minA, projection);
-            maxA = std::max(maxA, projection);
-        }
+    // Small polygons take the kernel unrolled for their vertex counts
+    if (const FixedKernels* kernels = fixedKernels(axisCount, other._vertexCount))
+    {
+        return kernels->separates(localColumns(), other.localColumns(), {cosTheta, sinTheta, center.getX(), center.getY()});
+    }
 
-        // Project vertices of polygon B onto the axis
-        float minB = INFINITY;
-        float maxB = -INFINITY;
-        for (const Point& vertex : verticesB)
+    ScratchArena::Scope scope;
+    double* localAxes = scope.arena().array<double>(4 * axisCount);
+    double* minB = localAxes + 2 * axisCount;
+    double* maxB = minB + axisCount;
+    other.projectPosed(cosTheta, sinTheta, center, column(NormalX), column(NormalY), axisCount, localAxes, minB, maxB);
+
+    const double* selfMin = column(SelfMin);
+    const double* selfMax = column(SelfMax);
+    for (std::size_t axis = 0; axis < axisCount; ++axis)
+    {
+        if (selfMax[axis] < minB[axis] || maxB[axis] < selfMin[axis])
         {
-            if (vertex == destination) continue;
-            float projection = axis.dotProduct(vertex);
-            minB = std::min(minB, projection);
-            maxB = std::max(maxB, projection);
+            return true;
         }
+    }
+    return false;
+}
+
+bool Polygon::intersectsExcluding(const Polygon& other, const Point2& excluded) const
+{
+    const std::size_t countA = _vertexCount;
+    const std::size_t axisCount = countA + other._vertexCount;
+
+    ScratchArena::Scope scope;
+    double* axesX = scope.arena().array<double>(6 * axisCount);
+    double* axesY = axesX + axisCount;
+    double* minA = axesY + axisCount;
+    double* maxA = minA + axisCount;
+    double* minB = maxA + axisCount;
+    double* maxB = minB + axisCount;
+
+    rotateNormals(_cos, _sin, axesX, axesY);
+    other.rotateNormals(other._cos, other._sin, axesX + countA, axesY + countA);
 
-        // Check for overlap
-        if (maxA < minB || maxB < minA)
+    projectVertices(excluded, axesX, axesY, axisCount, minA, maxA);
+    other.projectVertices(excluded, axesX, axesY, axisCount, minB, maxB);
+
+    for (std::size_t axis = 0; axis < axisCount; ++axis)
+    {
+        if (maxA[axis] < minB[axis] || maxB[axis] < minA[axis])
         {
             return false;  // No overlap, polygons are not colliding
         }
@@ -293,86 +887,258 @@ bool Polygon::intersects(const std::shared_ptr<Polygon>& other, const Point& des
     return true;  // Overlap on all axes, polygons are colliding
 }
 
-Point Polygon::calculatePolygonCenter()
+bool Polygon::hasVertex(const Point2& vertex) const
+{
+    for (std::size_t i = 0; i < _vertexCount; ++i)
+    {
+        if (worldVertex(i) == vertex)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+void Polygon::projectVertices(const Point2& excluded, const double* axesX, const double* axesY, std::size_t axisCount,
+                              double* mins, double* maxs) const
 {
-    if (!_transformedVertices.size())
+    ScratchArena::Scope scope;
+    double* xs = scope.arena().array<double>(_vertexCount);
+    double* ys = scope.arena().array<double>(_vertexCount);
+    std::size_t count = 0;
+    for (std::size_t i = 0; i < _vertexCount; ++i)
     {
-        if (!_initialVertices.size())
+        const Point2 vertex = worldVertex(i);
+        if (vertex != excluded)
         {
-            return Point(0, 0, 0);
+            xs[count] = vertex.getX();
+            ys[count] = vertex.getY();
+            ++count;
         }
+    }
+
+    if (!count)
+    {
+        std::fill(mins, mins + axisCount, INFINITY);
+        std::fill(maxs, maxs + axisCount, -INFINITY);
+        return;
+    }
+    SatKernel::project(xs, ys, count, axesX, axesY, axisCount, mins, maxs);
+}
+
+Point Polygon::calculatePolygonCenter() const
+{
+    return _center;
+}
 
-        double sumX = 0, sumY = 0, sumZ = 0;
-        for (const auto& vertex : _initialVertices)
+std::vector<Point2> Polygon::getVertices() const
+{
+    return initialVertices();
+}
+
+std::span<const Point2> Polygon::transformedVertices() const
+{
+    if (!_verticesCurrent)
+    {
+        _transformedVertices.resize(_vertexCount);
+        for (std::size_t i = 0; i < _vertexCount; ++i)
         {
-            sumX += vertex.getX();
-            sumY += vertex.getY();
-            sumZ += vertex.getZ();
+            _transformedVertices[i] = worldVertex(i);
         }
+        _verticesCurrent = true;
+    }
+    return _transformedVertices;
+}
 
-        Point point(sumX / _initialVertices.size(), sumY / _initialVertices.size(), sumZ / _initialVertices.size());
 
-        setCenter(point);
+std::vector<Point2> Polygon::initialVertices() const
+{
+    std::vector<Point2> vertices;
+    vertices.reserve(_vertexCount);
+    const double* xs = column(LocalX);
+    const double* ys = column(LocalY);
+    for (std::size_t i = 0; i < _vertexCount; ++i)
+    {
+        vertices.emplace_back(_initialCenter.getX() + xs[i], _initialCenter.getY() + ys[i]);
+    }
+    return vertices;
+}
 
-        return point;
+void Polygon::setInitialVertices(const std::vector<Point> &newInitialVertices)
+{
+    // The Polygon lies in the plane parallel to xy at the mean height of the vertices
+    _transformedVertices.clear();
+    _transformedVertices.reserve(newInitialVertices.size());
+    double sumZ = 0;
+    for (const Point& vertex : newInitialVertices)
+    {
+        _transformedVertices.emplace_back(vertex);
+        sumZ += vertex.getZ();
     }
+    _verticesCurrent = true;
+    _center.setZ(newInitialVertices.empty() ? 0.0 : sumZ / newInitialVertices.size());
+    resetPose();
+}
+
+void Polygon::setCenter(const Point& center)
+{
+    _center = center;
+    _posed = true;
+    _verticesCurrent = false;
+}
+
 
-    // Calculate center based on transformed vertices
-    double sumX = 0, sumY = 0, sumZ = 0;
+Point2 Polygon::calculateEdgeNormal(const Point2& edge) const
+{
+    double nx = edge.getY();
+    double ny = -edge.getX();
+    double length = std::sqrt(nx * nx + ny * ny);
+    if (length != 0) {
+        nx /= length;
+        ny /= length;
+    }
+    return Point2(nx, ny);
+}
+
+void Polygon::resetPose()
+{
+    const std::size_t size = _transformedVertices.size();
+    double sumX = 0, sumY = 0;
     for (const auto& vertex : _transformedVertices)
     {
         sumX += vertex.getX();
         sumY += vertex.getY();
-        sumZ += vertex.getZ();
     }
+    _center = size ? Point(sumX / size, sumY / size, _center.getZ()) : Point(0, 0, _center.getZ());
+    _cos = 1.0;
+    _sin = 0.0;
+    _initialCenter = Point2(_center);
+    _posed = false;
+    _verticesCurrent = true;
 
-    Point point(sumX / _transformedVertices.size(), sumY / _transformedVertices.size(), sumZ / _transformedVertices.size());
+    _vertexCount = size;
+    _local.assign(COLUMN_COUNT * size, 0.0);
+    _local.shrink_to_fit();
+    double* xs = column(LocalX);
+    double* ys = column(LocalY);
+    for (std::size_t i = 0; i < size; ++i)
+    {
+        const Point2 local = _transformedVertices[i] - _initialCenter;
+        xs[i] = local.getX();
+        ys[i] = local.getY();
+    }
 
-    setCenter(point);
+    double* normalsX = column(NormalX);
+    double* normalsY = column(NormalY);
+    for (std::size_t i = 0; i < size; ++i)
+    {
+        const std::size_t next = (i + 1) % size;
+        const Point2 axis = calculateEdgeNormal(Point2(xs[next] - xs[i], ys[next] - ys[i]));
+        normalsX[i] = axis.getX();
+        normalsY[i] = axis.getY();
+    }
 
-    return point;
+    if (size)
+    {
+        SatKernel::project(xs, ys, size, normalsX, normalsY, size, column(SelfMin), column(SelfMax));
+    }
+    updateRotatedBox();
 }
 
-std::vector<Point> Polygon::getVertices() const
+void Polygon::updateRotatedBox()
 {
-    return  _initialVertices;
+    _boxMin = Point2(INFINITY, INFINITY);
+    _boxMax = Point2(-INFINITY, -INFINITY);
+    const double* xs = column(LocalX);
+    const double* ys = column(LocalY);
+    for (std::size_t i = 0; i < _vertexCount; ++i)
+    {
+        const double x = _cos * xs[i] - _sin * ys[i];
+        const double y = _sin * xs[i] + _cos * ys[i];
+        _boxMin = Point2(std::min(_boxMin.getX(), x), std::min(_boxMin.getY(), y));
+        _boxMax = Point2(std::max(_boxMax.getX(), x), std::max(_boxMax.getY(), y));
+    }
 }
 
-std::vector<Point> Polygon::transformedVertices() const
+Point2 Polygon::worldVertex(std::size_t index) const
 {
-    return  _transformedVertices.empty() ? _initialVertices : _transformedVertices;
+    if (!_posed)
+    {
+        return _transformedVertices[index];
+    }
+    const double x = column(LocalX)[index];
+    const double y = column(LocalY)[index];
+    return Point2(_center.getX() + (_cos * x - _sin * y), _center.getY() + (_sin * x + _cos * y));
 }
 
-
-std::vector<Point> Polygon::initialVertices() const
+std::span<const Point2> Polygon::worldVertices(std::pmr::vector<Point2>& storage) const
 {
-    return _initialVertices;
+    // Before the first step the cache always holds the vertices as given
+    if (_verticesCurrent)
+    {
+        return _transformedVertices;
+    }
+    storage.clear();
+    for (std::size_t i = 0; i < _vertexCount; ++i)
+    {
+        storage.push_back(worldVertex(i));
+    }
+    return storage;
 }
 
-void Polygon::setInitialVertices(const std::vector<Point> &newInitialVertices)
+double Polygon::farthestVertexDistance(const Point2& pivot) const
 {
-    _initialVertices = newInitialVertices;
+    double radius = 0.0;
+    for (std::size_t i = 0; i < _vertexCount; ++i)
+    {
+        radius = std::max(radius, (worldVertex(i) - pivot).getVectorNorm());
+    }
+    return radius;
 }
 
-inline const Point& Polygon::getCenter() const
+void Polygon::relativePose(const Polygon& other, double& cosTheta, double& sinTheta, Point2& center) const
 {
-    return _center;
+    cosTheta = _cos * other._cos + _sin * other._sin;
+    sinTheta = _cos * other._sin - _sin * other._cos;
+    const double dx = other._center.getX() - _center.getX();
+    const double dy = other._center.getY() - _center.getY();
+    center = Point2(_cos * dx + _sin * dy, _cos * dy - _sin * dx);
 }
-void Polygon::setCenter(const Point& center)
+
+PolygonColumns Polygon::localColumns() const
 {
-    _center = center;
+    return {column(LocalX), column(LocalY), column(NormalX), column(NormalY), column(SelfMin), column(SelfMax)};
 }
 
-
-Point Polygon::calculateEdgeNormal(const Point& edge) const
+void Polygon::rotateNormals(double cosTheta, double sinTheta, double* axesX, double* axesY) const
 {
-    float nx = edge.getY();
-    float ny = -edge.getX();
-    float length = std::sqrt(nx * nx + ny * ny);
-    if (length != 0) {
-        nx /= length;
-        ny /= length;
+    const double* normalsX = column(NormalX);
+    const double* normalsY = column(NormalY);
+    for (std::size_t i = 0; i < _vertexCount; ++i)
+    {
+        axesX[i] = cosTheta * normalsX[i] - sinTheta * normalsY[i];
+        axesY[i] = sinTheta * normalsX[i] + cosTheta * normalsY[i];
     }
-    return Point(nx, ny);
 }
 
+void Polygon::projectPosed(double cosTheta, double sinTheta, const Point2& center,
+                           const double* axesX, const double* axesY, std::size_t axisCount,
+                           double* localAxes, double* mins, double* maxs) const
+{
+    // A world axis a projects a vertex center + R * local to a . center + (R^T a) . local
+    double* localX = localAxes;
+    double* localY = localAxes + axisCount;
+    for (std::size_t axis = 0; axis < axisCount; ++axis)
+    {
+        localX[axis] = cosTheta * axesX[axis] + sinTheta * axesY[axis];
+        localY[axis] = cosTheta * axesY[axis] - sinTheta * axesX[axis];
+    }
+    SatKernel::project(column(LocalX), column(LocalY), _vertexCount, localX, localY, axisCount, mins, maxs);
+
+    for (std::size_t axis = 0; axis < axisCount; ++axis)
+    {
+        const double offset = axesX[axis] * center.getX() + axesY[axis] * center.getY();
+        mins[axis] += offset;
+        maxs[axis] += offset;
+    }
+}
@@ -1,7 +1,7 @@
 /**
  * @file Polygon.h
  *
- * @brief Defines the Polygon class, representing a polygon in three-dimensional space.
+ * @brief Defines the Polygon class, representing a polygon in a plane parallel to xy.
  */
 
 #ifndef POLYGON_H
@@ -9,8 +9,11 @@
 
 #include <memory>
 #include "point.h"
+#include "broadphase.h"
 #include "shape.h"
 #include "scene.h"
+#include "satkernel.h"
+#include "fixedpolygon.h"
 #include <iostream>
 #include <vector>
 #include <memory>
@@ -22,14 +25,25 @@
 #include <ranges>
 #include <random>
 #include <optional>
+#include <span>
 #include <unordered_set>
 
 /**
  * @class Polygon
- * @brief Represents a polygon in three-dimensional space.
- * @details Inherits from Shape and enables shared ownership using enable_shared_from_this.
+ * @brief Represents a polygon in a plane parallel to xy.
+ * @details Inherits from Shape. The polygons of a Scene live in its ShapePool of polygons.
+ * The vertices are given as Point for the Shape interface but kept as Point2; the height of the
+ * plane is the z of the center.
+ *
+ * The vertices are kept relative to their centroid, together with a rigid pose: the world
+ * position of the centroid and a rotation. Moving or rotating the Polygon only changes the
+ * pose, and the separating axis tests turn the axes into the local frame of a polygon instead
+ * of transforming its vertices. The world vertices are computed from the pose the first time
+ * transformedVertices() needs them after a step; until the first step they are the vertices as
+ * given. The local vertices are the only copy of the shape, so the initial vertices are rebuilt
+ * from them and the initial center.
  */
-class Polygon : public Shape , public std::enable_shared_from_this<Polygon>
+class Polygon : public Shape
 {
 public:
     /**
@@ -40,6 +54,7 @@ public:
     * @param initialVertices A list of initial vertices to initialize the Polygon.
     */
     Polygon(const std::initializer_list<Point> & initialVertices);
+    explicit Polygon(std::vector<Point> initialVertices);
 
     /**
     * @brief Copy constructor for Polygon.
@@ -52,52 +67,79 @@ public:
     /**
     * @brief Moves the Polygon towards a destination point.
     *
-    * This method moves the Polygon towards a specified destination point by applying
-    * a series of steps. The step size is determined by the `stepSize` parameter.
+    * The path from the center to the destination is swept in one pass against the neighboring
+    * shapes (see timeOfImpact()). The Polygon either jumps to the destination or stops just
+    * before the first contact along the way, so thin obstacles cannot be tunneled through.
     *
     * @param destination The destination point to which the Polygon should be moved.
-    * @param stepSize The size of each movement step.
+    * @param stepSize Kept for the Shape interface; the continuous sweep needs no step size.
     */
 
     void move(const Point& destination, double stepSize) override;
     /**
     * @brief Rotates the Polygon around a pivot point.
     *
-    * This method rotates the Polygon around a specified pivot point by applying
-    * a rotation step. The rotation direction (clockwise or counterclockwise) is
+    * This method rotates the Polygon around a specified pivot point by the given angle, or
+    * up to just before the first contact with another shape if that comes earlier (see
+    * maxRotationAngle()). The rotation direction (clockwise or counterclockwise) is
     * determined by the `clockwise` parameter.
     *
     * @param pivot The pivot point around which the Polygon will be rotated.
-    * @param step The rotation step in degrees.
+    * @param step The rotation angle in degrees.
     * @param clockwise Flag indicating the rotation direction (clockwise if true, counterclockwise otherwise).
+    * @return The angle in degrees by which the Polygon was rotated.
     */
 
-    void rotate(const Point &pivot, double step, bool clockwise);
+    double rotate(const Point &pivot, double step, bool clockwise) override;
+
     /**
-    * @brief Retrieves a shared pointer to a bounding rectangle Polygon. This function is similar to CircularShape::getBoundingRectangle()
+    * @brief Computes the angles at which the Polygon, rotated around a pivot, overlaps nothing.
+    *
+    * A convex polygon starts or stops overlapping another one only when a vertex of one
+    * crosses an edge of the other. For every vertex, the circle it follows around the pivot is
+    * intersected with the edges of the nearby shapes, which gives all angles where the contact
+    * state can change. One SAT test between two consecutive angles then classifies the whole
+    * interval, so the cost does not depend on any angular step.
+    *
+    * @param pivot The pivot point of the rotation.
+    * @param free Receives the sorted collision-free intervals [start, end] of rotation angles in
+    *        degrees within [0, 360], measured in the clockwise direction used by rotate().
+    */
+    void freeRotationIntervals(const Point& pivot, std::pmr::vector<std::pair<double, double>>& free) const;
+
+    /**
+    * @brief Returns the largest angle, up to a limit, the Polygon can rotate without contact.
+    * @param pivot The pivot point of the rotation.
+    * @param clockwise The rotation direction.
+    * @param limit The largest angle of interest in degrees.
+    * @return The reachable angle in degrees, 0 if the Polygon is already blocked.
+    */
+    double maxRotationAngle(const Point& pivot, bool clockwise, double limit = 360.0) const;
+    // Box of the disc swept by the Polygon rotating around the pivot; rotating only meets what touches it
+    Broadphase::Box rotationRegion(const Point& pivot) const;
+    /**
+    * @brief Retrieves a bounding rectangle Polygon. This function is similar to CircularShape::getBoundingRectangle()
     *
     * This method calculates the bounding box of the Polygon and constructs a new Polygon representing
-    * the bounding rectangle. The shared pointer to the bounding rectangle Polygon is then returned.
+    * the bounding rectangle, which belongs to no Scene.
     *
     * The bounding rectangle is created using the minimum (min) and maximum (max) corners of the bounding
     * box obtained from the `calculateBoundingBox` method.
     *
-    * @return A shared pointer to a new Polygon representing the bounding rectangle.
-    *         If no vertices are available for the bounding box, a null shared pointer is returned.
+    * @return A new Polygon representing the bounding rectangle.
     *
     * @note This function was initialy implemented to detect collision between any two shapes.
     * @attention Thus all shapes are considered convex.
     * @warning This method may cause false collison detection.
     * @see intersects()
     */
-    std::shared_ptr<Polygon> getBoundingRectangle() const ;
+    Polygon getBoundingRectangle() const ;
 
     /**
     * @brief Calculates the bounding box of the Polygon.
     *
-    * This method calculates the bounding box of the Polygon based on either the initial vertices
-    * or the transformed vertices, whichever is available. If neither is available, an empty pair
-    * is returned.
+    * The box of the rotated local vertices is kept with the pose, so this only shifts it by the
+    * center. If the Polygon has no vertices, an empty pair is returned.
     *
     * The bounding box is represented by a pair of Points: the minimum (minPoint) and maximum (maxPoint)
     * corners of the box.
@@ -108,8 +150,8 @@ public:
     std::pair<Point, Point> calculateBoundingBox() const override;
 
     // Collision detection between any two polygons' bounding rectangles
-    bool collidesWithOther(const std::shared_ptr<Shape> &other) const;
-    std::vector<Point> getEdges() const;
+    bool collidesWithOther(const Shape& other) const;
+    std::vector<Point2> getEdges() const;
 
     /**
     * @brief Checks if the Polygon intersects with another Polygon at a specific destination.
@@ -117,40 +159,162 @@ public:
     * This function determines whether the calling Polygon intersects with the provided Polygon
     * when both are positioned at the specified destination point.
     *
-    * @param other A shared pointer to the other Polygon for intersection comparison.
+    * @param other The other Polygon for intersection comparison.
     * @param destination The destination point where both Polygons are positioned for comparison.
     * @return True if the Polygons intersect at the specified destination, otherwise false.
     */
-    bool intersects(const std::shared_ptr<Polygon>& other, const Point& destination) const;
+    bool intersects(const Polygon& other, const Point& destination) const;
 
     /**
-    * @brief Calculates the center of the Polygon.
+    * @brief Computes when the Polygon first touches another Polygon while translating.
     *
-    * This method calculates the center of the Polygon based on either the initial vertices
-    * or the transformed vertices, whichever is available. If neither is available, a default
-    * Point at the origin (0, 0, 0) is returned.
+    * Swept separating axis test: on every edge normal of both polygons the moving projection
+    * interval slides with the speed of the move vector along that axis, which bounds the time
+    * span during which the intervals overlap. The polygons touch while all spans overlap.
     *
-    * @return The calculated center Point of the Polygon.
+    * @param other The Polygon that stays still.
+    * @param moveVector The translation applied to this Polygon.
+    * @return The fraction of the move vector, in [0, 1], at which the polygons first touch,
+    *         0 if they already overlap, or no value if they stay apart for the whole move.
     */
-    Point calculatePolygonCenter();
+    std::optional<double> timeOfImpact(const Polygon& other, const Point& moveVector) const;
 
-    bool isColliding(const std::shared_ptr<Shape>& other) const override
+    /**
+    * @brief Checks if the Polygon overlaps a circle or an ellipse.
+    *
+    * Separating axis test on the edge normals of the Polygon and on the axis from the circle's
+    * center to the nearest vertex. An ellipse is scaled vertically into a circle first; the
+    * scaling keeps the Polygon convex and the test exact.
+    *
+    * @param other The circular shape.
+    * @param destination Unused; it matches the polygon overload, but a circular shape has no
+    *        vertex to leave out.
+    */
+    bool intersects(const CircularShape& other, const Point& destination = Point(0, 0, 0)) const;
+
+    /**
+    * @brief Computes when the Polygon first touches a circle or an ellipse while translating.
+    *
+    * Seen from the Polygon, the center of the circle moves the opposite way and touches it when
+    * it comes within the radius of an edge, so the first contact is where that path enters one
+    * of the capsules around the edges. An ellipse is scaled into a circle as in intersects().
+    *
+    * @return The fraction of the move vector, in [0, 1], at which the shapes first touch,
+    *         0 if they already overlap, or no value if they stay apart for the whole move.
+    */
+    std::optional<double> timeOfImpact(const CircularShape& other, const Point& moveVector) const;
+
+    /**
+    * @brief Returns the center of the Polygon.
+    *
+    * The center is the average of the vertices, computed once when the vertices are set and
+    * then carried by the pose. A Polygon without vertices has its center at the origin.
+    *
+    * @return The center Point of the Polygon.
+    */
+    Point calculatePolygonCenter() const;
+
+    bool isColliding(const Shape& other) const override
     {
         return false;
     }
-    std::vector<Point> getVertices() const;
-    std::vector<Point> transformedVertices() const;
-    std::vector<Point> initialVertices() const;
-    std::pair<const std::vector<Point>&, const std::vector<Point>&> getPoints() const;
+    // The vertices where the Polygon was placed, rebuilt from the local vertices up to rounding
+    std::vector<Point2> getVertices() const;
+    std::vector<Point2> initialVertices() const;
+    // Read-only view of the world vertices; it stays valid until the Polygon is moved, rotated or
+    // remapped. It fills a cache on first use, so it must not race with other calls.
+    std::span<const Point2> transformedVertices() const;
+    std::pair<std::vector<Point2>, std::span<const Point2>> getPoints() const;
+    // Sets the vertices and resets the pose to them; the Polygon lies at their mean height
     void setInitialVertices(const std::vector<Point> &newInitialVertices);
-    inline const Point& getCenter() const;
+    const Point& getCenter() const { return _center; }
+    // Places the center at the point, keeping the orientation
     void setCenter(const Point& center);
 
 private:
-    Point calculateEdgeNormal(const Point& edge) const;
-    std::vector<Point> _initialVertices;
-    std::vector<Point> _transformedVertices;
+    Point2 calculateEdgeNormal(const Point2& edge) const;
+    // Places the centroid of the vertices in the cache, which were just given, at the center with
+    // no rotation, and refreshes the local vertices, the edge normals and the self projections
+    void resetPose();
+    // Refreshes the box of the local vertices after the rotation changed
+    void updateRotatedBox();
+    // World position of a vertex under the current pose
+    Point2 worldVertex(std::size_t index) const;
+    // The world vertices, from the cache if it is filled, otherwise computed into the storage;
+    // unlike transformedVertices() it writes nothing to the Polygon
+    std::span<const Point2> worldVertices(std::pmr::vector<Point2>& storage) const;
+    double farthestVertexDistance(const Point2& pivot) const;
+    // Rotation and center of the other polygon in this polygon's local frame
+    void relativePose(const Polygon& other, double& cosTheta, double& sinTheta, Point2& center) const;
+    // Writes the edge normals turned by the rotation
+    void rotateNormals(double cosTheta, double sinTheta, double* axesX, double* axesY) const;
+    // Projects the Polygon, placed at the given pose, on the axes by turning the axes into its
+    // local frame; localAxes receives 2 * axisCount values
+    void projectPosed(double cosTheta, double sinTheta, const Point2& center,
+                      const double* axesX, const double* axesY, std::size_t axisCount,
+                      double* localAxes, double* mins, double* maxs) const;
+    // Narrows the time span [first, last] during which the polygons overlap on this polygon's
+    // axes; returns false if they stay separated on one of them
+    bool sweepOnOwnAxes(const Polygon& other, const Point& moveVector, bool otherMoves,
+                        double& first, double& last) const;
+    // True if one of this polygon's edge normals separates it from the other polygon
+    bool separatesOnOwnAxes(const Polygon& other) const;
+    // Full SAT projecting both polygons, leaving out any vertex equal to the excluded point
+    bool intersectsExcluding(const Polygon& other, const Point2& excluded) const;
+    bool hasVertex(const Point2& vertex) const;
+    // Adds the sorted intervals of rotation angles, in radians, at which the Polygon overlaps the other one
+    void blockedRotationAngles(const Polygon& other, const Point2& pivot,
+                               std::pmr::vector<std::pair<double, double>>& blocked) const;
+    // SAT test against the other polygon with this one rotated around the pivot
+    bool intersectsRotated(const Polygon& other, const Point2& pivot, double angle) const;
+    // Same for a circular shape; an ellipse is taken as the circle of its larger radius, which
+    // contains it whatever the angle
+    void blockedRotationAngles(const CircularShape& other, const Point2& pivot,
+                               std::pmr::vector<std::pair<double, double>>& blocked) const;
+    bool intersectsRotated(const CircularShape& other, const Point2& pivot, double angle) const;
+    // SAT test against the disc, with the world vertices first scaled vertically by scaleY around its center
+    bool overlapsDisc(const Point2& center, double radius, double scaleY) const;
+    // Turns the pose around the pivot, computing the sine and cosine once
+    void applyRotation(const Point& pivot, double angle);
+    // Projects the world vertices on the axes, leaving out any vertex equal to the excluded point
+    void projectVertices(const Point2& excluded, const double* axesX, const double* axesY, std::size_t axisCount,
+                         double* mins, double* maxs) const;
+    // Center the vertices were given around
+    Point2 _initialCenter;
+    // World vertices, computed from the pose on first use after a step; before the first step
+    // they hold the vertices as given
+    mutable std::vector<Point2> _transformedVertices;
+    mutable bool _verticesCurrent = false;
+    // Columns of _local, each _vertexCount values long: the vertices relative to the center, the
+    // unit edge normals and the projection of the polygon on them. All are in the local frame, so
+    // none changes when the Polygon moves or rotates, and one buffer holds them all.
+    enum Column
+    {
+        LocalX,
+        LocalY,
+        NormalX,
+        NormalY,
+        SelfMin,
+        SelfMax,
+        COLUMN_COUNT
+    };
+    const double* column(Column column) const { return _local.data() + column * _vertexCount; }
+    double* column(Column column) { return _local.data() + column * _vertexCount; }
+    // The columns as the FixedPolygon kernels take them
+    PolygonColumns localColumns() const;
+    AlignedDoubles _local;
+    std::size_t _vertexCount = 0;
+    // Pose: world position of the center and rotation of the local frame
     Point _center;
+    double _cos = 1.0;
+    double _sin = 0.0;
+    // False until the first step, while the world vertices are still the initial ones
+    bool _posed = false;
+    // Box of the rotated local vertices, relative to the center
+    Point2 _boxMin;
+    Point2 _boxMax;
+    // Gap left between a moved polygon and the shape that stopped it
+    static constexpr double CONTACT_SKIN = 1e-6;
 };
 
 #endif // POLYGON_H
@@ -0,0 +1,104 @@
+#include "reservationtable.h"
+#include <cmath>
+
+ReservationTable::ReservationTable(double bucketSize) :
+    _bucketSize{bucketSize}
+{
+}
+
+void ReservationTable::reset(double bucketSize)
+{
+    _bucketSize = bucketSize;
+    _buckets.clear();
+    _standing.clear();
+    _size = 0;
+}
+
+void ReservationTable::reserve(std::size_t agent, int time, const Point& center, double radius)
+{
+    _buckets[bucketKey(time, bucketOf(center.getX()), bucketOf(center.getY()))].push_back(
+        {agent, center.getX(), center.getY(), radius});
+    ++_size;
+}
+
+void ReservationTable::reserveStanding(std::size_t agent, const Point& center, double radius)
+{
+    release(agent);
+    const std::int64_t key = bucketKey(STANDING, bucketOf(center.getX()), bucketOf(center.getY()));
+    _buckets[key].push_back({agent, center.getX(), center.getY(), radius});
+    _standing[agent] = key;
+    ++_size;
+}
+
+void ReservationTable::release(std::size_t agent)
+{
+    const auto standing = _standing.find(agent);
+    if (standing == _standing.end())
+    {
+        return;
+    }
+    auto& bucket = _buckets[standing->second];
+    _size -= std::erase_if(bucket, [agent](const Reservation& reservation) { return reservation.agent == agent; });
+    _standing.erase(standing);
+}
+
+bool ReservationTable::isFree(std::size_t agent, int firstTime, int lastTime, const Point& from, const Point& to, double radius) const
+{
+    // Discs that overlap have their centers closer than the bucket size, so in neighboring buckets
+    const int bucketX = bucketOf(to.getX());
+    const int bucketY = bucketOf(to.getY());
+    for (int x = bucketX - 1; x <= bucketX + 1; ++x)
+    {
+        for (int y = bucketY - 1; y <= bucketY + 1; ++y)
+        {
+            // The standing bookings are tested with the last time step
+            for (int time = firstTime; time <= lastTime + 1; ++time)
+            {
+                const auto bucket = _buckets.find(bucketKey(time > lastTime ? STANDING : time, x, y));
+                if (bucket == _buckets.end())
+                {
+                    continue;
+                }
+                for (const Reservation& reservation : bucket->second)
+                {
+                    if (reservation.agent == agent)
+                    {
+                        continue;
+                    }
+                    const double reach = (reservation.radius + radius) * (reservation.radius + radius);
+                    const double after = squaredDistance(reservation, to);
+                    if (after >= reach)
+                    {
+                        continue;
+                    }
+                    const bool sameTime = time == firstTime || time > lastTime;
+                    const double before = squaredDistance(reservation, from);
+                    if (!sameTime || before >= reach || after < before)
+                    {
+                        return false;
+                    }
+                }
+            }
+        }
+    }
+    return true;
+}
+
+double ReservationTable::squaredDistance(const Reservation& reservation, const Point& point)
+{
+    const double dx = reservation.x - point.getX();
+    const double dy = reservation.y - point.getY();
+    return dx * dx + dy * dy;
+}
+
+int ReservationTable::bucketOf(double coordinate) const
+{
+    return static_cast<int>(std::floor(coordinate / _bucketSize));
+}
+
+std::int64_t ReservationTable::bucketKey(int time, int x, int y)
+{
+    // 16 bits of time step and 24 bits per bucket coordinate
+    return (static_cast<std::int64_t>(time) << 48) | (static_cast<std::int64_t>(x & 0xFFFFFF) << 24)
+           | static_cast<std::int64_t>(y & 0xFFFFFF);
+}
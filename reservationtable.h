@@ -0,0 +1,79 @@
+/**
+ * @file ReservationTable.h
+ *
+ * @brief Defines the ReservationTable class, the space-time bookings of cooperative path finding.
+ */
+
+#ifndef RESERVATIONTABLE_H
+#define RESERVATIONTABLE_H
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+#include "point.h"
+
+/**
+ * @class ReservationTable
+ * @brief Discs booked by moving pieces, one per piece and time step.
+ *
+ * A piece planned earlier books the disc it covers at each step of its plan, and the pieces
+ * planned after it only step where their own disc stays clear of those bookings. Bookings are
+ * bucketed by time step and by square cells as large as the widest two discs together, so a
+ * test only looks at the nine cells around the disc at that step, whatever the number of pieces.
+ */
+class ReservationTable
+{
+public:
+    /**
+    * @brief Constructor for ReservationTable.
+    * @param bucketSize Edge length of the buckets, at least the largest sum of two radii.
+    */
+    explicit ReservationTable(double bucketSize = 1.0);
+
+    // Drops every booking and sets the bucket size for the next ones
+    void reset(double bucketSize);
+    void reserve(std::size_t agent, int time, const Point& center, double radius);
+    // Books the disc at every time step, for a piece assumed to wait until it plans its own steps
+    void reserveStanding(std::size_t agent, const Point& center, double radius);
+    // Drops the standing booking of an agent
+    void release(std::size_t agent);
+    /**
+    * @brief Tests a step against the discs other agents booked for a range of time steps.
+    *
+    * A disc that already overlaps a booking at the start of the step, as pieces placed close
+    * together do, may still stay or move away from it, but not closer. Only the bookings of
+    * the first time step and the standing ones are compared with the start of the step.
+    *
+    * @param firstTime, lastTime The time steps whose bookings are tested, inclusive; the step
+    *        starts at firstTime.
+    * @param from Center of the disc before the step.
+    * @param to Center of the disc after the step.
+    * @return True if no booking is entered or approached.
+    */
+    bool isFree(std::size_t agent, int firstTime, int lastTime, const Point& from, const Point& to, double radius) const;
+
+    // Number of bookings
+    std::size_t size() const { return _size; }
+
+private:
+    struct Reservation
+    {
+        std::size_t agent;
+        double x, y, radius;
+    };
+
+    static double squaredDistance(const Reservation& reservation, const Point& point);
+    int bucketOf(double coordinate) const;
+    static std::int64_t bucketKey(int time, int x, int y);
+
+    // Time step of the standing bookings, past any window
+    static constexpr int STANDING = 0xFFFF;
+
+    double _bucketSize;
+    std::unordered_map<std::int64_t, std::vector<Reservation>> _buckets;
+    // Bucket of the standing booking of each agent
+    std::unordered_map<std::size_t, std::int64_t> _standing;
+    std::size_t _size = 0;
+};
+
+#endif // RESERVATIONTABLE_H
@@ -0,0 +1,177 @@
+#include "satkernel.h"
+#include <algorithm>
+#include <limits>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define SATKERNEL_X86 1
+#include <immintrin.h>
+#endif
+
+namespace
+{
+// Number of axes projected in one pass over the vertices
+constexpr std::size_t AXIS_BLOCK = 4;
+
+#ifdef SATKERNEL_X86
+
+__attribute__((target("avx2")))
+void projectAvx2(const double* xs, const double* ys, std::size_t count,
+                 const double* axesX, const double* axesY, std::size_t axisCount,
+                 double* mins, double* maxs)
+{
+    const std::size_t vectorCount = count & ~std::size_t(3);
+
+    for (std::size_t first = 0; first < axisCount; first += AXIS_BLOCK)
+    {
+        const std::size_t block = std::min(AXIS_BLOCK, axisCount - first);
+
+        __m256d ax[AXIS_BLOCK], ay[AXIS_BLOCK], lo[AXIS_BLOCK], hi[AXIS_BLOCK];
+        for (std::size_t a = 0; a < block; ++a)
+        {
+            ax[a] = _mm256_set1_pd(axesX[first + a]);
+            ay[a] = _mm256_set1_pd(axesY[first + a]);
+            lo[a] = _mm256_set1_pd(std::numeric_limits<double>::infinity());
+            hi[a] = _mm256_set1_pd(-std::numeric_limits<double>::infinity());
+        }
+
+        for (std::size_t i = 0; i < vectorCount; i += 4)
+        {
+            const __m256d x = _mm256_loadu_pd(xs + i);
+            const __m256d y = _mm256_loadu_pd(ys + i);
+            for (std::size_t a = 0; a < block; ++a)
+            {
+                const __m256d projection = _mm256_add_pd(_mm256_mul_pd(x, ax[a]), _mm256_mul_pd(y, ay[a]));
+                lo[a] = _mm256_min_pd(lo[a], projection);
+                hi[a] = _mm256_max_pd(hi[a], projection);
+            }
+        }
+
+        for (std::size_t a = 0; a < block; ++a)
+        {
+            alignas(32) double lows[4], highs[4];
+            _mm256_store_pd(lows, lo[a]);
+            _mm256_store_pd(highs, hi[a]);
+            double minimum = std::min(std::min(lows[0], lows[1]), std::min(lows[2], lows[3]));
+            double maximum = std::max(std::max(highs[0], highs[1]), std::max(highs[2], highs[3]));
+
+            for (std::size_t i = vectorCount; i < count; ++i)
+            {
+                const double projection = xs[i] * axesX[first + a] + ys[i] * axesY[first + a];
+                minimum = std::min(minimum, projection);
+                maximum = std::max(maximum, projection);
+            }
+            mins[first + a] = minimum;
+            maxs[first + a] = maximum;
+        }
+    }
+}
+
+__attribute__((target("sse2")))
+void projectSse2(const double* xs, const double* ys, std::size_t count,
+                 const double* axesX, const double* axesY, std::size_t axisCount,
+                 double* mins, double* maxs)
+{
+    const std::size_t vectorCount = count & ~std::size_t(1);
+
+    for (std::size_t first = 0; first < axisCount; first += AXIS_BLOCK)
+    {
+        const std::size_t block = std::min(AXIS_BLOCK, axisCount - first);
+
+        __m128d ax[AXIS_BLOCK], ay[AXIS_BLOCK], lo[AXIS_BLOCK], hi[AXIS_BLOCK];
+        for (std::size_t a = 0; a < block; ++a)
+        {
+            ax[a] = _mm_set1_pd(axesX[first + a]);
+            ay[a] = _mm_set1_pd(axesY[first + a]);
+            lo[a] = _mm_set1_pd(std::numeric_limits<double>::infinity());
+            hi[a] = _mm_set1_pd(-std::numeric_limits<double>::infinity());
+        }
+
+        for (std::size_t i = 0; i < vectorCount; i += 2)
+        {
+            const __m128d x = _mm_loadu_pd(xs + i);
+            const __m128d y = _mm_loadu_pd(ys + i);
+            for (std::size_t a = 0; a < block; ++a)
+            {
+                const __m128d projection = _mm_add_pd(_mm_mul_pd(x, ax[a]), _mm_mul_pd(y, ay[a]));
+                lo[a] = _mm_min_pd(lo[a], projection);
+                hi[a] = _mm_max_pd(hi[a], projection);
+            }
+        }
+
+        for (std::size_t a = 0; a < block; ++a)
+        {
+            alignas(16) double lows[2], highs[2];
+            _mm_store_pd(lows, lo[a]);
+            _mm_store_pd(highs, hi[a]);
+            double minimum = std::min(lows[0], lows[1]);
+            double maximum = std::max(highs[0], highs[1]);
+
+            if (vectorCount < count)
+            {
+                const double projection = xs[count - 1] * axesX[first + a] + ys[count - 1] * axesY[first + a];
+                minimum = std::min(minimum, projection);
+                maximum = std::max(maximum, projection);
+            }
+            mins[first + a] = minimum;
+            maxs[first + a] = maximum;
+        }
+    }
+}
+
+#endif // SATKERNEL_X86
+}
+
+void SatKernel::project(const double* xs, const double* ys, std::size_t count,
+                        const double* axesX, const double* axesY, std::size_t axisCount,
+                        double* mins, double* maxs)
+{
+    static const ProjectFunction function = select();
+    function(xs, ys, count, axesX, axesY, axisCount, mins, maxs);
+}
+
+const char* SatKernel::implementation()
+{
+    const ProjectFunction function = select();
+#ifdef SATKERNEL_X86
+    if (function == &projectAvx2)
+        return "avx2";
+    if (function == &projectSse2)
+        return "sse2";
+#endif
+    return function == &projectScalar ? "scalar" : "unknown";
+}
+
+void SatKernel::projectScalar(const double* xs, const double* ys, std::size_t count,
+                              const double* axesX, const double* axesY, std::size_t axisCount,
+                              double* mins, double* maxs)
+{
+    for (std::size_t a = 0; a < axisCount; ++a)
+    {
+        double minimum = std::numeric_limits<double>::infinity();
+        double maximum = -std::numeric_limits<double>::infinity();
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            const double projection = xs[i] * axesX[a] + ys[i] * axesY[a];
+            minimum = std::min(minimum, projection);
+            maximum = std::max(maximum, projection);
+        }
+        mins[a] = minimum;
+        maxs[a] = maximum;
+    }
+}
+
+SatKernel::ProjectFunction SatKernel::select()
+{
+#ifdef SATKERNEL_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+    {
+        return &projectAvx2;
+    }
+    if (__builtin_cpu_supports("sse2"))
+    {
+        return &projectSse2;
+    }
+#endif
+    return &projectScalar;
+}
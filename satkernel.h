@@ -0,0 +1,86 @@
+/**
+ * @file SatKernel.h
+ *
+ * @brief Defines the SatKernel class, the vectorized projection kernel used by the separating axis test.
+ */
+
+#ifndef SATKERNEL_H
+#define SATKERNEL_H
+
+#include <cstddef>
+#include <new>
+#include <vector>
+
+/**
+ * @brief Allocator returning storage aligned for the widest vector registers used by SatKernel.
+ */
+template <typename T, std::size_t Alignment>
+struct AlignedAllocator
+{
+    using value_type = T;
+
+    template <typename U>
+    struct rebind
+    {
+        using other = AlignedAllocator<U, Alignment>;
+    };
+
+    AlignedAllocator() = default;
+    template <typename U>
+    AlignedAllocator(const AlignedAllocator<U, Alignment>&) {}
+
+    T* allocate(std::size_t count)
+    {
+        return static_cast<T*>(::operator new(count * sizeof(T), std::align_val_t(Alignment)));
+    }
+
+    void deallocate(T* pointer, std::size_t)
+    {
+        ::operator delete(pointer, std::align_val_t(Alignment));
+    }
+
+    template <typename U>
+    bool operator ==(const AlignedAllocator<U, Alignment>&) const { return true; }
+};
+
+using AlignedDoubles = std::vector<double, AlignedAllocator<double, 32>>;
+
+/**
+ * @class SatKernel
+ * @brief Projects a set of 2D vertices onto several axes and returns the extent on each axis.
+ *
+ * The vertices are passed as separate x and y arrays. On x86 the AVX2 or SSE2 implementation
+ * is picked once at runtime from the CPU features, and other targets use the scalar loop. All
+ * implementations use the same multiply and add sequence, so they return identical results.
+ */
+class SatKernel
+{
+public:
+    /**
+    * @brief Computes the minimum and maximum projection of the vertices on every axis.
+    *
+    * @param xs, ys Coordinates of the vertices.
+    * @param count Number of vertices; must be greater than zero.
+    * @param axesX, axesY Components of the axes.
+    * @param axisCount Number of axes.
+    * @param mins, maxs Receive the projection interval of each axis.
+    */
+    static void project(const double* xs, const double* ys, std::size_t count,
+                        const double* axesX, const double* axesY, std::size_t axisCount,
+                        double* mins, double* maxs);
+
+    // Name of the implementation selected for this CPU ("avx2", "sse2" or "scalar")
+    static const char* implementation();
+
+private:
+    using ProjectFunction = void (*)(const double*, const double*, std::size_t,
+                                     const double*, const double*, std::size_t,
+                                     double*, double*);
+
+    static void projectScalar(const double* xs, const double* ys, std::size_t count,
+                              const double* axesX, const double* axesY, std::size_t axisCount,
+                              double* mins, double* maxs);
+    static ProjectFunction select();
+};
+
+#endif // SATKERNEL_H
@@ -1,42 +1,178 @@
 #include "scene.h"
 #include "linearmath.h"
+#include "scratcharena.h"
+#include <algorithm>
+#include <iostream>
 
+namespace
+{
+// Stream buffer that drops whatever is written to it
+class DiscardBuffer : public std::streambuf
+{
+protected:
+    int overflow(int character) override { return traits_type::not_eof(character); }
+    std::streamsize xsputn(const char*, std::streamsize count) override { return count; }
+};
 
-Scene::Scene(const Point & origin, double width, double height) :
-    _origin{origin}, _width{width}, _height{height}
+// Narrowphase of each pair of shape kinds, picked at compile time by Scene::visit()
+bool overlaps(const Polygon& polygon, const Polygon& other)
 {
+    return polygon.intersects(other, Point(0, 0, 0));
+}
 
+bool overlaps(const Polygon& polygon, const CircularShape& circularShape)
+{
+    return polygon.intersects(circularShape);
 }
-std::shared_ptr<Scene> Scene::getInstance()
+
+bool overlaps(const CircularShape& circularShape, const Polygon& polygon)
 {
-    if (!instance_)
+    return polygon.intersects(circularShape);
+}
+
+bool overlaps(const CircularShape& circularShape, const CircularShape& other)
+{
+    return circularShape.intersects(other);
+}
+
+// Adds the points where the path crosses the outline of the shape
+void addCrossings(const LinearMath::LineSegment& path, const Polygon& polygon, std::pmr::vector<Point>& intersectionPoints)
+{
+    const auto vertices = polygon.transformedVertices();
+    size_t size = vertices.size();
+
+    for(size_t i = 0; i < size; i++)
     {
-        instance_ = std::shared_ptr<Scene>(new Scene(Point(500, 400), 1000, 800));
+        const Point2& p = vertices[i];
+        const Point2& q = vertices[(i+1) % size];
+
+        const auto& intersectionPoint = Scene::areLinesIntersecting(path,  LinearMath::LineSegment(p, q));
+        if(intersectionPoint.second)
+        {
+            intersectionPoints.push_back(intersectionPoint.first);
+        }
     }
-    return instance_;
 }
-void Scene::mapComponentToScene(const std::shared_ptr<Shape>& component)
+
+void addCrossings(const LinearMath::LineSegment& path, const CircularShape& circularShape, std::pmr::vector<Point>& intersectionPoints)
 {
-    if (const auto& polygon = std::dynamic_pointer_cast<Polygon>(component))
+    // An ellipse is scaled vertically into a circle, which keeps the crossings on the path
+    const Point& center = circularShape.center();
+    const double radius = circularShape.getRadius();
+    const double scaleY = circularShape.getMinorRadius() ? radius / circularShape.getMinorRadius() : 1.0;
+    const double fx = path.startPoint.getX() - center.getX();
+    const double fy = (path.startPoint.getY() - center.getY()) * scaleY;
+    const double dx = path.endPoint.getX() - path.startPoint.getX();
+    const double dy = (path.endPoint.getY() - path.startPoint.getY()) * scaleY;
+
+    // |f + t * d| = radius, for t in [0, 1] along the path
+    const double qa = dx * dx + dy * dy;
+    const double qb = 2.0 * (fx * dx + fy * dy);
+    const double qc = fx * fx + fy * fy - radius * radius;
+    const double discriminant = qb * qb - 4.0 * qa * qc;
+    if (qa == 0.0 || discriminant < 0.0)
     {
-        std::vector<Point> res;
-        res.reserve(polygon->getVertices().size());
+        return;
+    }
 
-        for (const auto& point : polygon->getVertices())
+    const double root = std::sqrt(discriminant);
+    for (double t : {(-qb - root) / (2.0 * qa), (-qb + root) / (2.0 * qa)})
+    {
+        if (t >= 0.0 && t <= 1.0)
         {
-            Point mappedPoint = point;
-            mapPointToScene(mappedPoint);
-            res.push_back(std::move(mappedPoint));
+            intersectionPoints.emplace_back(path.startPoint.getX() + t * (path.endPoint.getX() - path.startPoint.getX()),
+                                            path.startPoint.getY() + t * (path.endPoint.getY() - path.startPoint.getY()));
         }
+    }
+}
+}
+
+
+Scene::Scene(const Point & origin, double width, double height) :
+    _origin{origin}, _width{width}, _height{height}, _broadphase{std::make_unique<AABBTree>(TREE_MARGIN)}
+{
+    // Recording a change never allocates; the pages of the log are only touched as it fills
+    _changedRegions.reserve(CHANGE_LOG_LIMIT);
+}
+std::shared_ptr<Scene> Scene::create(const Point& origin, double width, double height)
+{
+    return std::shared_ptr<Scene>(new Scene(origin, width, height));
+}
+ShapeHandle Scene::addPolygon(std::vector<Point> vertices)
+{
+    for (auto& point : vertices)
+    {
+        mapPointToScene(point);
+    }
 
-        polygon->setInitialVertices(std::move(res));
+    const ShapeHandle handle = _polygons.emplace(std::move(vertices));
+    addComponent(*_polygons.get(handle), handle);
+    return handle;
+}
+
+ShapeHandle Scene::addCircularShape(Point center, double radius, double minorRadius)
+{
+    mapPointToScene(center);
+    const ShapeHandle handle = _circularShapes.emplace(center, radius, minorRadius);
+    addComponent(*_circularShapes.get(handle), handle);
+    return handle;
+}
+
+void Scene::removeComponent(ShapeHandle handle)
+{
+    Shape* shape = handle.kind == ShapeKind::Polygon ? static_cast<Shape*>(_polygons.get(handle))
+                                                     : static_cast<Shape*>(_circularShapes.get(handle));
+    if (!shape)
+    {
+        return;
+    }
+
+    // The id is left empty for good; the new pose version makes the caches drop what they derived from it
+    const std::size_t id = shape->componentId();
+    _broadphase->remove(id);
+    _sweepAndPrune.remove(id);
+    _configurationSpaces.erase(id);
+    ++_poseVersions[id];
+    ++_shapeVersions[id];
+    recordChange(_boxes[id]);
+    _components[id] = Component{};
+
+    if (handle.kind == ShapeKind::Polygon)
+    {
+        _polygons.erase(handle);
     }
-    else if (const auto& circularShape = std::dynamic_pointer_cast<CircularShape>(component))
+    else
     {
-        Point center = circularShape->center();
-        mapPointToScene(center);
+        _circularShapes.erase(handle);
     }
-    _components.emplace_back(component, false);
+}
+
+Polygon* Scene::polygon(ShapeHandle handle)
+{
+    return _polygons.get(handle);
+}
+
+const Polygon* Scene::polygon(ShapeHandle handle) const
+{
+    return _polygons.get(handle);
+}
+
+const CircularShape* Scene::circularShape(ShapeHandle handle) const
+{
+    return _circularShapes.get(handle);
+}
+
+const Polygon* Scene::polygon(Broadphase::Id id) const
+{
+    const Component& component = _components[id];
+    return component.shape && component.handle.kind == ShapeKind::Polygon ? static_cast<const Polygon*>(component.shape) : nullptr;
+}
+
+const CircularShape* Scene::circularShape(Broadphase::Id id) const
+{
+    const Component& component = _components[id];
+    return component.shape && component.handle.kind == ShapeKind::CircularShape
+               ? static_cast<const CircularShape*>(component.shape) : nullptr;
 }
 
 
@@ -47,44 +183,35 @@ void Scene::mapPointToScene( Point& point)
     point.setZ( _origin.getZ() + point.getZ());
 }
 
-std::vector<Point> Scene::hasObstruction(const Point& start, const Point& end, std::shared_ptr<Shape> playingPieces)
+void Scene::hasObstruction(const Point& start, const Point& end, const Shape* playingPiece,
+                           std::pmr::vector<Point>& intersectionPoints) const
 {
-    std::vector<Point> intersectionPoints;
-    const auto& comps = components();
+    intersectionPoints.clear();
 
-    for(const auto& component : comps)
-    {
-        std::shared_ptr<Polygon> polygon = std::dynamic_pointer_cast<Polygon>(component.first);
+    // Taken from the caller's scope of the arena, which also holds the result
+    Broadphase::IdList ids(&ScratchArena::local());
+    _broadphase->querySegment(start, end, ids);
+    std::sort(ids.begin(), ids.end());
 
-        if(polygon != playingPieces)
+    const LinearMath::LineSegment path{Point2(start), Point2(end)};
+    for(Broadphase::Id id : ids)
+    {
+        if(_components[id].shape != playingPiece)
         {
-            size_t size = polygon->transformedVertices().size();
-
-            for(size_t i = 0; i < size; i++)
-            {
-                Point p = (polygon->transformedVertices().at(i));
-                Point q = (polygon->transformedVertices().at((i+1) % size));
-
-                const auto& intersectionPoint = areLinesIntersecting(LinearMath::LineSegment(start, end),  LinearMath::LineSegment(p, q));
-                if(intersectionPoint.second)
-                {
-                    intersectionPoints.push_back(intersectionPoint.first);
-                }
-            }
+            visit(id, [&path, &intersectionPoints](const auto& shape) { addCrossings(path, shape, intersectionPoints); });
         }
     }
-    return intersectionPoints;
 }
 
-std::pair<Point, bool> Scene::areLinesIntersecting(const LinearMath::LineSegment& line1, const LinearMath::LineSegment& line2)
+std::pair<Point2, bool> Scene::areLinesIntersecting(const LinearMath::LineSegment& line1, const LinearMath::LineSegment& line2)
 {
     // Get the endpoints of the first line segment
-    const Point& p1 = line1.startPoint;
-    const Point& p2 = line1.endPoint;
+    const Point2& p1 = line1.startPoint;
+    const Point2& p2 = line1.endPoint;
 
     // Get the dpoints of the second line segment
-    const Point& p3 = line2.startPoint;
-    const Point& p4 = line2.endPoint;
+    const Point2& p3 = line2.startPoint;
+    const Point2& p4 = line2.endPoint;
 
     // Calculate the denominator for the intersection point formula
     double denominator = (p4.getY() - p3.getY()) * (p2.getX() - p1.getX()) - (p4.getX() - p3.getX()) * (p2.getY() - p1.getY());
@@ -92,7 +219,7 @@ std::pair<Point, bool> Scene::areLinesIntersecting(const LinearMath::LineSegment
     // Check if the lines are parallel or coincident (denominator is close to zero)
     if (std::abs(denominator) < std::numeric_limits<double>::epsilon())
     {
-        return std::make_pair(Point(), false);
+        return std::make_pair(Point2(), false);
     }
 
     // Calculate the intersection parameters
@@ -103,115 +230,402 @@ std::pair<Point, bool> Scene::areLinesIntersecting(const LinearMath::LineSegment
 
     if (ua >= -tolerance && ua <= 1 + tolerance && ub >= -tolerance && ub <= 1 + tolerance)
     {
-        Point intersectionPoint;
+        Point2 intersectionPoint;
         intersectionPoint.setX( p1.getX() + ua * (p2.getX() - p1.getX()));
         intersectionPoint.setY(p1.getY() + ua * (p2.getY() - p1.getY()));
-        intersectionPoint.setZ( p1.getZ() + ua * (p2.getZ() - p1.getZ()));
         return std::make_pair(intersectionPoint, true);
     }
-    return std::make_pair(Point(), false);
+    return std::make_pair(Point2(), false);
 }
 
-std::vector<std::pair<Point, std::vector<Point>>> Scene::scanPossibleCollision(std::shared_ptr<Polygon> polygon, const Point& endPosition, bool center)
+void Scene::scanPossibleCollision(const Polygon& polygon, const Point& endPosition,
+                                  std::pmr::vector<std::pair<Broadphase::Id, Point>>& collisions)
 {
-    std::vector<std::pair<Point, std::vector<Point>>> _pointsOfPossibleCollisions;
+    collisions.clear();
+    std::pmr::vector<double> fractions(&ScratchArena::local());
+    Broadphase::IdList ids(&ScratchArena::local());
+
+    const Point start = polygon.getCenter();
+    const Point2 from(start);
+    const Point2 to(endPosition);
+    ConfigurationSpace& space = pieceSpace(polygon);
+    // The swept bounding box of the piece holds every component its path can reach, so only
+    // their obstacles are brought up to date
+    overlappingShapes(sweptBox(polygon, endPosition), ids, &polygon);
+    for (Broadphase::Id id : ids)
+    {
+        refreshObstacle(space, polygon.componentId(), id);
+        const auto clip = LinearMath::clipSegment(space.obstacles[id], from, to);
+        if (clip)
+        {
+            const double t = clip->first;
+            const Point contact(start.getX() + t * (endPosition.getX() - start.getX()),
+                                start.getY() + t * (endPosition.getY() - start.getY()));
+            const auto position = std::upper_bound(fractions.begin(), fractions.end(), t) - fractions.begin();
+            fractions.insert(fractions.begin() + position, t);
+            collisions.insert(collisions.begin() + position, {id, contact});
+        }
+    }
+}
 
-    const auto startPosition = polygon->calculatePolygonCenter();
-    double A = 0, B = 0, slope = 0;
+const Scene::ConfigurationSpace& Scene::configurationSpace(const Polygon& piece)
+{
+    ConfigurationSpace& space = pieceSpace(piece);
+    for (std::size_t id = 0; id < _components.size(); ++id)
+    {
+        refreshObstacle(space, piece.componentId(), id);
+    }
+    return space;
+}
 
-    A = startPosition.getY() - endPosition.getY();
-    B = startPosition.getX() - endPosition.getX();
-    slope = A/B;
+Scene::ConfigurationSpace& Scene::pieceSpace(const Polygon& piece)
+{
+    const std::size_t pieceId = piece.componentId();
+    ConfigurationSpace& space = _configurationSpaces[pieceId];
 
-    size_t  size =  polygon->transformedVertices().size();
-    for(size_t i = 0; i < size; ++i)
+    if (space.reflectedPiece.empty() || space.shapeVersion != _shapeVersions[pieceId])
     {
-        std::vector<Point> intersections;
+        // The piece reflected through its center, grown by the clearance square
+        const Point2 center(piece.getCenter());
+        std::vector<Point2> reflected;
+        for (const Point2& vertex : piece.transformedVertices())
+        {
+            reflected.emplace_back(center.getX() - vertex.getX(), center.getY() - vertex.getY());
+        }
+        const std::vector<Point2> clearance{Point2(-CLEARANCE, -CLEARANCE), Point2(CLEARANCE, -CLEARANCE),
+                                            Point2(CLEARANCE, CLEARANCE), Point2(-CLEARANCE, CLEARANCE)};
+        space.reflectedPiece = LinearMath::minkowskiSum(LinearMath::convexHull(reflected), clearance);
+        space.shapeVersion = _shapeVersions[pieceId];
+        space.obstacleVersions.assign(_components.size(), 0);
+    }
+
+    space.obstacles.resize(_components.size());
+    space.obstacleVersions.resize(_components.size(), 0);
+    return space;
+}
+
+void Scene::refreshObstacle(ConfigurationSpace& space, std::size_t pieceId, std::size_t id)
+{
+    if (id == pieceId || space.obstacleVersions[id] == _poseVersions[id])
+    {
+        return;
+    }
 
-        if(!center)
+    std::vector<Point2> outline;
+    if (const auto* polygon = this->polygon(id))
+    {
+        outline = LinearMath::convexHull(polygon->transformedVertices());
+    }
+    else if (const auto* circularShape = this->circularShape(id))
+    {
+        // Circumscribed polygon, so the obstacle covers the whole circle
+        const double radius = circularShape->getRadius() / std::cos(M_PI / CIRCLE_SIDES);
+        for (int i = 0; i < CIRCLE_SIDES; ++i)
         {
-            auto v = polygon->transformedVertices().at(i);
-            auto eq = LinearMath::LineSegment::generateLineEquation(slope, v.getX(), v.getY());
-            auto val = LinearMath::LineSegment::evaluateLineEquation(eq, endPosition.getX());
-            const Point p(endPosition.getX(), val);
+            const double angle = 2.0 * M_PI * i / CIRCLE_SIDES;
+            outline.emplace_back(circularShape->center().getX() + radius * std::cos(angle),
+                                 circularShape->center().getY() + radius * std::sin(angle));
+        }
+    }
+
+    space.obstacles[id] = outline.empty() ? outline : LinearMath::minkowskiSum(outline, space.reflectedPiece);
+    space.obstacleVersions[id] = _poseVersions[id];
+    ++space.revision;
+}
+
+bool Scene::isFreePlacement(const Polygon& piece, const Point& position)
+{
+    ConfigurationSpace& space = pieceSpace(piece);
+    ScratchArena::Scope scope;
+    Broadphase::IdList ids(&scope.arena());
+    // The piece's box at the position, grown by the clearance the obstacles keep
+    const auto [min, max] = piece.calculateBoundingBox();
+    const Point offset = position - piece.getCenter();
+    overlappingShapes({Point2(min.getX() + offset.getX() - CLEARANCE, min.getY() + offset.getY() - CLEARANCE),
+                       Point2(max.getX() + offset.getX() + CLEARANCE, max.getY() + offset.getY() + CLEARANCE)},
+                      ids, &piece);
+
+    const Point2 center(position);
+    return std::none_of(ids.begin(), ids.end(), [this, &space, &piece, &center](Broadphase::Id id)
+                        {
+                            refreshObstacle(space, piece.componentId(), id);
+                            return LinearMath::containsPoint(space.obstacles[id], center);
+                        });
+}
+
+void Scene::neigbhorsShapes(const Polygon& playerPiece, const Point& endPosition, Broadphase::IdList& result) const
+{
+    overlappingShapes(sweptBox(playerPiece, endPosition), result, &playerPiece);
+}
+
+Broadphase::Box Scene::sweptBox(const Polygon& polygon, const Point& endPosition)
+{
+    auto [min, max] = polygon.calculateBoundingBox();
+    const Point offset = endPosition - polygon.getCenter();
 
-            intersections = hasObstruction(v, p, polygon);
-            if(intersections.size())
+    return {Point2(std::min(min.getX(), min.getX() + offset.getX()), std::min(min.getY(), min.getY() + offset.getY())),
+            Point2(std::max(max.getX(), max.getX() + offset.getX()), std::max(max.getY(), max.getY() + offset.getY()))};
+}
+
+void Scene::overlappingShapes(const Broadphase::Box& region, Broadphase::IdList& ids, const Shape* exclude) const
+{
+    _broadphase->query(region, ids);
+    if (Island* island = this->island())
+    {
+        // The broadphase still holds the boxes from before the batch
+        ids.insert(ids.end(), island->neighbors.begin(), island->neighbors.end());
+        std::erase_if(ids, [this, exclude, &region, island](Broadphase::Id id)
+                      {
+                          const auto moved = island->boxes.find(id);
+                          const auto& box = moved != island->boxes.end() ? moved->second : _boxes[id];
+                          return _components[id].shape == exclude || !Broadphase::overlaps(box, region);
+                      });
+        std::sort(ids.begin(), ids.end());
+        ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+        return;
+    }
+    std::erase_if(ids, [this, exclude](Broadphase::Id id) { return _components[id].shape == exclude; });
+    std::sort(ids.begin(), ids.end());
+}
+
+void Scene::addComponent(Shape& shape, ShapeHandle handle)
+{
+    const auto box = Broadphase::boxOf(shape.calculateBoundingBox());
+    shape.setComponentId(_components.size());
+    shape.setScene(this);
+    _broadphase->insert(_components.size(), box);
+    _sweepAndPrune.insert(_components.size(), box);
+    _components.push_back({&shape, handle, false});
+    _poseVersions.push_back(1);
+    _shapeVersions.push_back(1);
+    _boxes.push_back(box);
+    recordChange(box);
+}
+
+void Scene::updateComponent(const Shape& component, ComponentChange change)
+{
+    const std::size_t id = component.componentId();
+    const auto box = Broadphase::boxOf(component.calculateBoundingBox());
+    if (Island* island = this->island())
+    {
+        island->boxes[id] = box;
+        island->updates.push_back({island->operation, id, box, change});
+        return;
+    }
+    applyUpdate(id, box, change);
+}
+
+void Scene::enterIsland(Island* island)
+{
+    island_ = island;
+}
+
+void Scene::applyUpdates(std::vector<Update> updates)
+{
+    std::stable_sort(updates.begin(), updates.end(), [](const Update& a, const Update& b)
+                     {
+                         return a.operation < b.operation;
+                     });
+    for (const Update& update : updates)
+    {
+        applyUpdate(update.id, update.box, update.change);
+    }
+}
+
+std::ostream& Scene::output()
+{
+    if (quiet_)
+    {
+        thread_local DiscardBuffer buffer;
+        thread_local std::ostream discard(&buffer);
+        return discard;
+    }
+    return island_ && island_->output ? *island_->output : std::cout;
+}
+
+Scene::QuietScope::QuietScope() : _previous{quiet_}
+{
+    quiet_ = true;
+}
+
+Scene::QuietScope::~QuietScope()
+{
+    quiet_ = _previous;
+}
+
+std::shared_ptr<Scene::SnapshotReader> Scene::addSnapshotReader()
+{
+    auto reader = std::make_shared<SnapshotReader>();
+    _snapshotReaders.push_back(reader);
+    return reader;
+}
+
+void Scene::publishSnapshot()
+{
+    // Readers only the scene still holds are not read anymore
+    std::erase_if(_snapshotReaders, [](const std::shared_ptr<SnapshotReader>& reader) { return reader.use_count() == 1; });
+    ++_snapshotStep;
+
+    for (const auto& reader : _snapshotReaders)
+    {
+        Snapshot& snapshot = reader->back();
+        snapshot.step = _snapshotStep;
+        snapshot.components.resize(_components.size());
+        for (std::size_t id = 0; id < _components.size(); ++id)
+        {
+            ComponentPose& pose = snapshot.components[id];
+            if (pose.version == _poseVersions[id])
             {
-                _pointsOfPossibleCollisions.push_back(std::make_pair(v, intersections));
+                continue;
             }
-        }
-        else
-        {
-            intersections = Scene::getInstance()->hasObstruction(startPosition, endPosition, polygon);
-            if(intersections.size())
+            pose.version = _poseVersions[id];
+            pose.box = _boxes[id];
+            if (const auto* polygon = this->polygon(id))
             {
-                _pointsOfPossibleCollisions.push_back(std::make_pair(startPosition, intersections));
+                pose.center = polygon->getCenter();
+                pose.vertices.clear();
+                for (const Point2& vertex : polygon->transformedVertices())
+                {
+                    pose.vertices.emplace_back(vertex);
+                }
+            }
+            else
+            {
+                // A circular shape, or a removed component keeping its last pose
+                if (const auto* circularShape = this->circularShape(id))
+                {
+                    pose.center = circularShape->center();
+                }
+                pose.vertices.clear();
             }
         }
+        reader->publish();
     }
-    return _pointsOfPossibleCollisions;
 }
 
-std::vector<std::pair<std::shared_ptr<Shape>, bool>> Scene::neigbhorsShapes(const std::shared_ptr<Shape>playerPiece, const Point& endPosition)
+Scene::Island* Scene::island() const
 {
-    std::vector<std::pair<std::shared_ptr<Shape>, bool>> neigbhors;
-    std::shared_ptr<Polygon> polygon = std::dynamic_pointer_cast<Polygon>(playerPiece);
+    return island_ && island_->scene == this ? island_ : nullptr;
+}
+
+void Scene::applyUpdate(Broadphase::Id id, const Broadphase::Box& box, ComponentChange change)
+{
+    _broadphase->update(id, box);
+    _sweepAndPrune.update(id, box);
 
-    double disatnce = endPosition.calculateDistance(polygon->calculatePolygonCenter());
-    for(const  auto& comp : components())
+    ++_poseVersions[id];
+    if (change == ComponentChange::Rotated)
     {
-        std::shared_ptr<Polygon> other = std::dynamic_pointer_cast<Polygon>(comp.first);
-        if(polygon != other)
+        ++_shapeVersions[id];
+    }
+
+    const auto& [oldMin, oldMax] = _boxes[id];
+    recordChange({Point2(std::min(oldMin.getX(), box.first.getX()), std::min(oldMin.getY(), box.first.getY())),
+                  Point2(std::max(oldMax.getX(), box.second.getX()), std::max(oldMax.getY(), box.second.getY()))});
+    _boxes[id] = box;
+}
+
+void Scene::recordChange(const Broadphase::Box& region)
+{
+    if (_changedRegions.size() == CHANGE_LOG_LIMIT)
+    {
+        // The older half becomes its last entry, the union of them all: a reader that missed
+        // any of them refreshes that union, which covers every change it missed
+        const std::size_t merged = CHANGE_LOG_LIMIT / 2;
+        auto& [min, max] = _changedRegions[merged - 1];
+        for (std::size_t i = 0; i + 1 < merged; ++i)
         {
-            double otherDisatnce = abs((other->calculatePolygonCenter() - polygon->calculatePolygonCenter()).getVectorNorm());
+            const auto& [oldMin, oldMax] = _changedRegions[i];
+            min = Point2(std::min(min.getX(), oldMin.getX()), std::min(min.getY(), oldMin.getY()));
+            max = Point2(std::max(max.getX(), oldMax.getX()), std::max(max.getY(), oldMax.getY()));
+        }
+        _changedRegions.erase(_changedRegions.begin(), _changedRegions.begin() + (merged - 1));
+        _changeBase += merged - 1;
+    }
+    _changedRegions.push_back(region);
+}
 
-            if(otherDisatnce < disatnce + MARIGIN)
-            {
-                neigbhors.push_back(comp);
-            }
+std::span<const Broadphase::Box> Scene::changedRegions(std::size_t since) const
+{
+    const std::size_t first = std::clamp(since, _changeBase, changeCount()) - _changeBase;
+    return std::span<const Broadphase::Box>(_changedRegions).subspan(first);
+}
+
+std::size_t Scene::changeCount() const
+{
+    return _changeBase + _changedRegions.size();
+}
+
+void Scene::collidingPairs(std::pmr::vector<std::pair<Broadphase::Id, Broadphase::Id>>& colliding)
+{
+    colliding.clear();
+
+    std::pmr::vector<std::pair<SweepAndPrune::Id, SweepAndPrune::Id>> candidates(&ScratchArena::local());
+    _sweepAndPrune.overlappingPairs(candidates);
+
+    for (const auto& [first, second] : candidates)
+    {
+        if (visit(first, second, [](const auto& shape, const auto& other) { return overlaps(shape, other); }))
+        {
+            colliding.emplace_back(first, second);
         }
     }
-    return neigbhors;
 }
 
-void Scene::addComponent(std::pair<std::shared_ptr<Shape>, bool> component)
+void Scene::setBroadphase(BroadphaseType type)
 {
-    _components.push_back(component);
+    if (type == BroadphaseType::UniformGrid)
+    {
+        _broadphase = std::make_unique<SpatialGrid>(GRID_CELL_SIZE);
+    }
+    else
+    {
+        _broadphase = std::make_unique<AABBTree>(TREE_MARGIN);
+    }
+
+    for (const auto& component : _components)
+    {
+        if (component.shape)
+        {
+            _broadphase->insert(component.shape->componentId(), Broadphase::boxOf(component.shape->calculateBoundingBox()));
+        }
+    }
 }
 
-std::vector<std::pair<std::shared_ptr<Shape>, bool>> Scene::components() const
+std::span<const Scene::Component> Scene::components() const
 {
     return _components;
 }
 
-int Scene::numOfComponents()
+const Scene::Component& Scene::component(std::size_t id) const
 {
-    return _components.size();
+    return _components[id];
 }
 
-double Scene::endPosition() const
+void Scene::setPlayerPiece(std::size_t id, bool selected)
 {
-    return _endPosition;
+    _components[id].selected = selected;
 }
 
-void Scene::setEndPosition(double newEndPosition)
+int Scene::numOfComponents()
 {
-    _endPosition = newEndPosition;
+    return _components.size();
 }
 
-std::shared_ptr<Shape> Scene::playerPieces() const
+std::pair<Point, Point> Scene::bounds() const
 {
-    if (_playerPieces)
-        return *_playerPieces;
-
-    return nullptr;
+    return {Point(_origin.getX() - _width / 2, _origin.getY() - _height / 2),
+            Point(_origin.getX() + _width / 2, _origin.getY() + _height / 2)};
 }
 
+double Scene::endPosition() const
+{
+    return _endPosition;
+}
 
-void Scene::setPlayerPieces(std::unique_ptr<std::shared_ptr<Shape> > newPlayerPieces)
+void Scene::setEndPosition(double newEndPosition)
 {
-    _playerPieces = std::move(newPlayerPieces);
+    _endPosition = newEndPosition;
 }
 
 
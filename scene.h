@@ -2,43 +2,345 @@
 #define SCENE_H
 
 class Polygon;
+class CircularShape;
 
+#include <cstdint>
+#include <memory_resource>
+#include <ostream>
+#include <span>
+#include <unordered_map>
 #include <vector>
 #include "circularshape.h"
 #include "linearmath.h"
+#include "shapepool.h"
+#include "spatialgrid.h"
+#include "aabbtree.h"
+#include "sweepandprune.h"
+#include "triplebuffer.h"
 /**
  * @brief The Scene class
+ *
+ * One world: its components, their broadphase and the caches derived from them. Scenes share
+ * no state, so several matches can run in one process, each on its own thread. Every shape
+ * of a Scene keeps a pointer to it, through which it finds its neighbors when it moves.
+ * The Scene owns its shapes: they live in one ShapePool per kind and are named by ShapeHandles,
+ * and the components refer to them by plain pointers tagged with their kind, so looking up a
+ * polygon needs neither reference counting nor a dynamic_cast.
+ * Like those of the Broadphase, the queries clear and fill containers given by the caller, so
+ * a caller that keeps them, or takes them from a ScratchArena, runs them without the heap.
  */
 class Scene
 {
 public:
+    // A shape of the scene and whether it was selected as a playing piece
+    struct Component
+    {
+        // nullptr once the shape was removed; the id of a component is never reused
+        Shape* shape = nullptr;
+        ShapeHandle handle;
+        bool selected = false;
+    };
+
+    enum class BroadphaseType
+    {
+        UniformGrid,
+        AABBTree
+    };
+
+    // What changed when a component is updated; only a rotation changes its shape relative to its center
+    enum class ComponentChange
+    {
+        Translated,
+        Rotated
+    };
+
+    /**
+     * @brief Configuration space obstacles of a playing piece.
+     *
+     * Each obstacle is the Minkowski difference of another component with the piece, taken
+     * relative to the piece's center and grown by a small clearance: the piece overlaps the
+     * component exactly when its center lies inside the obstacle. The obstacles are indexed by
+     * component id; the piece's own entry is empty.
+     */
+    struct ConfigurationSpace
+    {
+        // Incremented whenever one of the obstacles is recomputed
+        std::uint64_t revision = 0;
+        std::vector<std::vector<Point2>> obstacles;
+
+    private:
+        friend class Scene;
+        std::uint64_t shapeVersion = 0;
+        std::vector<Point2> reflectedPiece;
+        std::vector<std::uint64_t> obstacleVersions;
+    };
+
+    // Pose of a component when a snapshot was published
+    struct ComponentPose
+    {
+        // Pose version of the component; it changes whenever the component moves or rotates
+        std::uint64_t version = 0;
+        Point center;
+        Broadphase::Box box;
+        // Vertices of a polygon, in single precision since they are only displayed; empty for a
+        // circular shape
+        std::vector<Point2f> vertices;
+    };
+
+    // Poses of all the components at the end of a step, indexed by component id
+    struct Snapshot
+    {
+        // Number of the publication, from 1; 0 until the first one
+        std::uint64_t step = 0;
+        std::vector<ComponentPose> components;
+    };
+
+    // Snapshots handed to one reading thread
+    using SnapshotReader = TripleBuffer<Snapshot>;
+
+    // A component update recorded by an island, with the index of the operation that made it
+    struct Update
+    {
+        std::size_t operation;
+        Broadphase::Id id;
+        Broadphase::Box box;
+        ComponentChange change;
+    };
+
+    /**
+     * @brief What a group of operations running on its own thread sees of the scene.
+     *
+     * While threads work on islands, the broadphase is left as it was before the batch and
+     * only read. The scene answers the region queries of an island with the boxes of the
+     * components it already moved, and records its updates instead of applying them. Islands
+     * whose regions do not overlap never read what another one writes, so they can run at the
+     * same time.
+     */
+    struct Island
+    {
+        // Pieces of the operations whose regions overlap the running one's; they may have moved into it
+        std::span<const Broadphase::Id> neighbors;
+        // Boxes of the components the island updated
+        std::unordered_map<Broadphase::Id, Broadphase::Box> boxes;
+        std::vector<Update> updates;
+        // Scene the island belongs to
+        const Scene* scene = nullptr;
+        // Index of the running operation, and where its messages go
+        std::size_t operation = 0;
+        std::ostream* output = nullptr;
+    };
+
     Scene(const Scene& other) = delete;
     ~Scene() = default;
 
-    static std::shared_ptr<Scene> getInstance();
-    void mapComponentToScene(const std::shared_ptr<Shape>& component);
+    // Creates an empty scene of the given size, centered on the origin
+    static std::shared_ptr<Scene> create(const Point& origin = Point(500, 400), double width = 1000, double height = 800);
+    /**
+     * @brief Creates a polygon in the scene and returns its handle.
+     *
+     * The vertices are given relative to the scene's origin and mapped to its coordinates
+     * before the polygon is constructed in the polygon pool.
+     */
+    ShapeHandle addPolygon(std::vector<Point> vertices);
+    // Creates a circle, or an ellipse with a minor radius, centered relative to the scene's origin
+    ShapeHandle addCircularShape(Point center, double radius, double minorRadius = 0);
+    // Takes the shape out of the broadphase and destroys it; its handle and pointers become invalid
+    void removeComponent(ShapeHandle handle);
+    // The shape the handle names, or nullptr if it was removed or is of the other kind
+    Polygon* polygon(ShapeHandle handle);
+    const Polygon* polygon(ShapeHandle handle) const;
+    const CircularShape* circularShape(ShapeHandle handle) const;
+    // The component as a polygon or a circular shape, or nullptr
+    const Polygon* polygon(Broadphase::Id id) const;
+    const CircularShape* circularShape(Broadphase::Id id) const;
+    /**
+     * @brief Calls the function with the component as its concrete shape type.
+     *
+     * The kind tag of the component selects the call, and the function is instantiated for
+     * each kind, so overloaded kernels are picked at compile time and can be inlined: no
+     * virtual call or RTTI is involved. The component must not have been removed, which holds
+     * for every id the broadphase returns.
+     */
+    template<typename Function>
+    decltype(auto) visit(Broadphase::Id id, Function&& function) const
+    {
+        if (_components[id].handle.kind == ShapeKind::Polygon)
+        {
+            return function(*polygon(id));
+        }
+        return function(*circularShape(id));
+    }
+    // Calls the function with both components as their concrete shape types, one instantiation per pair of kinds
+    template<typename Function>
+    decltype(auto) visit(Broadphase::Id first, Broadphase::Id second, Function&& function) const
+    {
+        return visit(first, [this, second, &function](const auto& shape)
+                     {
+                         return visit(second, [&shape, &function](const auto& other) { return function(shape, other); });
+                     });
+    }
     void mapPointToScene(Point& point);
-    std::vector<Point> hasObstruction(const Point& start, const Point& end, std::shared_ptr<Shape> playingPieces);
-    std::pair<Point, bool> areLinesIntersecting(const LinearMath::LineSegment &line1, const LinearMath::LineSegment &line2);
-    std::vector<std::pair<Point, std::vector<Point>>> scanPossibleCollision(std::shared_ptr<Polygon> polygon, const Point& endPosition, bool center=false);
-    std::vector<std::pair<std::shared_ptr<Shape>, bool>> neigbhorsShapes(const std::shared_ptr<Shape>playerPiece, const Point& endPosition);
-    void addComponent(std::pair<std::shared_ptr<Shape>, bool> component);
-    std::vector<std::pair<std::shared_ptr<Shape>, bool>> components() const;
+    // Fills the result with the points where the segment crosses an edge of another polygon
+    void hasObstruction(const Point& start, const Point& end, const Shape* playingPiece,
+                        std::pmr::vector<Point>& result) const;
+    static std::pair<Point2, bool> areLinesIntersecting(const LinearMath::LineSegment &line1, const LinearMath::LineSegment &line2);
+    /**
+     * @brief Lists the components a piece would hit when translated straight to the end position.
+     *
+     * The path of the piece's center is clipped against its configuration space obstacles,
+     * so the test is exact for convex shapes, edge-edge contacts included.
+     *
+     * @param result Receives the ids of the obstructing components with the center position at
+     *        the first contact, ordered along the path.
+     */
+    void scanPossibleCollision(const Polygon& polygon, const Point& endPosition,
+                               std::pmr::vector<std::pair<Broadphase::Id, Point>>& result);
+    /**
+     * @brief Returns the cached configuration space obstacles of a piece, refreshing the stale ones.
+     *
+     * Translating the piece keeps its obstacles valid; they are recomputed after the piece
+     * rotates, and one at a time when the corresponding component moves or rotates.
+     */
+    const ConfigurationSpace& configurationSpace(const Polygon& piece);
+    /**
+     * @brief Tells whether the piece, centered at the position, would overlap no other component.
+     *
+     * Only the obstacles of the components whose bounding box touches the piece's box at the
+     * position are refreshed and tested.
+     */
+    bool isFreePlacement(const Polygon& piece, const Point& position);
+    /**
+     * @brief Returns the ids of the components whose bounding box touches the region swept by a moving piece.
+     *
+     * The swept region is the union of the piece's current bounding box and the same box
+     * translated so that the piece's center lies on the end position. The ids index
+     * components() and are sorted.
+     */
+    void neigbhorsShapes(const Polygon& playerPiece, const Point& endPosition, Broadphase::IdList& result) const;
+    // Refreshes the broadphase entry of a component after it moved or rotated
+    void updateComponent(const Shape& component, ComponentChange change = ComponentChange::Translated);
+    // Makes the scene seen by the calling thread the island, or the whole scene again for nullptr
+    static void enterIsland(Island* island);
+    // Applies the updates recorded by islands, sorted by operation as serial moves would have
+    void applyUpdates(std::vector<Update> updates);
+    // Where the components write their messages: the island's buffer, or the standard output
+    static std::ostream& output();
+    /**
+     * @brief Drops the messages of the components on the calling thread while it lives.
+     *
+     * The messages of islands are printed by the thread that started the batch once it is done,
+     * so a batch started within the scope is quiet too.
+     */
+    class QuietScope
+    {
+    public:
+        QuietScope();
+        ~QuietScope();
+        QuietScope(const QuietScope&) = delete;
+        QuietScope& operator=(const QuietScope&) = delete;
+
+    private:
+        bool _previous;
+    };
+    /**
+     * @brief Adds a reader of the snapshots, to be used by one other thread.
+     *
+     * The reader's acquire() returns the latest snapshot without ever waiting, and the snapshot
+     * does not change until the next acquire(), whatever the scene does meanwhile. Readers are
+     * added from the thread that changes the scene; one its thread lets go of is dropped at the
+     * next publication.
+     */
+    std::shared_ptr<SnapshotReader> addSnapshotReader();
+    /**
+     * @brief Publishes the poses of all components to every reader, at the end of a step.
+     *
+     * Each reader's spare snapshot is only refreshed for the components whose pose version
+     * changed since that snapshot was last filled.
+     */
+    void publishSnapshot();
+    /**
+     * @brief Returns the regions touched by the components added or updated since a change count.
+     *
+     * Each region is the union of the component's bounding box before and after the change,
+     * so caches derived from the scene, like occupancy grids, only need to refresh those areas.
+     * The log keeps a bounded number of entries: older changes are merged into one region that
+     * covers them all, which a reader that fell that far behind gets instead.
+     */
+    std::span<const Broadphase::Box> changedRegions(std::size_t since) const;
+    // Number of changes recorded so far, to pass to changedRegions() later
+    std::size_t changeCount() const;
+    // Fills the result with the sorted ids of the components whose bounding box overlaps the region
+    void overlappingShapes(const Broadphase::Box& region, Broadphase::IdList& result, const Shape* exclude = nullptr) const;
+    /**
+     * @brief Fills the result with every pair of components that currently intersect.
+     *
+     * The candidate pairs come from a single sweep-and-prune pass over all bounding boxes, and
+     * only those candidates are tested, with the kernel of their pair of shape kinds.
+     */
+    void collidingPairs(std::pmr::vector<std::pair<Broadphase::Id, Broadphase::Id>>& result);
+    // Rebuilds the spatial index with the given backend; the AABB tree is the default
+    void setBroadphase(BroadphaseType type);
+    // Read-only view of the components, indexed by Shape::componentId(); removed ones have no shape
+    std::span<const Component> components() const;
+    const Component& component(std::size_t id) const;
+    void setPlayerPiece(std::size_t id, bool selected);
     int numOfComponents();
+    // Minimum and maximum corners of the scene area
+    std::pair<Point, Point> bounds() const;
     double endPosition() const;
     void setEndPosition(double newEndPosition);
-    std::shared_ptr<Shape> playerPieces() const;
-    void setPlayerPieces(std::unique_ptr<std::shared_ptr<Shape> > newPlayerPieces);
+    // Calls the function with every polygon, or every circular shape, in the order of its pool
+    template<typename Function>
+    void forEachPolygon(Function&& function) const { _polygons.forEach(std::forward<Function>(function)); }
+    template<typename Function>
+    void forEachCircularShape(Function&& function) const { _circularShapes.forEach(std::forward<Function>(function)); }
+    // Union of the piece's bounding box at its current center and at the end position
+    static Broadphase::Box sweptBox(const Polygon& polygon, const Point& endPosition);
 
 private:
     Scene(const Point & origin, double width, double height);
+    void addComponent(Shape& shape, ShapeHandle handle);
+    void applyUpdate(Broadphase::Id id, const Broadphase::Box& box, ComponentChange change);
+    // Appends to the log of changed regions, merging its older half once it is full
+    void recordChange(const Broadphase::Box& region);
+    // The island of this scene the calling thread works on, or nullptr
+    Island* island() const;
+    // Configuration space of a piece with its reflected outline up to date; obstacles may be stale
+    ConfigurationSpace& pieceSpace(const Polygon& piece);
+    // Recomputes one obstacle of a piece's configuration space if its component changed since
+    void refreshObstacle(ConfigurationSpace& space, std::size_t pieceId, std::size_t id);
 private:
     Point _origin;
     double _width, _height, _endPosition;
-    std::vector<std::pair<std::shared_ptr<Shape>, bool>> _components;
-    std::unique_ptr<std::shared_ptr<Shape>> _playerPieces;
-    const double MARIGIN = 20;
-    inline static std::shared_ptr<Scene> instance_;
+    // The shapes, one pool per kind; the pools outlive the components that point into them
+    ShapePool<Polygon, ShapeKind::Polygon> _polygons;
+    ShapePool<CircularShape, ShapeKind::CircularShape> _circularShapes;
+    std::vector<Component> _components;
+    std::unique_ptr<Broadphase> _broadphase;
+    SweepAndPrune _sweepAndPrune;
+    // Component versions: the pose one changes with every update, the shape one only on rotation
+    std::vector<std::uint64_t> _poseVersions;
+    std::vector<std::uint64_t> _shapeVersions;
+    // Bounding box of each component at its last update, and the log of changed regions; the
+    // first entry of the log is change number _changeBase
+    std::vector<Broadphase::Box> _boxes;
+    std::vector<Broadphase::Box> _changedRegions;
+    std::size_t _changeBase = 0;
+    std::unordered_map<std::size_t, ConfigurationSpace> _configurationSpaces;
+    std::vector<std::shared_ptr<SnapshotReader>> _snapshotReaders;
+    std::uint64_t _snapshotStep = 0;
+    static constexpr double GRID_CELL_SIZE = 16;
+    // Gap kept between a piece and the components by the configuration space obstacles
+    static constexpr double CLEARANCE = 1e-3;
+    // Sides of the polygon that replaces a circular component
+    static constexpr int CIRCLE_SIDES = 16;
+    static constexpr double TREE_MARGIN = 2;
+    // Entries the log of changed regions holds at most, so it stops growing
+    static constexpr std::size_t CHANGE_LOG_LIMIT = 1 << 16;
+    // Island the calling thread works on, whichever scene it belongs to
+    inline static thread_local Island* island_ = nullptr;
+    // True while a QuietScope lives on the calling thread
+    inline static thread_local bool quiet_ = false;
 };
 
 #endif // SCENE_H
@@ -0,0 +1,43 @@
+#include "scratcharena.h"
+#include <cstdint>
+
+ScratchArena& ScratchArena::local()
+{
+    thread_local ScratchArena arena;
+    return arena;
+}
+
+std::size_t ScratchArena::capacity() const
+{
+    std::size_t bytes = 0;
+    for (const Block& block : _blocks)
+    {
+        bytes += block.size;
+    }
+    return bytes;
+}
+
+void* ScratchArena::do_allocate(std::size_t bytes, std::size_t alignment)
+{
+    while (true)
+    {
+        if (_block == _blocks.size())
+        {
+            // Blocks are only added, so a rewound arena fills the same ones again
+            const std::size_t size = std::max(BLOCK_SIZE, bytes + alignment);
+            _blocks.push_back({std::unique_ptr<std::byte[]>(new std::byte[size]), size});
+        }
+
+        const Block& block = _blocks[_block];
+        const auto base = reinterpret_cast<std::uintptr_t>(block.data.get());
+        const std::uintptr_t start = (base + _offset + alignment - 1) & ~(alignment - 1);
+        if (start + bytes <= base + block.size)
+        {
+            _offset = start + bytes - base;
+            return reinterpret_cast<void*>(start);
+        }
+        // The rest of this block is too small; the next one, or a new one, takes the request
+        ++_block;
+        _offset = 0;
+    }
+}
@@ -0,0 +1,94 @@
+/**
+ * @file ScratchArena.h
+ *
+ * @brief Defines the ScratchArena class, the per-thread bump allocator of the collision and scene queries.
+ */
+
+#ifndef SCRATCHARENA_H
+#define SCRATCHARENA_H
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <type_traits>
+#include <vector>
+
+/**
+ * @class ScratchArena
+ * @brief Hands out the temporaries of a query by moving a pointer through blocks it never frees.
+ *
+ * Every thread has its own arena, so taking memory needs no lock, and freeing it does nothing.
+ * A Scope rewinds the arena to where it stood when the Scope was opened, and the next query
+ * reuses the same blocks: once they cover the largest query, the arena no longer touches the
+ * heap. Memory taken while a Scope is open must not be used after it closes, so a function
+ * that fills a container its caller passed in never opens a Scope of its own.
+ *
+ * The arena is a std::pmr::memory_resource, so pmr containers can keep their elements in it.
+ */
+class ScratchArena : public std::pmr::memory_resource
+{
+public:
+    ScratchArena() = default;
+    ScratchArena(const ScratchArena& other) = delete;
+    ScratchArena& operator=(const ScratchArena& other) = delete;
+
+    // The arena of the calling thread
+    static ScratchArena& local();
+
+    /**
+     * @brief Gives back, when it is destroyed, all memory the thread's arena handed out since it was made.
+     */
+    class Scope
+    {
+    public:
+        Scope() : _arena{local()}, _block{_arena._block}, _offset{_arena._offset} {}
+        ~Scope()
+        {
+            _arena._block = _block;
+            _arena._offset = _offset;
+        }
+
+        Scope(const Scope& other) = delete;
+        Scope& operator=(const Scope& other) = delete;
+
+        ScratchArena& arena() const { return _arena; }
+
+    private:
+        ScratchArena& _arena;
+        std::size_t _block;
+        std::size_t _offset;
+    };
+
+    // Uninitialized room for count values, aligned for the vector registers of SatKernel
+    template <typename T>
+    T* array(std::size_t count)
+    {
+        static_assert(std::is_trivially_destructible_v<T>);
+        return static_cast<T*>(allocate(std::max<std::size_t>(count, 1) * sizeof(T), std::max(alignof(T), ALIGNMENT)));
+    }
+
+    // Bytes held in blocks, whether in use or not
+    std::size_t capacity() const;
+
+private:
+    struct Block
+    {
+        std::unique_ptr<std::byte[]> data;
+        std::size_t size;
+    };
+
+    void* do_allocate(std::size_t bytes, std::size_t alignment) override;
+    void do_deallocate(void*, std::size_t, std::size_t) override {}
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+
+    static constexpr std::size_t ALIGNMENT = 32;
+    static constexpr std::size_t BLOCK_SIZE = 64 * 1024;
+
+    std::vector<Block> _blocks;
+    // Block being filled and the bytes already handed out from it
+    std::size_t _block = 0;
+    std::size_t _offset = 0;
+};
+
+#endif // SCRATCHARENA_H
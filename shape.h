@@ -3,6 +3,9 @@
 
 #include <memory>
 #include "point.h"
+
+class Scene;
+
 /**
  * @brief The Shape class
  */
@@ -11,11 +14,23 @@ class Shape
 {
 public:
     virtual ~Shape() = default;
-    virtual void rotate(const Point& pivot, double angle, bool clockwise) = 0;
+    // Returns the angle, in degrees, by which the shape was actually rotated
+    virtual double rotate(const Point& pivot, double angle, bool clockwise) = 0;
     virtual void move(const Point& destination, double stepSize) = 0;
-    virtual bool isColliding(const std::shared_ptr<Shape>& other) const = 0;
+    virtual bool isColliding(const Shape& other) const = 0;
     virtual std::pair<Point, Point> calculateBoundingBox() const = 0;
     void draw(){}
+
+    // Index of the shape in the Scene components, assigned when it is mapped to the Scene
+    std::size_t componentId() const { return _componentId; }
+    void setComponentId(std::size_t id) { _componentId = id; }
+    // Scene the shape was mapped to, or nullptr; the Scene owns its shapes and outlives them there
+    Scene* scene() const { return _scene; }
+    void setScene(Scene* scene) { _scene = scene; }
+
+private:
+    std::size_t _componentId = 0;
+    Scene* _scene = nullptr;
 };
 
 #endif // SHAPE_H
@@ -0,0 +1,172 @@
+/**
+ * @file ShapePool.h
+ *
+ * @brief Defines the ShapePool class template, which stores the shapes of one kind side by side.
+ */
+
+#ifndef SHAPEPOOL_H
+#define SHAPEPOOL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <utility>
+#include <vector>
+
+// Kind of a shape, telling which pool of the Scene holds it
+enum class ShapeKind : std::uint8_t
+{
+    Polygon,
+    CircularShape
+};
+
+/**
+ * @brief Names a shape of a Scene by its pool and slot.
+ *
+ * The generation of the slot is kept with it, so a handle to a removed shape stays invalid
+ * even after its slot holds another shape. A default constructed handle names nothing.
+ */
+struct ShapeHandle
+{
+    ShapeKind kind = ShapeKind::Polygon;
+    std::uint32_t index = 0;
+    std::uint32_t generation = 0;
+
+    bool operator ==(const ShapeHandle& other) const = default;
+};
+
+/**
+ * @class ShapePool
+ * @brief Owns shapes of one kind in contiguous chunks, addressed by generational handles.
+ *
+ * The shapes are constructed in place in chunks of CHUNK_SIZE slots, so walking the pool reads
+ * memory in order and a shape never moves once created: the Scene and the shapes keep plain
+ * pointers to each other. A removed shape's slot is reused by the next one created; its
+ * generation, odd while the slot is taken, tells the handles of the two apart.
+ */
+template<typename T, ShapeKind Kind>
+class ShapePool
+{
+public:
+    ShapePool() = default;
+    ShapePool(const ShapePool& other) = delete;
+    ShapePool& operator =(const ShapePool& other) = delete;
+
+    ~ShapePool()
+    {
+        for (std::size_t index = 0; index < _generations.size(); ++index)
+        {
+            if (_generations[index] & 1)
+            {
+                slot(index)->~T();
+            }
+        }
+    }
+
+    // Constructs a shape in a free slot and returns its handle
+    template<typename... Args>
+    ShapeHandle emplace(Args&&... args)
+    {
+        std::uint32_t index;
+        if (!_free.empty())
+        {
+            index = _free.back();
+            _free.pop_back();
+        }
+        else
+        {
+            index = static_cast<std::uint32_t>(_generations.size());
+            if (index % CHUNK_SIZE == 0)
+            {
+                _chunks.push_back(std::make_unique<Slot[]>(CHUNK_SIZE));
+            }
+            _generations.push_back(0);
+        }
+
+        new (slot(index)) T(std::forward<Args>(args)...);
+        ++_generations[index];
+        ++_size;
+        return {Kind, index, _generations[index]};
+    }
+
+    // Destroys the shape; a stale handle is ignored
+    void erase(ShapeHandle handle)
+    {
+        if (T* shape = get(handle))
+        {
+            shape->~T();
+            ++_generations[handle.index];
+            _free.push_back(handle.index);
+            --_size;
+        }
+    }
+
+    // The shape the handle names, or nullptr if it was removed or belongs to another pool
+    T* get(ShapeHandle handle)
+    {
+        return contains(handle) ? slot(handle.index) : nullptr;
+    }
+
+    const T* get(ShapeHandle handle) const
+    {
+        return contains(handle) ? slot(handle.index) : nullptr;
+    }
+
+    // Number of shapes in the pool
+    std::size_t size() const
+    {
+        return _size;
+    }
+
+    // Calls the function with every shape, in slot order
+    template<typename Function>
+    void forEach(Function&& function)
+    {
+        for (std::size_t index = 0; index < _generations.size(); ++index)
+        {
+            if (_generations[index] & 1)
+            {
+                function(*slot(index));
+            }
+        }
+    }
+
+    template<typename Function>
+    void forEach(Function&& function) const
+    {
+        for (std::size_t index = 0; index < _generations.size(); ++index)
+        {
+            if (_generations[index] & 1)
+            {
+                function(static_cast<const T&>(*slot(index)));
+            }
+        }
+    }
+
+private:
+    struct alignas(T) Slot
+    {
+        std::byte bytes[sizeof(T)];
+    };
+
+    bool contains(ShapeHandle handle) const
+    {
+        return handle.kind == Kind && handle.index < _generations.size() && handle.generation == _generations[handle.index]
+               && (handle.generation & 1);
+    }
+
+    T* slot(std::size_t index) const
+    {
+        return std::launder(reinterpret_cast<T*>(_chunks[index / CHUNK_SIZE][index % CHUNK_SIZE].bytes));
+    }
+
+    // Slots per chunk; chunks are never moved, which keeps the shapes at their address
+    static constexpr std::size_t CHUNK_SIZE = 256;
+    std::vector<std::unique_ptr<Slot[]>> _chunks;
+    std::vector<std::uint32_t> _generations;
+    std::vector<std::uint32_t> _free;
+    std::size_t _size = 0;
+};
+
+#endif // SHAPEPOOL_H
@@ -0,0 +1,182 @@
+#include "spatialgrid.h"
+#include <algorithm>
+#include <cmath>
+
+SpatialGrid::SpatialGrid(double cellSize) : _cellSize{cellSize}
+{
+
+}
+
+void SpatialGrid::insert(Id id, const Box& box)
+{
+    if (id >= _entries.size())
+    {
+        _entries.resize(id + 1);
+    }
+
+    Entry& entry = _entries[id];
+    if (entry.active)
+    {
+        update(id, box);
+        return;
+    }
+
+    entry.box = box;
+    entry.range = cellRange(box);
+    entry.active = true;
+    addToCells(id, entry.range, nullptr);
+}
+
+void SpatialGrid::update(Id id, const Box& box)
+{
+    if (id >= _entries.size() || !_entries[id].active)
+    {
+        insert(id, box);
+        return;
+    }
+
+    Entry& entry = _entries[id];
+    const CellRange range = cellRange(box);
+    entry.box = box;
+
+    if (range == entry.range)
+    {
+        return;
+    }
+
+    // Only touch the cells the entry left or entered
+    removeFromCells(id, entry.range, &range);
+    addToCells(id, range, &entry.range);
+    entry.range = range;
+}
+
+void SpatialGrid::remove(Id id)
+{
+    if (id >= _entries.size() || !_entries[id].active)
+    {
+        return;
+    }
+
+    Entry& entry = _entries[id];
+    removeFromCells(id, entry.range, nullptr);
+    entry.active = false;
+}
+
+void SpatialGrid::query(const Box& region, IdList& result) const
+{
+    collect(cellRange(region), result, [&region](const Box& box) { return overlaps(box, region); });
+}
+
+void SpatialGrid::queryPoint(const Point& point, IdList& result) const
+{
+    const Box region{point, point};
+    collect(cellRange(region), result, [&region](const Box& box) { return overlaps(box, region); });
+}
+
+void SpatialGrid::querySegment(const Point& start, const Point& end, IdList& result) const
+{
+    const Box region{Point2(std::min(start.getX(), end.getX()), std::min(start.getY(), end.getY())),
+                     Point2(std::max(start.getX(), end.getX()), std::max(start.getY(), end.getY()))};
+    collect(cellRange(region), result, [&start, &end](const Box& box) { return segmentOverlaps(start, end, box); });
+}
+
+template <typename Accept>
+void SpatialGrid::collect(const CellRange& range, IdList& result, Accept accept) const
+{
+    result.clear();
+
+    for (int x = range.minX; x <= range.maxX; ++x)
+    {
+        for (int y = range.minY; y <= range.maxY; ++y)
+        {
+            const auto cell = _cells.find(cellKey(x, y));
+            if (cell == _cells.end())
+            {
+                continue;
+            }
+
+            for (Id id : cell->second)
+            {
+                // An entry spanning several cells is only reported from the first cell it
+                // shares with the query, so queries keep no state and may run concurrently
+                const Entry& entry = _entries[id];
+                if (x != std::max(entry.range.minX, range.minX) || y != std::max(entry.range.minY, range.minY))
+                {
+                    continue;
+                }
+
+                if (accept(entry.box))
+                {
+                    result.push_back(id);
+                }
+            }
+        }
+    }
+}
+
+double SpatialGrid::cellSize() const
+{
+    return _cellSize;
+}
+
+SpatialGrid::CellRange SpatialGrid::cellRange(const Box& box) const
+{
+    return CellRange{static_cast<int>(std::floor(box.first.getX() / _cellSize)),
+                     static_cast<int>(std::floor(box.first.getY() / _cellSize)),
+                     static_cast<int>(std::floor(box.second.getX() / _cellSize)),
+                     static_cast<int>(std::floor(box.second.getY() / _cellSize))};
+}
+
+std::int64_t SpatialGrid::cellKey(int x, int y)
+{
+    return (static_cast<std::int64_t>(x) << 32) | static_cast<std::uint32_t>(y);
+}
+
+void SpatialGrid::addToCells(Id id, const CellRange& range, const CellRange* skip)
+{
+    for (int x = range.minX; x <= range.maxX; ++x)
+    {
+        for (int y = range.minY; y <= range.maxY; ++y)
+        {
+            if (skip && contains(*skip, x, y))
+            {
+                continue;
+            }
+            _cells[cellKey(x, y)].push_back(id);
+        }
+    }
+}
+
+void SpatialGrid::removeFromCells(Id id, const CellRange& range, const CellRange* skip)
+{
+    for (int x = range.minX; x <= range.maxX; ++x)
+    {
+        for (int y = range.minY; y <= range.maxY; ++y)
+        {
+            if (skip && contains(*skip, x, y))
+            {
+                continue;
+            }
+
+            const auto cell = _cells.find(cellKey(x, y));
+            if (cell == _cells.end())
+            {
+                continue;
+            }
+
+            auto& ids = cell->second;
+            const auto it = std::find(ids.begin(), ids.end(), id);
+            if (it != ids.end())
+            {
+                *it = ids.back();
+                ids.pop_back();
+            }
+            // An emptied cell is kept with its capacity, so entering it again allocates nothing
+        }
+    }
+}
+
+bool SpatialGrid::contains(const CellRange& range, int x, int y)
+{
+    return x >= range.minX && x <= range.maxX && y >= range.minY && y <= range.maxY;
+}
@@ -0,0 +1,79 @@
+/**
+ * @file SpatialGrid.h
+ *
+ * @brief Defines the SpatialGrid class, a uniform-grid spatial hash used as the Scene broadphase.
+ */
+
+#ifndef SPATIALGRID_H
+#define SPATIALGRID_H
+
+#include <cstdint>
+#include <unordered_map>
+#include "broadphase.h"
+
+/**
+ * @class SpatialGrid
+ * @brief Buckets axis aligned bounding boxes into square cells of a fixed size.
+ *
+ * Every entry is stored in all cells its bounding box touches. Cells are kept in a hash map,
+ * so the grid is unbounded and only occupied cells use memory. Updating an entry only touches
+ * the cells that it entered or left, which for small per-step movements is usually none.
+ * A region query visits the cells covered by the region, so its cost depends on the local
+ * density of the scene rather than on the total number of entries.
+ */
+class SpatialGrid : public Broadphase
+{
+public:
+    /**
+    * @brief Constructor for SpatialGrid.
+    * @param cellSize Edge length of a grid cell in scene units.
+    */
+    explicit SpatialGrid(double cellSize);
+
+    void insert(Id id, const Box& box) override;
+    void update(Id id, const Box& box) override;
+    void remove(Id id) override;
+
+    /**
+    * @brief Collects the entries whose bounding box overlaps a region.
+    *
+    * Each entry is reported once, even if it spans several cells. The result vector is
+    * cleared before it is filled.
+    *
+    * @param region The minimum and maximum corners of the region to query.
+    * @param result Receives the ids of the overlapping entries.
+    */
+    void query(const Box& region, IdList& result) const override;
+    void queryPoint(const Point& point, IdList& result) const override;
+    void querySegment(const Point& start, const Point& end, IdList& result) const override;
+
+    double cellSize() const;
+
+private:
+    struct CellRange
+    {
+        int minX, minY, maxX, maxY;
+        bool operator ==(const CellRange& other) const = default;
+    };
+
+    struct Entry
+    {
+        Box box;
+        CellRange range;
+        bool active = false;
+    };
+
+    CellRange cellRange(const Box& box) const;
+    template <typename Accept>
+    void collect(const CellRange& range, IdList& result, Accept accept) const;
+    static std::int64_t cellKey(int x, int y);
+    void addToCells(Id id, const CellRange& range, const CellRange* skip);
+    void removeFromCells(Id id, const CellRange& range, const CellRange* skip);
+    static bool contains(const CellRange& range, int x, int y);
+
+    double _cellSize;
+    std::unordered_map<std::int64_t, std::vector<Id>> _cells;
+    std::vector<Entry> _entries;
+};
+
+#endif // SPATIALGRID_H
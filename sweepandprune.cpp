@@ -0,0 +1,217 @@
+#include "sweepandprune.h"
+#include <algorithm>
+#include <limits>
+
+void SweepAndPrune::insert(Id id, const Box& box)
+{
+    if (id >= _entries.size())
+    {
+        _entries.resize(id + 1);
+    }
+    if (_entries[id].active)
+    {
+        update(id, box);
+        return;
+    }
+
+    _entries[id].box = box;
+    _entries[id].active = true;
+
+    // New endpoints start past the end of the lists, where they overlap nothing. The next
+    // sort moves them into place and reports their pairs like for any other movement.
+    const double far = std::numeric_limits<double>::infinity();
+    _xAxis.push_back({far, id, false});
+    _xAxis.push_back({far, id, true});
+    _yAxis.push_back({far, id, false});
+    _yAxis.push_back({far, id, true});
+}
+
+void SweepAndPrune::update(Id id, const Box& box)
+{
+    if (id >= _entries.size() || !_entries[id].active)
+    {
+        insert(id, box);
+        return;
+    }
+
+    // The endpoint values are refreshed lazily by the next sort
+    _entries[id].box = box;
+}
+
+void SweepAndPrune::remove(Id id)
+{
+    if (id >= _entries.size() || !_entries[id].active)
+    {
+        return;
+    }
+
+    _entries[id].active = false;
+    std::erase_if(_xAxis, [id](const Endpoint& endpoint) { return endpoint.id == id; });
+    std::erase_if(_yAxis, [id](const Endpoint& endpoint) { return endpoint.id == id; });
+    for (std::size_t slot = 0; slot < _pairSlots.size();)
+    {
+        const std::uint64_t key = _pairSlots[slot];
+        if (key != EMPTY_SLOT && ((key >> 32) == id || (key & 0xffffffffu) == id))
+        {
+            // The erase shifts a later key into this slot, which is looked at again
+            erasePairSlot(slot);
+        }
+        else
+        {
+            ++slot;
+        }
+    }
+}
+
+void SweepAndPrune::overlappingPairs(std::pmr::vector<std::pair<Id, Id>>& result)
+{
+    sortAxis(_xAxis, 0);
+    sortAxis(_yAxis, 1);
+
+    result.clear();
+    result.reserve(_pairCount);
+    for (std::uint64_t key : _pairSlots)
+    {
+        if (key != EMPTY_SLOT)
+        {
+            result.emplace_back(static_cast<Id>(key >> 32), static_cast<Id>(key & 0xffffffffu));
+        }
+    }
+    std::sort(result.begin(), result.end());
+}
+
+void SweepAndPrune::sortAxis(std::vector<Endpoint>& axis, int coordinate)
+{
+    for (Endpoint& endpoint : axis)
+    {
+        const Box& box = _entries[endpoint.id].box;
+        endpoint.value = endpoint.isMax ? SweepAndPrune::coordinate(box.second, coordinate)
+                                        : SweepAndPrune::coordinate(box.first, coordinate);
+    }
+
+    for (std::size_t i = 1; i < axis.size(); ++i)
+    {
+        siftDown(axis, i);
+    }
+}
+
+void SweepAndPrune::siftDown(std::vector<Endpoint>& axis, std::size_t index)
+{
+    const Endpoint moving = axis[index];
+    std::size_t i = index;
+
+    while (i > 0 && moving < axis[i - 1])
+    {
+        const Endpoint& passed = axis[i - 1];
+        if (!moving.isMax && passed.isMax)
+        {
+            // A minimum passes a maximum: the intervals start overlapping on this axis
+            if (passed.id != moving.id && Broadphase::overlaps(_entries[moving.id].box, _entries[passed.id].box))
+            {
+                addPair(pairKey(moving.id, passed.id));
+            }
+        }
+        else if (moving.isMax && !passed.isMax)
+        {
+            // A maximum passes a minimum: the intervals stop overlapping on this axis
+            removePair(pairKey(moving.id, passed.id));
+        }
+
+        axis[i] = passed;
+        --i;
+    }
+    axis[i] = moving;
+}
+
+double SweepAndPrune::coordinate(const Point2& point, int axis)
+{
+    return axis == 0 ? point.getX() : point.getY();
+}
+
+std::uint64_t SweepAndPrune::pairKey(Id a, Id b)
+{
+    if (a > b)
+        std::swap(a, b);
+    return (static_cast<std::uint64_t>(a) << 32) | static_cast<std::uint64_t>(b);
+}
+
+std::size_t SweepAndPrune::pairSlot(std::uint64_t key) const
+{
+    // Fibonacci hashing spreads the consecutive ids over the slots
+    return static_cast<std::size_t>((key * 0x9e3779b97f4a7c15ull) >> 32) & (_pairSlots.size() - 1);
+}
+
+void SweepAndPrune::addPair(std::uint64_t key)
+{
+    // At most half of the slots are used, which keeps the probe sequences short
+    if (2 * (_pairCount + 1) > _pairSlots.size())
+    {
+        growPairs();
+    }
+
+    const std::size_t mask = _pairSlots.size() - 1;
+    for (std::size_t slot = pairSlot(key);; slot = (slot + 1) & mask)
+    {
+        if (_pairSlots[slot] == key)
+        {
+            return;
+        }
+        if (_pairSlots[slot] == EMPTY_SLOT)
+        {
+            _pairSlots[slot] = key;
+            ++_pairCount;
+            return;
+        }
+    }
+}
+
+void SweepAndPrune::removePair(std::uint64_t key)
+{
+    if (_pairCount == 0)
+    {
+        return;
+    }
+
+    const std::size_t mask = _pairSlots.size() - 1;
+    for (std::size_t slot = pairSlot(key); _pairSlots[slot] != EMPTY_SLOT; slot = (slot + 1) & mask)
+    {
+        if (_pairSlots[slot] == key)
+        {
+            erasePairSlot(slot);
+            return;
+        }
+    }
+}
+
+void SweepAndPrune::erasePairSlot(std::size_t slot)
+{
+    // The following keys of the probe sequence move back instead of leaving a tombstone, so
+    // lookups never step over removed pairs
+    const std::size_t mask = _pairSlots.size() - 1;
+    std::size_t hole = slot;
+    for (std::size_t next = (hole + 1) & mask; _pairSlots[next] != EMPTY_SLOT; next = (next + 1) & mask)
+    {
+        const std::size_t home = pairSlot(_pairSlots[next]);
+        if (((next - home) & mask) >= ((next - hole) & mask))
+        {
+            _pairSlots[hole] = _pairSlots[next];
+            hole = next;
+        }
+    }
+    _pairSlots[hole] = EMPTY_SLOT;
+    --_pairCount;
+}
+
+void SweepAndPrune::growPairs()
+{
+    std::vector<std::uint64_t> previous(std::max<std::size_t>(64, 2 * _pairSlots.size()), EMPTY_SLOT);
+    previous.swap(_pairSlots);
+    _pairCount = 0;
+    for (std::uint64_t key : previous)
+    {
+        if (key != EMPTY_SLOT)
+        {
+            addPair(key);
+        }
+    }
+}
@@ -0,0 +1,87 @@
+/**
+ * @file SweepAndPrune.h
+ *
+ * @brief Defines the SweepAndPrune class, a sort-and-sweep broadphase producing all overlapping pairs.
+ */
+
+#ifndef SWEEPANDPRUNE_H
+#define SWEEPANDPRUNE_H
+
+#include <cstdint>
+#include <vector>
+#include "broadphase.h"
+
+/**
+ * @class SweepAndPrune
+ * @brief Keeps the x and y extents of all entries in sorted endpoint lists.
+ *
+ * The lists persist between ticks. Updating an entry only stores its new box; the next call
+ * to overlappingPairs() repairs both lists with an insertion sort. Since shapes move by small
+ * steps, the lists are nearly sorted and the repair is close to linear. Every swap of a
+ * minimum and a maximum endpoint tells that two entries started or stopped overlapping on that
+ * axis, so the set of overlapping pairs is maintained while sorting. The pairs are kept in an
+ * open-addressing hash set of keys, so adding or removing one takes constant time. The set
+ * keeps its slots and only grows, so the steady state does not allocate.
+ */
+class SweepAndPrune
+{
+public:
+    using Id = Broadphase::Id;
+    using Box = Broadphase::Box;
+
+    void insert(Id id, const Box& box);
+    void update(Id id, const Box& box);
+    void remove(Id id);
+
+    /**
+    * @brief Repairs the endpoint lists and returns all pairs of entries with overlapping boxes.
+    *
+    * Each pair holds the smaller id first, and the pairs are sorted so the result does not
+    * depend on the order of the updates.
+    *
+    * @param result Receives the overlapping pairs. It is cleared before it is filled.
+    */
+    void overlappingPairs(std::pmr::vector<std::pair<Id, Id>>& result);
+
+private:
+    struct Endpoint
+    {
+        double value;
+        Id id;
+        bool isMax;
+
+        bool operator <(const Endpoint& other) const
+        {
+            // At equal values minimums come first, so touching boxes count as overlapping
+            return value < other.value || (value == other.value && !isMax && other.isMax);
+        }
+    };
+
+    struct Entry
+    {
+        Box box;
+        bool active = false;
+    };
+
+    void sortAxis(std::vector<Endpoint>& axis, int coordinate);
+    void siftDown(std::vector<Endpoint>& axis, std::size_t index);
+    static double coordinate(const Point2& point, int axis);
+    static std::uint64_t pairKey(Id a, Id b);
+    std::size_t pairSlot(std::uint64_t key) const;
+    void addPair(std::uint64_t key);
+    void removePair(std::uint64_t key);
+    void erasePairSlot(std::size_t slot);
+    void growPairs();
+
+    // Marks an unused slot of the pair set; no pair has this key since its ids differ
+    static constexpr std::uint64_t EMPTY_SLOT = ~std::uint64_t(0);
+
+    std::vector<Entry> _entries;
+    std::vector<Endpoint> _xAxis;
+    std::vector<Endpoint> _yAxis;
+    // Keys of the overlapping pairs, hashed with linear probing into a power of two of slots
+    std::vector<std::uint64_t> _pairSlots;
+    std::size_t _pairCount = 0;
+};
+
+#endif // SWEEPANDPRUNE_H
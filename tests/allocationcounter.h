@@ -0,0 +1,29 @@
+/**
+ * @file AllocationCounter.h
+ *
+ * @brief Defines the AllocationCounter class, which counts the heap allocations of each thread.
+ */
+
+#ifndef ALLOCATIONCOUNTER_H
+#define ALLOCATIONCOUNTER_H
+
+#include <cstdint>
+
+/**
+ * @class AllocationCounter
+ * @brief Counts every call to the global operator new made by the calling thread.
+ *
+ * The tests replace the global operator new and delete with versions that forward to malloc
+ * and free and count each allocation; the game itself keeps the standard ones. Comparing
+ * count() before and after a step shows whether the step touched the heap, for instance that
+ * a move allocates nothing once the scratch arenas and result containers have grown to their
+ * working size.
+ */
+class AllocationCounter
+{
+public:
+    // Heap allocations made by the calling thread so far
+    static std::uint64_t count();
+};
+
+#endif // ALLOCATIONCOUNTER_H
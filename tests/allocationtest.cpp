@@ -0,0 +1,62 @@
+#include <iostream>
+#include "allocationcounter.h"
+#include "game.h"
+#include "polygon.h"
+#include "scratcharena.h"
+#include "tests.h"
+
+namespace
+{
+constexpr int WARM_UP_STEPS = 20;
+constexpr int MEASURED_STEPS = 100;
+}
+
+bool stepsDoNotAllocate()
+{
+    Game game(Scene::create());
+    game.initGameEnv();
+    Scene& scene = *game.scene();
+    std::vector<Polygon*> pieces;
+    std::vector<Point> homes;
+    for (const auto& component : scene.components())
+    {
+        if (Polygon* polygon = scene.polygon(component.handle))
+        {
+            pieces.push_back(polygon);
+            homes.push_back(polygon->getCenter());
+        }
+    }
+
+    int step = 0;
+    const auto runStep = [&]()
+    {
+        for (std::size_t i = 0; i < pieces.size(); ++i)
+        {
+            const Point offset(step % 2 ? 2 : -2, step % 3 ? 1.5 : -1.5, 0);
+            pieces[i]->move(homes[i] + offset, 0.5);
+            pieces[i]->rotate(pieces[i]->getCenter(), 10, step % 2);
+        }
+        ScratchArena::Scope scope;
+        std::pmr::vector<std::pair<Broadphase::Id, Broadphase::Id>> colliding(&scope.arena());
+        scene.collidingPairs(colliding);
+        ++step;
+    };
+
+    // The moves report their contacts
+    Scene::QuietScope quiet;
+    for (int i = 0; i < WARM_UP_STEPS; ++i)
+    {
+        runStep();
+    }
+    const std::uint64_t before = AllocationCounter::count();
+    for (int i = 0; i < MEASURED_STEPS; ++i)
+    {
+        runStep();
+    }
+    const std::uint64_t allocations = AllocationCounter::count() - before;
+    if (allocations != 0)
+    {
+        std::cerr << MEASURED_STEPS << " warmed-up steps made " << allocations << " heap allocations" << std::endl;
+    }
+    return allocations == 0;
+}
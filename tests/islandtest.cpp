@@ -0,0 +1,112 @@
+#include <iostream>
+#include <random>
+#include "islandscheduler.h"
+#include "polygon.h"
+#include "tests.h"
+
+namespace
+{
+constexpr int PIECE_COUNT = 300;
+constexpr int THREAD_COUNT = 8;
+constexpr int ROUNDS = 4;
+constexpr unsigned SEEDS[] = {1, 7, 42};
+
+// A crowded scene of quadrilaterals and triangles; every other polygon is a piece, the rest obstacles
+std::shared_ptr<Scene> crowdedScene(unsigned seed, std::vector<Polygon*>& pieces)
+{
+    auto scene = Scene::create();
+    std::mt19937 random(seed);
+    std::uniform_real_distribution<double> x(-150, 150), y(-120, 120), size(2, 6);
+    for (int i = 0; i < 2 * PIECE_COUNT; ++i)
+    {
+        const double left = x(random), bottom = y(random), s = size(random);
+        if (i % 3)
+        {
+            scene->addPolygon({Point(left, bottom, 0), Point(left + s, bottom, 0),
+                               Point(left + s, bottom + s * 0.7, 0), Point(left, bottom + s, 0)});
+        }
+        else
+        {
+            scene->addPolygon({Point(left, bottom, 0), Point(left + s, bottom + s * 0.3, 0),
+                               Point(left + s * 0.2, bottom + s, 0)});
+        }
+    }
+    for (std::size_t i = 0; i < scene->components().size(); i += 2)
+    {
+        pieces.push_back(scene->polygon(scene->component(i).handle));
+    }
+    return scene;
+}
+
+bool samePositions(const std::vector<Polygon*>& parallel, const std::vector<Polygon*>& serial)
+{
+    for (std::size_t i = 0; i < parallel.size(); ++i)
+    {
+        const auto a = parallel[i]->transformedVertices();
+        const auto b = serial[i]->transformedVertices();
+        if (!std::equal(a.begin(), a.end(), b.begin(), b.end(),
+                        [](const Point2& p, const Point2& q) { return p.getX() == q.getX() && p.getY() == q.getY(); }))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+}
+
+bool islandsMatchSerialOrder()
+{
+    Scene::QuietScope quiet;
+    IslandScheduler scheduler(THREAD_COUNT);
+    for (unsigned seed : SEEDS)
+    {
+        std::vector<Polygon*> parallel, serial;
+        const auto parallelScene = crowdedScene(seed, parallel);
+        const auto serialScene = crowdedScene(seed, serial);
+
+        std::mt19937 random(seed);
+        std::uniform_real_distribution<double> offset(-15, 15);
+        for (int round = 0; round < ROUNDS; ++round)
+        {
+            std::vector<Point> destinations;
+            for (const Polygon* piece : serial)
+            {
+                const Point center = piece->calculatePolygonCenter();
+                destinations.emplace_back(center.getX() + offset(random), center.getY() + offset(random));
+            }
+            scheduler.move(*parallelScene, parallel, destinations, 0.5);
+            for (std::size_t i = 0; i < serial.size(); ++i)
+            {
+                serial[i]->move(destinations[i], 0.5);
+            }
+            if (!samePositions(parallel, serial))
+            {
+                std::cerr << "seed " << seed << ", round " << round << ": the moves differ" << std::endl;
+                return false;
+            }
+
+            std::vector<Point> pivots;
+            for (const Polygon* piece : serial)
+            {
+                pivots.push_back(piece->calculatePolygonCenter());
+            }
+            const bool clockwise = round % 2;
+            const std::vector<double> angles = scheduler.rotate(*parallelScene, parallel, pivots, 30, clockwise);
+            for (std::size_t i = 0; i < serial.size(); ++i)
+            {
+                if (serial[i]->rotate(pivots[i], 30, clockwise) != angles[i])
+                {
+                    std::cerr << "seed " << seed << ", round " << round << ": piece " << i
+                              << " rotated by a different angle" << std::endl;
+                    return false;
+                }
+            }
+            if (!samePositions(parallel, serial))
+            {
+                std::cerr << "seed " << seed << ", round " << round << ": the rotations differ" << std::endl;
+                return false;
+            }
+        }
+    }
+    return true;
+}
@@ -0,0 +1,20 @@
+#include <iostream>
+#include <utility>
+#include "tests.h"
+
+int main()
+{
+    const std::pair<const char*, bool (*)()> tests[] = {
+        {"steps do not allocate", stepsDoNotAllocate},
+        {"islands match the serial order", islandsMatchSerialOrder},
+    };
+
+    int failures = 0;
+    for (const auto& [name, test] : tests)
+    {
+        const bool passed = test();
+        std::cout << (passed ? "PASS " : "FAIL ") << name << std::endl;
+        failures += passed ? 0 : 1;
+    }
+    return failures == 0 ? 0 : 1;
+}
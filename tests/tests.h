@@ -0,0 +1,32 @@
+/**
+ * @file Tests.h
+ *
+ * @brief Declares the checks run by the test executable.
+ */
+
+#ifndef TESTS_H
+#define TESTS_H
+
+/**
+ * @brief Checks that moving and rotating pieces and listing the colliding pairs do not allocate.
+ *
+ * The polygons of the game are moved and rotated back and forth, and the colliding pairs are
+ * listed after each step. Once a few steps have grown the scratch arena and the containers of
+ * the scene to their working size, the following steps must not touch the heap.
+ *
+ * @return True if the measured steps made no heap allocation.
+ */
+bool stepsDoNotAllocate();
+
+/**
+ * @brief Checks that the IslandScheduler leaves the pieces where a serial loop leaves them.
+ *
+ * Crowded scenes built from several seeds are stepped twice, once by an IslandScheduler with
+ * eight threads and once by moving and rotating each piece in turn. After every batch the
+ * vertices of the pieces and the angles they rotated by must be identical.
+ *
+ * @return True if both runs agree for every seed.
+ */
+bool islandsMatchSerialOrder();
+
+#endif // TESTS_H
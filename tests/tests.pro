@@ -0,0 +1,17 @@
+TEMPLATE = app
+TARGET = tests
+CONFIG += console c++20 thread
+CONFIG -= app_bundle
+CONFIG -= qt
+
+include(../engine.pri)
+
+SOURCES += \
+        allocationcounter.cpp \
+        allocationtest.cpp \
+        islandtest.cpp \
+        main.cpp
+
+HEADERS += \
+    allocationcounter.h \
+    tests.h
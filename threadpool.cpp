@@ -0,0 +1,125 @@
+#include "threadpool.h"
+#include <algorithm>
+
+ThreadPool::ThreadPool(std::size_t threadCount)
+{
+    threadCount = std::max<std::size_t>(threadCount, 1);
+    for (std::size_t thread = 0; thread < threadCount; ++thread)
+    {
+        _queues.push_back(std::make_unique<Queue>());
+    }
+    for (std::size_t thread = 1; thread < threadCount; ++thread)
+    {
+        _threads.emplace_back(&ThreadPool::work, this, thread);
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard lock(_mutex);
+        _stopping = true;
+    }
+    _started.notify_all();
+    for (auto& thread : _threads)
+    {
+        thread.join();
+    }
+}
+
+void ThreadPool::run(std::size_t count, const std::function<void(std::size_t)>& task)
+{
+    if (count == 0)
+    {
+        return;
+    }
+    if (_threads.empty() || count == 1)
+    {
+        for (std::size_t index = 0; index < count; ++index)
+        {
+            task(index);
+        }
+        return;
+    }
+
+    {
+        std::lock_guard lock(_mutex);
+        _task = &task;
+        _pending = count;
+        for (std::size_t index = 0; index < count; ++index)
+        {
+            Queue& queue = *_queues[index % _queues.size()];
+            std::lock_guard queueLock(queue.mutex);
+            queue.tasks.push_back(index);
+        }
+        ++_batch;
+    }
+    _started.notify_all();
+
+    while (runNext(0))
+    {
+    }
+    std::unique_lock lock(_mutex);
+    _finished.wait(lock, [this] { return _pending == 0; });
+    _task = nullptr;
+}
+
+void ThreadPool::work(std::size_t thread)
+{
+    std::uint64_t batch = 0;
+    while (true)
+    {
+        {
+            std::unique_lock lock(_mutex);
+            _started.wait(lock, [this, batch] { return _stopping || _batch != batch; });
+            if (_stopping)
+            {
+                return;
+            }
+            batch = _batch;
+        }
+        while (runNext(thread))
+        {
+        }
+    }
+}
+
+bool ThreadPool::runNext(std::size_t thread)
+{
+    std::size_t index = 0;
+    bool found = false;
+    {
+        Queue& own = *_queues[thread];
+        std::lock_guard lock(own.mutex);
+        if (!own.tasks.empty())
+        {
+            index = own.tasks.front();
+            own.tasks.pop_front();
+            found = true;
+        }
+    }
+    // Steal the last task of the next busy queue, which is likely the shortest
+    for (std::size_t offset = 1; !found && offset < _queues.size(); ++offset)
+    {
+        Queue& other = *_queues[(thread + offset) % _queues.size()];
+        std::lock_guard lock(other.mutex);
+        if (!other.tasks.empty())
+        {
+            index = other.tasks.back();
+            other.tasks.pop_back();
+            found = true;
+        }
+    }
+    if (!found)
+    {
+        return false;
+    }
+
+    (*_task)(index);
+    if (--_pending == 0)
+    {
+        std::lock_guard lock(_mutex);
+        _finished.notify_all();
+    }
+    return true;
+}
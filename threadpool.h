@@ -0,0 +1,76 @@
+/**
+ * @file ThreadPool.h
+ *
+ * @brief Defines the ThreadPool class, a fixed set of worker threads that steal work from each other.
+ */
+
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @class ThreadPool
+ * @brief Runs batches of indexed tasks on worker threads and the calling thread.
+ *
+ * Every thread has its own queue of task indices. A thread takes its next task from the front
+ * of its own queue and, once that queue is empty, steals from the back of the others, so a
+ * few long tasks dealt to one thread do not leave the others idle. The queues are only locked
+ * for a pop, never while a task runs.
+ */
+class ThreadPool
+{
+public:
+    /**
+    * @brief Constructor for ThreadPool.
+    * @param threadCount Number of threads running the tasks, the calling one included.
+    */
+    explicit ThreadPool(std::size_t threadCount = std::thread::hardware_concurrency());
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool& other) = delete;
+    ThreadPool& operator=(const ThreadPool& other) = delete;
+
+    /**
+    * @brief Runs the task for every index in [0, count) and returns when all of them are done.
+    *
+    * The indices are dealt in turn to the queues and each queue runs them in increasing order,
+    * so the tasks with the lowest indices start first; give those to the longest tasks.
+    */
+    void run(std::size_t count, const std::function<void(std::size_t)>& task);
+
+    // Number of threads running the tasks, the calling one included
+    std::size_t threadCount() const { return _queues.size(); }
+
+private:
+    struct Queue
+    {
+        std::mutex mutex;
+        std::deque<std::size_t> tasks;
+    };
+
+    void work(std::size_t thread);
+    // Runs one task from the thread's own queue or stolen from another; false if all are empty
+    bool runNext(std::size_t thread);
+
+    // Queue 0 belongs to the thread calling run()
+    std::vector<std::unique_ptr<Queue>> _queues;
+    std::vector<std::thread> _threads;
+    std::mutex _mutex;
+    std::condition_variable _started;
+    std::condition_variable _finished;
+    const std::function<void(std::size_t)>* _task = nullptr;
+    std::atomic<std::size_t> _pending = 0;
+    std::uint64_t _batch = 0;
+    bool _stopping = false;
+};
+
+#endif // THREADPOOL_H
@@ -0,0 +1,59 @@
+/**
+ * @file TripleBuffer.h
+ *
+ * @brief Defines the TripleBuffer class, a wait-free hand-over of values from one writer to one reader.
+ */
+
+#ifndef TRIPLEBUFFER_H
+#define TRIPLEBUFFER_H
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+/**
+ * @class TripleBuffer
+ * @brief Three values: one the writer fills, one the reader holds, and the last one published.
+ *
+ * Publishing swaps the filled value with the published one, and reading swaps the held value
+ * with the published one if it is newer, each with a single atomic exchange. Neither side ever
+ * waits for the other, and the reader never sees a value the writer is still changing. The
+ * values are reused, so a writer that only updates what changed since a value was last filled
+ * copies little.
+ */
+template <typename T>
+class TripleBuffer
+{
+public:
+    // Value the writer fills; it still holds what was written before one of the earlier publications
+    T& back() { return _values[_back]; }
+
+    // Hands the back value to the reader and takes another one to fill
+    void publish()
+    {
+        _back = _published.exchange(_back | FRESH, std::memory_order_acq_rel) & INDEX;
+    }
+
+    // Returns the latest published value; it stays unchanged until the next call
+    const T& acquire()
+    {
+        if (_published.load(std::memory_order_relaxed) & FRESH)
+        {
+            _front = _published.exchange(_front, std::memory_order_acq_rel) & INDEX;
+        }
+        return _values[_front];
+    }
+
+private:
+    static constexpr std::uint8_t INDEX = 3;
+    static constexpr std::uint8_t FRESH = 4;
+
+    std::array<T, 3> _values;
+    // The back index is only used by the writer, the front one by the reader
+    std::uint8_t _back = 0;
+    std::uint8_t _front = 1;
+    // Index of the published value, with FRESH set until the reader takes it
+    std::atomic<std::uint8_t> _published = 2;
+};
+
+#endif // TRIPLEBUFFER_H
@@ -0,0 +1,272 @@
+#include "visibilitygraph.h"
+#include "linearmath.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <queue>
+#include <tuple>
+
+namespace
+{
+double cross(double ax, double ay, double bx, double by)
+{
+    return ax * by - ay * bx;
+}
+}
+
+VisibilityGraph::VisibilityGraph() : _tree{0.0} {}
+
+void VisibilityGraph::build(std::vector<std::vector<Point2>> obstacles)
+{
+    _obstacles = std::move(obstacles);
+    _vertices.clear();
+    _tree = AABBTree(0.0);
+
+    for (std::size_t i = 0; i < _obstacles.size(); ++i)
+    {
+        const auto& obstacle = _obstacles[i];
+        if (obstacle.empty())
+        {
+            continue;
+        }
+
+        Point2 min = obstacle.front(), max = obstacle.front();
+        for (const Point2& vertex : obstacle)
+        {
+            min = Point2(std::min(min.getX(), vertex.getX()), std::min(min.getY(), vertex.getY()));
+            max = Point2(std::max(max.getX(), vertex.getX()), std::max(max.getY(), vertex.getY()));
+        }
+        _tree.insert(i, {min, max});
+    }
+
+    // Vertices covered by another obstacle can never be touched by a path
+    Broadphase::IdList ids;
+    for (std::size_t i = 0; i < _obstacles.size(); ++i)
+    {
+        const auto& obstacle = _obstacles[i];
+        for (std::size_t j = 0; j < obstacle.size(); ++j)
+        {
+            _tree.queryPoint(obstacle[j], ids);
+            const bool covered = std::any_of(ids.begin(), ids.end(), [&](Broadphase::Id id)
+                                             {
+                                                 return id != i && isInside(obstacle[j], static_cast<int>(id));
+                                             });
+            if (!covered)
+            {
+                _vertices.push_back({obstacle[j], static_cast<int>(i), static_cast<int>(j)});
+            }
+        }
+    }
+
+    _edges.assign(_vertices.size(), {});
+    for (std::size_t u = 0; u < _vertices.size(); ++u)
+    {
+        for (std::size_t v = u + 1; v < _vertices.size(); ++v)
+        {
+            const Point2& a = _vertices[u].position;
+            const Point2& b = _vertices[v].position;
+            if (!isTangent(u, b) || !isTangent(v, a) || isBlocked(a, b, {}))
+            {
+                continue;
+            }
+            const double length = a.calculateDistance(b);
+            _edges[u].push_back({static_cast<int>(v), length});
+            _edges[v].push_back({static_cast<int>(u), length});
+        }
+    }
+}
+
+std::vector<Point> VisibilityGraph::findPath(const Point& startPoint, const Point& goalPoint) const
+{
+    const Point2 start(startPoint);
+    const Point2 goal(goalPoint);
+    Broadphase::IdList ids;
+    _tree.queryPoint(goal, ids);
+    for (Broadphase::Id id : ids)
+    {
+        if (isInside(goal, static_cast<int>(id)))
+        {
+            return {};
+        }
+    }
+
+    std::vector<int> ignored;
+    _tree.queryPoint(start, ids);
+    for (Broadphase::Id id : ids)
+    {
+        if (isInside(start, static_cast<int>(id)))
+        {
+            ignored.push_back(static_cast<int>(id));
+        }
+    }
+
+    if (!isBlocked(start, goal, ignored))
+    {
+        return {goalPoint};
+    }
+
+    // Nodes are the graph vertices followed by the start and the goal
+    const int vertexCount = static_cast<int>(_vertices.size());
+    const int startNode = vertexCount;
+    const int goalNode = vertexCount + 1;
+    constexpr double INF = std::numeric_limits<double>::infinity();
+
+    std::vector<double> goalLinks(vertexCount, INF);
+    std::vector<double> length(vertexCount + 2, INF);
+    std::vector<int> segments(vertexCount + 2, 0);
+    std::vector<int> parent(vertexCount + 2, -1);
+
+    // Open list ordered by estimated length, then by number of segments
+    using Entry = std::tuple<double, int, int>;
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> open;
+    auto better = [](double length, int segments, double otherLength, int otherSegments)
+    {
+        if (std::abs(length - otherLength) > TOLERANCE)
+        {
+            return length < otherLength;
+        }
+        return segments < otherSegments;
+    };
+    auto relax = [&](int node, double newLength, int newSegments, int from)
+    {
+        if (length[node] != INF && !better(newLength, newSegments, length[node], segments[node]))
+        {
+            return;
+        }
+        length[node] = newLength;
+        segments[node] = newSegments;
+        parent[node] = from;
+        const Point2& position = node == goalNode ? goal : _vertices[node].position;
+        open.emplace(newLength + position.calculateDistance(goal), newSegments, node);
+    };
+
+    for (int v = 0; v < vertexCount; ++v)
+    {
+        const Point2& position = _vertices[v].position;
+        if (isTangent(v, goal) && !isBlocked(position, goal, {}))
+        {
+            goalLinks[v] = position.calculateDistance(goal);
+        }
+        if (isTangent(v, start) && !isBlocked(start, position, ignored))
+        {
+            relax(v, start.calculateDistance(position), 1, startNode);
+        }
+    }
+
+    while (!open.empty())
+    {
+        const auto [estimate, nodeSegments, node] = open.top();
+        open.pop();
+        const Point2& position = node == goalNode ? goal : _vertices[node].position;
+        if (nodeSegments != segments[node] || estimate > length[node] + position.calculateDistance(goal) + TOLERANCE)
+        {
+            continue;
+        }
+
+        // Entries within the tolerance of the goal may still reach it with fewer segments
+        if (node == goalNode || estimate > length[goalNode] + TOLERANCE)
+        {
+            if (length[goalNode] != INF && (open.empty() || std::get<0>(open.top()) > length[goalNode] + TOLERANCE))
+            {
+                break;
+            }
+            continue;
+        }
+
+        if (goalLinks[node] != INF)
+        {
+            relax(goalNode, length[node] + goalLinks[node], segments[node] + 1, node);
+        }
+        for (const Edge& edge : _edges[node])
+        {
+            relax(edge.to, length[node] + edge.length, segments[node] + 1, node);
+        }
+    }
+
+    if (length[goalNode] == INF)
+    {
+        return {};
+    }
+
+    std::vector<Point> waypoints;
+    for (int n = goalNode; n != startNode; n = parent[n])
+    {
+        waypoints.push_back(n == goalNode ? goalPoint : Point(_vertices[n].position));
+    }
+    std::reverse(waypoints.begin(), waypoints.end());
+    return waypoints;
+}
+
+bool VisibilityGraph::isBlocked(const Point& start, const Point& end) const
+{
+    return isBlocked(Point2(start), Point2(end), {});
+}
+
+std::size_t VisibilityGraph::edgeCount() const
+{
+    std::size_t count = 0;
+    for (const auto& edges : _edges)
+    {
+        count += edges.size();
+    }
+    return count / 2;
+}
+
+bool VisibilityGraph::isBlocked(const Point2& start, const Point2& end, const std::vector<int>& ignored) const
+{
+    Broadphase::IdList ids;
+    _tree.querySegment(start, end, ids);
+    for (Broadphase::Id id : ids)
+    {
+        const int obstacle = static_cast<int>(id);
+        if (std::find(ignored.begin(), ignored.end(), obstacle) == ignored.end() && penetrates(start, end, obstacle))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool VisibilityGraph::penetrates(const Point2& start, const Point2& end, int obstacle) const
+{
+    return LinearMath::clipSegment(_obstacles[obstacle], start, end, TOLERANCE).has_value();
+}
+
+bool VisibilityGraph::isInside(const Point2& point, int obstacle) const
+{
+    return LinearMath::containsPoint(_obstacles[obstacle], point, TOLERANCE);
+}
+
+bool VisibilityGraph::isTangent(int vertex, const Point2& other) const
+{
+    const Vertex& v = _vertices[vertex];
+    const auto& obstacle = _obstacles[v.obstacle];
+    const std::size_t count = obstacle.size();
+    if (count < 3)
+    {
+        return true;
+    }
+
+    // The neighbors are taken from the obstacle, they may have been dropped from the graph
+    const Point2& previous = obstacle[(v.index + count - 1) % count];
+    const Point2& next = obstacle[(v.index + 1) % count];
+
+    const double dx = other.getX() - v.position.getX();
+    const double dy = other.getY() - v.position.getY();
+    const double length = std::hypot(dx, dy);
+    if (length == 0.0)
+    {
+        return true;
+    }
+
+    auto side = [&](const Point2& neighbor)
+    {
+        const double ex = neighbor.getX() - v.position.getX();
+        const double ey = neighbor.getY() - v.position.getY();
+        return cross(dx, dy, ex, ey) / (length * std::hypot(ex, ey));
+    };
+    // Both neighbors on the same side of the line, or one of them on it
+    const double previousSide = side(previous);
+    const double nextSide = side(next);
+    return !((previousSide > TOLERANCE && nextSide < -TOLERANCE) || (previousSide < -TOLERANCE && nextSide > TOLERANCE));
+}
@@ -0,0 +1,86 @@
+/**
+ * @file VisibilityGraph.h
+ *
+ * @brief Defines the VisibilityGraph class, the any-angle planner used by PathFinding.
+ */
+
+#ifndef VISIBILITYGRAPH_H
+#define VISIBILITYGRAPH_H
+
+#include <vector>
+#include "aabbtree.h"
+#include "point.h"
+
+/**
+ * @class VisibilityGraph
+ * @brief Shortest polylines among convex configuration space obstacles.
+ *
+ * The obstacles are the shapes of the Scene grown by the moving piece (their Minkowski sum
+ * with the reflected piece), so the piece reduces to its reference point. A shortest path
+ * among polygons bends only at obstacle vertices and each of its segments is tangent to the
+ * obstacles at its ends, so the graph keeps the edges between mutually visible vertices
+ * that satisfy that condition. This static part is built once; a query links the start and
+ * the goal to it and runs A* with the straight-line distance as heuristic, breaking length
+ * ties towards fewer segments.
+ */
+class VisibilityGraph
+{
+public:
+    VisibilityGraph();
+
+    /**
+    * @brief Rebuilds the graph for a new set of obstacles.
+    * @param obstacles Convex obstacles with counterclockwise vertices.
+    */
+    void build(std::vector<std::vector<Point2>> obstacles);
+
+    /**
+    * @brief Searches the shortest polyline from start to goal.
+    *
+    * Obstacles that already contain the start are ignored for the first segment, so a piece
+    * touching a shape can still leave it.
+    *
+    * @return The waypoints after the start, ending with the goal, or an empty vector if the
+    *         goal lies inside an obstacle or cannot be reached.
+    */
+    std::vector<Point> findPath(const Point& start, const Point& goal) const;
+
+    // True if the segment passes through the interior of an obstacle
+    bool isBlocked(const Point& start, const Point& end) const;
+
+    std::size_t vertexCount() const { return _vertices.size(); }
+    std::size_t edgeCount() const;
+    const std::vector<std::vector<Point2>>& obstacles() const { return _obstacles; }
+
+private:
+    struct Vertex
+    {
+        Point2 position;
+        int obstacle;
+        // Position of the vertex within its obstacle
+        int index;
+    };
+
+    struct Edge
+    {
+        int to;
+        double length;
+    };
+
+    // Rejects segments through an obstacle interior, found with a segment query of the
+    // obstacle boxes; obstacles containing the ignored point do not count
+    bool isBlocked(const Point2& start, const Point2& end, const std::vector<int>& ignored) const;
+    // Grazing an edge or a vertex of the obstacle is allowed, any overlap with the interior is not
+    bool penetrates(const Point2& start, const Point2& end, int obstacle) const;
+    bool isInside(const Point2& point, int obstacle) const;
+    // A shortest path can only bend around a vertex it leaves along a tangent of its obstacle
+    bool isTangent(int vertex, const Point2& other) const;
+
+    std::vector<std::vector<Point2>> _obstacles;
+    std::vector<Vertex> _vertices;
+    std::vector<std::vector<Edge>> _edges;
+    AABBTree _tree;
+    static constexpr double TOLERANCE = 1e-7;
+};
+
+#endif // VISIBILITYGRAPH_H